@@ -11,14 +11,28 @@
 
 from pyfwfr.includes.libfwfr cimport *
 
+from cython.operator cimport dereference as deref, preincrement as inc
+from libcpp.memory cimport static_pointer_cast
+
 from pyarrow.compat import frombytes, tobytes
+import os
 from collections.abc import Mapping
 from pyarrow.includes.common cimport CStatus
-from pyarrow.includes.libarrow cimport CDataType, CMemoryPool, CTable, InputStream
+from pyarrow.includes.libarrow cimport (CDataType, CMemoryPool, CRecordBatch,
+                                        CRecordBatchReader, CSchema, CTable,
+                                        InputStream, RandomAccessFile)
 from pyarrow.lib cimport (pyarrow_wrap_data_type, pyarrow_unwrap_data_type, check_status,
-                          pyarrow_wrap_table, get_input_stream, maybe_unbox_memory_pool,
+                          pyarrow_wrap_batch, pyarrow_wrap_schema, pyarrow_wrap_table,
+                          get_input_stream, get_reader, maybe_unbox_memory_pool,
                           ensure_type, Field, MemoryPool)
 
+_priorities = {
+    'high': CFWFPriority_HIGH,
+    'normal': CFWFPriority_NORMAL,
+    'low': CFWFPriority_LOW,
+}
+
+
 cdef class ReadOptions:
     """
     Options for reading fixed-width files.
@@ -34,12 +48,54 @@ cdef class ReadOptions:
         How many bytes to process at a time from the input stream.
         This will determine multi-threading granularity as well as 
         the size of individual chunks in the Table.
+    adaptive_block_size : bool, optional (default False)
+        Whether a threaded read cuts its blocks into chunks sized from the
+        measured time of reading, parsing and converting them, between
+        min_block_size and block_size.
+    min_block_size : int, optional (default 64 KB)
+        Smallest chunk of an adaptive read, unless the input is smaller
+        than one such chunk per worker.
+    output_chunk_rows : int, optional (default 0)
+        Minimum number of rows per chunk of the Table, concatenating the
+        chunks of consecutive blocks once read (0 for one chunk per block).
+    decompress : bool, optional (default True)
+        Whether to detect and decompress gzip and zstd input. BGZF
+        blocks and zstd frames are decompressed in parallel if
+        use_threads is set; other compressed data is decompressed
+        serially.
+    max_parallelism : int, optional (default 0)
+        Maximum number of blocks read ahead, parsed or converted at once
+        if use_threads is set (0 for the thread pool's capacity), to share
+        the CPU between concurrent reads.
+    priority : str, optional (default 'normal')
+        Scheduling class of the read's tasks: 'high', 'normal' or 'low'.
+        Tasks of higher priority reads always run first, while reads of
+        the same priority take turns.
+    max_memory_bytes : int, optional (default 0)
+        Soft cap on the memory held by a threaded read's blocks and
+        parsers, in bytes (0 for no cap). Once reached, no more blocks are
+        read ahead or submitted until tasks in flight release some.
+    max_recycled_bytes : int, optional (default 64 MB)
+        Maximum bytes of freed block, readahead and parser buffers kept
+        for reuse by later blocks of the read (0 to free them at once).
     skip_rows : int, optional (default 0)
         Number of header rows to skip (not including the row of 
         column names, if any).
     column_names : list, optional
         Column names (if empty, will be read from first row after 
         'skip_rows').
+    raw_records : bool, optional (default False)
+        Whether to emit each record whole, as a single fixed_size_binary
+        'record' column sliced from the input without copying, instead
+        of parsing and converting fields. Requires fixed-length records.
+    raw_key_columns : list, optional
+        Columns to also parse and convert in raw record mode.
+    predicates : list, optional
+        Filters a row must all pass to be read, as (column, op, value)
+        tuples. Fields are compared as raw text after whitespace trimming,
+        before conversion. Supported ops: '==', 'in' (list of values),
+        'startswith', and inclusive numeric bounds '>=', '<=' and
+        'between' (a (min, max) tuple).
     """
     cdef:
         CFWFReadOptions options
@@ -48,7 +104,11 @@ cdef class ReadOptions:
     __slots__ = ()
 
     def __init__(self, encoding=None, use_threads=None, block_size=None, 
-                 skip_rows=None, column_names=None):
+                 skip_rows=None, column_names=None, raw_records=None,
+                 raw_key_columns=None, predicates=None, decompress=None,
+                 max_parallelism=None, priority=None, max_memory_bytes=None,
+                 max_recycled_bytes=None, output_chunk_rows=None,
+                 adaptive_block_size=None, min_block_size=None):
         self.options = CFWFReadOptions.Defaults()
         if encoding is not None:
             self.encoding = encoding
@@ -60,6 +120,28 @@ cdef class ReadOptions:
             self.skip_rows = skip_rows
         if column_names is not None:
             self.column_names = column_names
+        if raw_records is not None:
+            self.raw_records = raw_records
+        if raw_key_columns is not None:
+            self.raw_key_columns = raw_key_columns
+        if predicates is not None:
+            self.predicates = predicates
+        if decompress is not None:
+            self.decompress = decompress
+        if max_parallelism is not None:
+            self.max_parallelism = max_parallelism
+        if priority is not None:
+            self.priority = priority
+        if max_memory_bytes is not None:
+            self.max_memory_bytes = max_memory_bytes
+        if max_recycled_bytes is not None:
+            self.max_recycled_bytes = max_recycled_bytes
+        if output_chunk_rows is not None:
+            self.output_chunk_rows = output_chunk_rows
+        if adaptive_block_size is not None:
+            self.adaptive_block_size = adaptive_block_size
+        if min_block_size is not None:
+            self.min_block_size = min_block_size
 
     @property
     def encoding(self):
@@ -97,6 +179,107 @@ cdef class ReadOptions:
     def block_size(self, value):
         self.options.block_size = value
 
+    @property
+    def adaptive_block_size(self):
+        """
+        Whether a threaded read sizes its chunks from measured stage times.
+        """
+        return self.options.adaptive_block_size
+
+    @adaptive_block_size.setter
+    def adaptive_block_size(self, value):
+        self.options.adaptive_block_size = value
+
+    @property
+    def min_block_size(self):
+        """
+        Smallest chunk of an adaptive read.
+        """
+        return self.options.min_block_size
+
+    @min_block_size.setter
+    def min_block_size(self, value):
+        if value <= 0:
+            raise ValueError("min_block_size must be positive")
+        self.options.min_block_size = value
+
+    @property
+    def output_chunk_rows(self):
+        """
+        Minimum number of rows per chunk of the Table (0 for one chunk per
+        block).
+        """
+        return self.options.output_chunk_rows
+
+    @output_chunk_rows.setter
+    def output_chunk_rows(self, value):
+        if value < 0:
+            raise ValueError("output_chunk_rows must be non-negative")
+        self.options.output_chunk_rows = value
+
+    @property
+    def decompress(self):
+        """
+        Whether to detect and decompress gzip and zstd input.
+        """
+        return self.options.decompress
+
+    @decompress.setter
+    def decompress(self, value):
+        self.options.decompress = value
+
+    @property
+    def max_parallelism(self):
+        """
+        Maximum number of blocks processed at once (0 for no limit).
+        """
+        return self.options.max_parallelism
+
+    @max_parallelism.setter
+    def max_parallelism(self, value):
+        if value < 0:
+            raise ValueError("max_parallelism must be non-negative")
+        self.options.max_parallelism = value
+
+    @property
+    def priority(self):
+        """
+        Scheduling class of the read's tasks: 'high', 'normal' or 'low'.
+        """
+        return next(k for k, v in _priorities.items()
+                    if v == self.options.priority)
+
+    @priority.setter
+    def priority(self, value):
+        if value not in _priorities:
+            raise ValueError("Unsupported priority '{}'".format(value))
+        self.options.priority = <CFWFPriority> _priorities[value]
+
+    @property
+    def max_memory_bytes(self):
+        """
+        Soft cap on the memory held by a threaded read (0 for no cap).
+        """
+        return self.options.max_memory_bytes
+
+    @max_memory_bytes.setter
+    def max_memory_bytes(self, value):
+        if value < 0:
+            raise ValueError("max_memory_bytes must be non-negative")
+        self.options.max_memory_bytes = value
+
+    @property
+    def max_recycled_bytes(self):
+        """
+        Maximum bytes of freed buffers kept for reuse (0 to free them).
+        """
+        return self.options.max_recycled_bytes
+
+    @max_recycled_bytes.setter
+    def max_recycled_bytes(self, value):
+        if value < 0:
+            raise ValueError("max_recycled_bytes must be non-negative")
+        self.options.max_recycled_bytes = value
 
     @property
     def skip_rows(self):
@@ -121,6 +304,94 @@ cdef class ReadOptions:
     def column_names(self, value):
         self.options.column_names = [tobytes(x) for x in value]
 
+    @property
+    def raw_records(self):
+        """
+        Whether to emit each record whole, as a single fixed_size_binary
+        'record' column, instead of parsing and converting fields.
+        """
+        return self.options.raw_records
+
+    @raw_records.setter
+    def raw_records(self, value):
+        self.options.raw_records = value
+
+    @property
+    def raw_key_columns(self):
+        """
+        Columns to also parse and convert in raw record mode.
+        """
+        return [frombytes(x) for x in self.options.raw_key_columns]
+
+    @raw_key_columns.setter
+    def raw_key_columns(self, value):
+        self.options.raw_key_columns = [tobytes(x) for x in value]
+
+    @property
+    def predicates(self):
+        """
+        Filters a row must all pass to be read, as (column, op, value)
+        tuples.
+        """
+        return [_wrap_predicate(x) for x in self.options.predicates]
+
+    @predicates.setter
+    def predicates(self, value):
+        cdef vector[CFWFPredicate] predicates
+        for t in value:
+            predicates.push_back(_unwrap_predicate(t))
+        self.options.predicates = predicates
+
+
+cdef _wrap_predicate(CFWFPredicate predicate):
+    column = frombytes(predicate.column)
+    values = [frombytes(x) for x in predicate.values]
+    if predicate.kind == CFWFPredicate_EQUAL:
+        return (column, '==', values[0])
+    elif predicate.kind == CFWFPredicate_IN:
+        return (column, 'in', values)
+    elif predicate.kind == CFWFPredicate_PREFIX:
+        return (column, 'startswith', values[0])
+    elif predicate.min == float('-inf'):
+        return (column, '<=', predicate.max)
+    elif predicate.max == float('inf'):
+        return (column, '>=', predicate.min)
+    return (column, 'between', (predicate.min, predicate.max))
+
+
+cdef CFWFPredicate _unwrap_predicate(t) except *:
+    cdef CFWFPredicate predicate
+    column, op, value = t
+    predicate.column = tobytes(column)
+    if op == '==':
+        predicate.kind = CFWFPredicate_EQUAL
+        predicate.values = [tobytes(value)]
+    elif op == 'in':
+        predicate.kind = CFWFPredicate_IN
+        predicate.values = [tobytes(x) for x in value]
+    elif op == 'startswith':
+        predicate.kind = CFWFPredicate_PREFIX
+        predicate.values = [tobytes(value)]
+    elif op == '>=':
+        predicate.kind = CFWFPredicate_RANGE
+        predicate.min = value
+    elif op == '<=':
+        predicate.kind = CFWFPredicate_RANGE
+        predicate.max = value
+    elif op == 'between':
+        predicate.kind = CFWFPredicate_RANGE
+        predicate.min, predicate.max = value
+    else:
+        raise ValueError("Unsupported predicate op '{}'".format(op))
+    return predicate
+
+
+_record_formats = {
+    'lines': CFWFRecordFormat_LINES,
+    'rdw': CFWFRecordFormat_RDW,
+    'bdw': CFWFRecordFormat_BDW,
+}
+
 
 cdef class ParseOptions:
     """
@@ -132,6 +403,17 @@ cdef class ParseOptions:
         The number of bytes in each field in a column of FWF data.
     ignore_empty_lines : bool, optional (default True)
         Whether empty lines are ignored in FWF input.
+    layouts : list, optional
+        RecordLayouts of a file mixing record types, read with
+        read_fwf_layouts (field_widths and skip_columns are then unused).
+    type_code_offset : int, optional (default 0)
+        Byte offset of the record type code within each record.
+    record_format : str, optional (default 'lines')
+        How records are delimited: 'lines' (line separators), 'rdw'
+        (4-byte record descriptor words, RECFM=V) or 'bdw' (blocks of RDW
+        records with 4-byte block descriptor words, RECFM=VB). Records
+        shorter than the field widths are padded with spaces, and
+        ReadOptions.column_names must be set as there is no header row.
     """
     cdef:
         CFWFParseOptions options
@@ -140,13 +422,20 @@ cdef class ParseOptions:
     __slots__ = ()
 
     def __init__(self, field_widths, ignore_empty_lines=None, 
-                 skip_columns=None):
+                 skip_columns=None, layouts=None, type_code_offset=None,
+                 record_format=None):
         self.options = CFWFParseOptions.Defaults()
         self.field_widths = field_widths
         if ignore_empty_lines is not None:
             self.ignore_empty_lines = ignore_empty_lines
         if skip_columns is not None:
             self.skip_columns = skip_columns
+        if layouts is not None:
+            self.layouts = layouts
+        if type_code_offset is not None:
+            self.type_code_offset = type_code_offset
+        if record_format is not None:
+            self.record_format = record_format
 
     @property
     def field_widths(self):
@@ -181,6 +470,318 @@ cdef class ParseOptions:
     def skip_columns(self, value):
         self.options.skip_columns = value
 
+    @property
+    def layouts(self):
+        """
+        RecordLayouts of a file mixing record types.
+        """
+        return [_wrap_record_layout(x) for x in self.options.layouts]
+
+    @layouts.setter
+    def layouts(self, value):
+        cdef:
+            vector[CFWFRecordLayout] layouts
+            RecordLayout layout
+        for layout in value:
+            layouts.push_back(layout.layout)
+        self.options.layouts = layouts
+
+    @property
+    def type_code_offset(self):
+        """
+        Byte offset of the record type code within each record.
+        """
+        return self.options.type_code_offset
+
+    @type_code_offset.setter
+    def type_code_offset(self, value):
+        self.options.type_code_offset = value
+
+    @property
+    def record_format(self):
+        """
+        How records are delimited: 'lines', 'rdw' or 'bdw'.
+        """
+        return next(k for k, v in _record_formats.items()
+                    if v == self.options.record_format)
+
+    @record_format.setter
+    def record_format(self, value):
+        if value not in _record_formats:
+            raise ValueError("Unsupported record format '{}'".format(value))
+        self.options.record_format = <CFWFRecordFormat> _record_formats[value]
+
+
+cdef class RecordLayout:
+    """
+    The layout of one record type, in a file mixing several.
+
+    Parameters
+    ----------
+    type_code : string, required
+        Record type code selecting this layout, found at
+        ParseOptions.type_code_offset in each record.
+    field_widths : int list, required
+        The number of bytes in each field of this record type.
+    column_names : list, required
+        Names of the columns read (not skipped).
+    skip_columns : int list, optional (default empty)
+        Indices of fields to skip on read-in.
+    """
+    cdef:
+        CFWFRecordLayout layout
+
+    # Avoid mistakenly creating new attributes
+    __slots__ = ()
+
+    def __init__(self, type_code, field_widths, column_names,
+                 skip_columns=None):
+        self.type_code = type_code
+        self.field_widths = field_widths
+        self.column_names = column_names
+        if skip_columns is not None:
+            self.skip_columns = skip_columns
+
+    @property
+    def type_code(self):
+        """
+        Record type code selecting this layout.
+        """
+        return frombytes(self.layout.type_code)
+
+    @type_code.setter
+    def type_code(self, value):
+        self.layout.type_code = tobytes(value)
+
+    @property
+    def field_widths(self):
+        """
+        The number of bytes in each field of this record type.
+        """
+        return self.layout.field_widths
+
+    @field_widths.setter
+    def field_widths(self, value):
+        self.layout.field_widths = value
+
+    @property
+    def column_names(self):
+        """
+        Names of the columns read (not skipped).
+        """
+        return [frombytes(x) for x in self.layout.column_names]
+
+    @column_names.setter
+    def column_names(self, value):
+        self.layout.column_names = [tobytes(x) for x in value]
+
+    @property
+    def skip_columns(self):
+        """
+        Indices of fields to skip on read-in.
+        """
+        return self.layout.skip_columns
+
+    @skip_columns.setter
+    def skip_columns(self, value):
+        self.layout.skip_columns = value
+
+
+cdef _wrap_record_layout(CFWFRecordLayout layout):
+    cdef RecordLayout out = RecordLayout.__new__(RecordLayout)
+    out.layout = layout
+    return out
+
+_numeric_encodings = {
+    'text': CFWFNumericEncoding_TEXT,
+    'zoned': CFWFNumericEncoding_ZONED,
+    'binary': CFWFNumericEncoding_BINARY,
+    'packed': CFWFNumericEncoding_PACKED,
+}
+
+_numeric_signs = {
+    'unsigned': CFWFNumericSign_UNSIGNED,
+    'trailing': CFWFNumericSign_TRAILING,
+    'leading': CFWFNumericSign_LEADING,
+    'trailing_separate': CFWFNumericSign_TRAILING_SEPARATE,
+    'leading_separate': CFWFNumericSign_LEADING_SEPARATE,
+}
+
+
+cdef _wrap_numeric_encoding(CFWFNumericEncoding encoding):
+    return next(k for k, v in _numeric_encodings.items() if v == encoding)
+
+
+cdef CFWFNumericEncoding _unwrap_numeric_encoding(value) except *:
+    if value not in _numeric_encodings:
+        raise ValueError("Unsupported numeric encoding '{}'".format(value))
+    return <CFWFNumericEncoding> _numeric_encodings[value]
+
+
+cdef _wrap_numeric_sign(CFWFNumericSign sign):
+    return next(k for k, v in _numeric_signs.items() if v == sign)
+
+
+cdef CFWFNumericSign _unwrap_numeric_sign(value) except *:
+    if value not in _numeric_signs:
+        raise ValueError("Unsupported numeric sign '{}'".format(value))
+    return <CFWFNumericSign> _numeric_signs[value]
+
+
+cdef class ColumnConvertOptions:
+    """
+    Conversion options for a single column, replacing the corresponding
+    ConvertOptions settings for that column.
+
+    Parameters
+    ----------
+    is_cobol : bool, optional (default False)
+        Whether to check for and handle COBOL-formatted numeric data.
+    null_values : list, optional (default empty)
+        A sequence of strings that denote nulls in the column. If empty,
+        null detection is skipped entirely.
+    true_values : list, optional
+        A sequence of strings that denote true booleans in the column
+        (defaults are appropriate in most cases).
+    false_values : list, optional
+        A sequence of strings that denote false booleans in the column
+        (defaults are appropriate in most cases).
+    implied_decimals : int, optional (default 0)
+        Number of implied decimal places in float/double values written
+        without a decimal point.
+    strings_can_be_null : bool, optional (default False)
+        Whether a string/binary column can have null values.
+    numeric_encoding : str, optional (default 'text')
+        Encoding of numeric values: 'text', 'zoned' (COBOL DISPLAY),
+        'binary' (COMP) or 'packed' (COMP-3). Encoded values are decoded
+        from their raw bytes, then scaled by implied_decimals.
+    numeric_sign : str, optional (default 'trailing')
+        Sign of encoded numeric values: 'unsigned', 'trailing', 'leading',
+        'trailing_separate' or 'leading_separate'.
+    """
+    cdef:
+        CFWFColumnConvertOptions options
+
+    # Avoid mistakenly creating attributes
+    __slots__ = ()
+
+    def __init__(self, is_cobol=None, null_values=None, true_values=None,
+                 false_values=None, implied_decimals=None,
+                 strings_can_be_null=None, numeric_encoding=None,
+                 numeric_sign=None):
+        self.options = CFWFColumnConvertOptions.Defaults()
+        if is_cobol is not None:
+            self.is_cobol = is_cobol
+        if null_values is not None:
+            self.null_values = null_values
+        if true_values is not None:
+            self.true_values = true_values
+        if false_values is not None:
+            self.false_values = false_values
+        if implied_decimals is not None:
+            self.implied_decimals = implied_decimals
+        if strings_can_be_null is not None:
+            self.strings_can_be_null = strings_can_be_null
+        if numeric_encoding is not None:
+            self.numeric_encoding = numeric_encoding
+        if numeric_sign is not None:
+            self.numeric_sign = numeric_sign
+
+    @property
+    def is_cobol(self):
+        """
+        Whether to check for COBOL formatted numeric types.
+        """
+        return self.options.is_cobol
+
+    @is_cobol.setter
+    def is_cobol(self, value):
+        self.options.is_cobol = value
+
+    @property
+    def null_values(self):
+        """
+        A sequence of strings that denote nulls in the column.
+        """
+        return [frombytes(x) for x in self.options.null_values]
+
+    @null_values.setter
+    def null_values(self, value):
+        self.options.null_values = [tobytes(x) for x in value]
+
+    @property
+    def true_values(self):
+        """
+        A sequence of strings that denote true booleans in the column.
+        """
+        return [frombytes(x) for x in self.options.true_values]
+
+    @true_values.setter
+    def true_values(self, value):
+        self.options.true_values = [tobytes(x) for x in value]
+
+    @property
+    def false_values(self):
+        """
+        A sequence of strings that denote false booleans in the column.
+        """
+        return [frombytes(x) for x in self.options.false_values]
+
+    @false_values.setter
+    def false_values(self, value):
+        self.options.false_values = [tobytes(x) for x in value]
+
+    @property
+    def implied_decimals(self):
+        """
+        Number of implied decimal places in float/double values.
+        """
+        return self.options.implied_decimals
+
+    @implied_decimals.setter
+    def implied_decimals(self, value):
+        self.options.implied_decimals = value
+
+    @property
+    def strings_can_be_null(self):
+        """
+        Whether a string/binary column can have null values.
+        """
+        return self.options.strings_can_be_null
+
+    @strings_can_be_null.setter
+    def strings_can_be_null(self, value):
+        self.options.strings_can_be_null = value
+
+    @property
+    def numeric_encoding(self):
+        """
+        Encoding of numeric values.
+        """
+        return _wrap_numeric_encoding(self.options.numeric_format.encoding)
+
+    @numeric_encoding.setter
+    def numeric_encoding(self, value):
+        self.options.numeric_format.encoding = _unwrap_numeric_encoding(value)
+
+    @property
+    def numeric_sign(self):
+        """
+        Sign of encoded numeric values.
+        """
+        return _wrap_numeric_sign(self.options.numeric_format.sign)
+
+    @numeric_sign.setter
+    def numeric_sign(self, value):
+        self.options.numeric_format.sign = _unwrap_numeric_sign(value)
+
+
+cdef _wrap_column_convert_options(CFWFColumnConvertOptions options):
+    cdef ColumnConvertOptions out = ColumnConvertOptions.__new__(ColumnConvertOptions)
+    out.options = options
+    return out
+
+
 cdef class ConvertOptions:
     """
     Options for converting fixed-width file data.
@@ -190,6 +791,8 @@ cdef class ConvertOptions:
     column_types : dict, optional
         Map column names to column types
         (disables type inferencing on those columns).
+        A fixed size list type splits each field into that many values of
+        equal width, decoded in one pass into a single column.
     is_cobol : bool, optional (deafult False)
         Whether to check for and handle COBOL-formatted numeric data.
     pos_values : dict, optional
@@ -209,11 +812,38 @@ cdef class ConvertOptions:
     false_values : list, optional
         A sequence of strings that denote false booleans in the data
         (defaults are appropriate in most cases).
+    implied_decimals : int, optional (default 0)
+        Number of implied decimal places in float/double values written
+        without a decimal point.
+            ex. '12345' with 2 implied decimals --> 123.45
     strings_can_be_null : bool, optional (default False)
         Whether string / binary columns can have null values.
         If true, then strings in null_values are considered null for
         string columns.
         If false, then all strings are valid string values.
+    numeric_encoding : str, optional (default 'text')
+        Encoding of numeric values: 'text', 'zoned' (COBOL DISPLAY),
+        'binary' (COMP) or 'packed' (COMP-3). Encoded values are decoded
+        from their raw bytes, then scaled by implied_decimals. Binary and
+        packed values cannot be read with ReadOptions.encoding set.
+    numeric_sign : str, optional (default 'trailing')
+        Sign of encoded numeric values: 'unsigned', 'trailing', 'leading',
+        'trailing_separate' or 'leading_separate'.
+    inference_blocks : int, optional (default 0)
+        Number of blocks an inferred column type must hold for to be
+        locked (0 to never lock it early). Locked columns stop keeping
+        their parsed blocks for reconversion, and values not fitting the
+        type are errors. Text columns are always locked.
+    inference_spill_directory : str, optional
+        Directory where the parsed blocks kept for type inference are
+        spilled, to be read back only when reconverted.
+    large_strings : bool, optional (default False)
+        Whether inferred string / binary columns are large_string /
+        large_binary, with 64-bit offsets (requires Arrow 0.15 or later).
+    column_options : dict, optional
+        Map column names (str) or indices (int) to ColumnConvertOptions
+        replacing the settings above for those columns. Indices count the
+        columns read, skipped columns excluded.
     """
     cdef:
         CFWFConvertOptions options
@@ -223,7 +853,11 @@ cdef class ConvertOptions:
 
     def __init__(self, column_types=None, is_cobol=None, pos_values=None,
                  neg_values=None, null_values=None, true_values=None, 
-                 false_values=None, strings_can_be_null=None):
+                 false_values=None, implied_decimals=None,
+                 strings_can_be_null=None, column_options=None,
+                 numeric_encoding=None, numeric_sign=None,
+                 inference_blocks=None, inference_spill_directory=None,
+                 large_strings=None):
         self.options = CFWFConvertOptions.Defaults()
         if column_types is not None:
             self.column_types = column_types
@@ -239,8 +873,22 @@ cdef class ConvertOptions:
             self.true_values = true_values
         if false_values is not None:
             self.false_values = false_values
+        if implied_decimals is not None:
+            self.implied_decimals = implied_decimals
         if strings_can_be_null is not None:
             self.strings_can_be_null = strings_can_be_null
+        if numeric_encoding is not None:
+            self.numeric_encoding = numeric_encoding
+        if numeric_sign is not None:
+            self.numeric_sign = numeric_sign
+        if inference_blocks is not None:
+            self.inference_blocks = inference_blocks
+        if inference_spill_directory is not None:
+            self.inference_spill_directory = inference_spill_directory
+        if large_strings is not None:
+            self.large_strings = large_strings
+        if column_options is not None:
+            self.column_options = column_options
 
     @property
     def column_types(self):
@@ -351,6 +999,18 @@ cdef class ConvertOptions:
     def false_values(self, value):
         self.options.false_values = [tobytes(x) for x in value]
 
+    @property
+    def implied_decimals(self):
+        """
+        Number of implied decimal places in float/double values written
+        without a decimal point.
+        """
+        return self.options.implied_decimals
+
+    @implied_decimals.setter
+    def implied_decimals(self, value):
+        self.options.implied_decimals = value
+
     @property
     def strings_can_be_null(self):
         """
@@ -362,10 +1022,106 @@ cdef class ConvertOptions:
     def strings_can_be_null(self, value):
         self.options.strings_can_be_null = value
 
+    @property
+    def numeric_encoding(self):
+        """
+        Encoding of numeric values.
+        """
+        return _wrap_numeric_encoding(self.options.numeric_format.encoding)
+
+    @numeric_encoding.setter
+    def numeric_encoding(self, value):
+        self.options.numeric_format.encoding = _unwrap_numeric_encoding(value)
+
+    @property
+    def numeric_sign(self):
+        """
+        Sign of encoded numeric values.
+        """
+        return _wrap_numeric_sign(self.options.numeric_format.sign)
+
+    @numeric_sign.setter
+    def numeric_sign(self, value):
+        self.options.numeric_format.sign = _unwrap_numeric_sign(value)
+
+    @property
+    def inference_blocks(self):
+        """
+        Number of blocks an inferred column type must hold for to be locked
+        (0 to never lock it early).
+        """
+        return self.options.inference_blocks
+
+    @inference_blocks.setter
+    def inference_blocks(self, value):
+        if value < 0:
+            raise ValueError("inference_blocks must be non-negative")
+        self.options.inference_blocks = value
+
+    @property
+    def inference_spill_directory(self):
+        """
+        Directory where the parsed blocks kept for type inference are
+        spilled (empty to keep them in memory).
+        """
+        return frombytes(self.options.inference_spill_directory)
+
+    @inference_spill_directory.setter
+    def inference_spill_directory(self, value):
+        self.options.inference_spill_directory = tobytes(value)
+
+    @property
+    def large_strings(self):
+        """
+        Whether inferred string / binary columns have 64-bit offsets.
+        """
+        return self.options.large_strings
+
+    @large_strings.setter
+    def large_strings(self, value):
+        self.options.large_strings = value
 
-cdef _get_reader(input_file, shared_ptr[InputStream]* out):
+    @property
+    def column_options(self):
+        """
+        Map column names or indices to per-column conversion options.
+        """
+        d = {frombytes(item.first): _wrap_column_convert_options(item.second)
+             for item in self.options.column_options}
+        d.update({item.first: _wrap_column_convert_options(item.second)
+                  for item in self.options.column_index_options})
+        return d
+
+    @column_options.setter
+    def column_options(self, value):
+        cdef ColumnConvertOptions opts
+
+        self.options.column_options.clear()
+        self.options.column_index_options.clear()
+        for k, opts in value.items():
+            if isinstance(k, int):
+                self.options.column_index_options[k] = opts.options
+            else:
+                self.options.column_options[tobytes(k)] = opts.options
+
+
+# Extensions of compressed files left for fwfr to decompress
+_compressed_extensions = ('.gz', '.bgz', '.zst')
+
+
+cdef _get_reader(input_file, ReadOptions read_options,
+                 shared_ptr[InputStream]* out):
+    cdef shared_ptr[RandomAccessFile] reader
     use_memory_map = False
-    get_input_stream(input_file, use_memory_map, out)
+    decompress = read_options is None or read_options.decompress
+    is_path = isinstance(input_file, str) or hasattr(input_file, '__fspath__')
+    if (decompress and is_path and
+            str(input_file).endswith(_compressed_extensions)):
+        # Read the file as is, to decompress it in parallel when possible
+        get_reader(input_file, use_memory_map, &reader)
+        out[0] = static_pointer_cast[InputStream, RandomAccessFile](reader)
+    else:
+        get_input_stream(input_file, use_memory_map, out)
 
 
 cdef _get_read_options(ReadOptions read_options, CFWFReadOptions* out):
@@ -388,8 +1144,165 @@ cdef _get_convert_options(ConvertOptions convert_options, CFWFConvertOptions* ou
         out[0] = convert_options.options
 
 
+cdef class LazyTable:
+    """
+    A parsed FWF table whose columns are converted on first access.
+    Create with read_fwf_lazy().
+    """
+    cdef:
+        shared_ptr[CFWFLazyTable] table
+
+    def __init__(self):
+        raise TypeError("Use read_fwf_lazy() to create a LazyTable")
+
+    @staticmethod
+    cdef wrap(shared_ptr[CFWFLazyTable] table):
+        cdef LazyTable self = LazyTable.__new__(LazyTable)
+        self.table = table
+        return self
+
+    @property
+    def num_columns(self):
+        """
+        Number of columns.
+        """
+        return self.table.get().num_columns()
+
+    @property
+    def num_rows(self):
+        """
+        Number of rows.
+        """
+        return self.table.get().num_rows()
+
+    @property
+    def column_names(self):
+        """
+        Names of the columns.
+        """
+        return [frombytes(x) for x in self.table.get().column_names()]
+
+    @property
+    def column_types(self):
+        """
+        Types of the columns, as a dict by name. Inferred columns which
+        were not converted yet have type None.
+        """
+        cdef shared_ptr[CDataType] c_type
+        d = {}
+        for i, name in enumerate(self.column_names):
+            c_type = self.table.get().column_type(i)
+            d[name] = (pyarrow_wrap_data_type(c_type)
+                       if c_type.get() != NULL else None)
+        return d
+
+    def select(self, names):
+        """
+        Return a Table of the named columns, converting them if needed.
+        """
+        cdef:
+            vector[c_string] c_names = [tobytes(x) for x in names]
+            shared_ptr[CTable] table
+        with nogil:
+            check_status(self.table.get().Select(c_names, &table))
+        return pyarrow_wrap_table(table)
+
+    def column(self, name):
+        """
+        Return the named column, converting it if needed.
+        """
+        return self.select([name]).column(0)
+
+    def to_table(self):
+        """
+        Return a Table of all columns, converting them if needed.
+        """
+        cdef shared_ptr[CTable] table
+        with nogil:
+            check_status(self.table.get().ToTable(&table))
+        return pyarrow_wrap_table(table)
+
+
+cdef class RecordBatchStream:
+    """
+    The record batches of a FWF file, one per block, converted ahead of
+    the consumer. Create with read_fwf_stream().
+    """
+    cdef:
+        shared_ptr[CRecordBatchReader] reader
+
+    def __init__(self):
+        raise TypeError("Use read_fwf_stream() to create a RecordBatchStream")
+
+    @staticmethod
+    cdef wrap(shared_ptr[CRecordBatchReader] reader):
+        cdef RecordBatchStream self = RecordBatchStream.__new__(RecordBatchStream)
+        self.reader = reader
+        return self
+
+    @property
+    def schema(self):
+        """
+        Schema of the batches.
+        """
+        return pyarrow_wrap_schema(self.reader.get().schema())
+
+    def read_next_batch(self):
+        """
+        Return the next RecordBatch, or None at the end of the data.
+        """
+        cdef shared_ptr[CRecordBatch] batch
+        with nogil:
+            check_status(self.reader.get().ReadNext(&batch))
+        if batch.get() == NULL:
+            return None
+        return pyarrow_wrap_batch(batch)
+
+    def __iter__(self):
+        while True:
+            batch = self.read_next_batch()
+            if batch is None:
+                return
+            yield batch
+
+
+cdef _make_fwf_reader(input_file, parse_options, read_options,
+                      convert_options, MemoryPool memory_pool,
+                      shared_ptr[CFWFReader]* out):
+    cdef:
+        shared_ptr[InputStream] stream
+        CFWFReadOptions c_read_options
+        CFWFParseOptions c_parse_options
+        CFWFConvertOptions c_convert_options
+
+    _get_reader(input_file, read_options, &stream)
+    _get_read_options(read_options, &c_read_options)
+    _get_parse_options(parse_options, &c_parse_options)
+    _get_convert_options(convert_options, &c_convert_options)
+
+    check_status(CFWFReader.Make(maybe_unbox_memory_pool(memory_pool),
+                                 stream, c_read_options, c_parse_options,
+                                 c_convert_options, out))
+
+
+cdef _wrap_stage_memory_stats(const CFWFStageMemoryStats& stats):
+    return {'bytes_allocated': stats.bytes_allocated,
+            'max_memory': stats.max_memory}
+
+
+cdef _wrap_memory_stats(const CFWFReadMemoryStats& stats):
+    return {'readahead': _wrap_stage_memory_stats(stats.readahead),
+            'parse': _wrap_stage_memory_stats(stats.parse),
+            'convert': _wrap_stage_memory_stats(stats.convert),
+            'output': _wrap_stage_memory_stats(stats.output),
+            'budget': _wrap_stage_memory_stats(stats.budget),
+            'recycled': _wrap_stage_memory_stats(stats.recycled),
+            'reused_bytes': stats.reused_bytes}
+
+
 def read_fwf(input_file, parse_options, read_options=None,
-             convert_options=None, MemoryPool memory_pool=None):
+             convert_options=None, MemoryPool memory_pool=None,
+             memory_stats=None):
     """
     Read a Table from a stream of fixed_width data.
     Must set parse_options.field_widths!
@@ -399,7 +1312,10 @@ def read_fwf(input_file, parse_options, read_options=None,
     input_file : string, path or file-like object
         The location of the FWF data. If a string or path, and if it ends
         with a recognized compressed file extension (e.g. ".gz" or ".bz2"),
-        the data is automatically decompressed when reading.
+        the data is automatically decompressed when reading. gzip and
+        zstd data is also detected from its content, and BGZF blocks and
+        zstd frames are decompressed in parallel (see
+        ReadOptions.decompress).
     parse_options : fwfr.ParseOptions, required
         Options for the FWF parser
         (see fwfr.ParseOptions for more details).
@@ -411,6 +1327,12 @@ def read_fwf(input_file, parse_options, read_options=None,
         (see fwfr.ConvertOptions for more details).
     memory_pool : MemoryPool, optional
         Pool to allocate Table memory from.
+    memory_stats : dict, optional
+        Filled with the bytes held by each stage of the read ('readahead',
+        'parse', 'convert', 'output' and 'budget') and of the freed buffers
+        kept for reuse ('recycled'), as dicts of 'bytes_allocated' and
+        'max_memory' (the peak), and with the bytes of the allocations
+        served from recycled buffers ('reused_bytes').
 
     Returns
     -------
@@ -418,22 +1340,321 @@ def read_fwf(input_file, parse_options, read_options=None,
         Contents of the FWF file as an in-memory table.
     """
     cdef:
-        shared_ptr[InputStream] stream
+        shared_ptr[CFWFReader] reader
+        shared_ptr[CTable] table
+
+    _make_fwf_reader(input_file, parse_options, read_options,
+                     convert_options, memory_pool, &reader)
+    with nogil:
+        check_status(reader.get().Read(&table))
+
+    if memory_stats is not None:
+        memory_stats.update(_wrap_memory_stats(reader.get().memory_stats()))
+    return pyarrow_wrap_table(table)
+
+
+def read_fwf_cached(input_file, parse_options, cache_dir, read_options=None,
+                    convert_options=None, hash_contents=False,
+                    MemoryPool memory_pool=None):
+    """
+    Read a Table from a fixed_width file, through a cache of previous
+    results. Tables are cached as Arrow IPC files in cache_dir, keyed by
+    the file's path, size and modification time and by every option; on
+    a hit, the cached file is memory-mapped instead of parsing the FWF
+    file, and on a miss the table read is written to the cache. The cache
+    is best-effort: an unreadable entry is dropped and the file read
+    again, and a table that cannot be cached is still returned.
+
+    Parameters
+    ----------
+    input_file : string or path
+        The location of the FWF file. Compressed data is only decompressed
+        if detected by ReadOptions.decompress.
+    parse_options : fwfr.ParseOptions, required
+        Options for the FWF parser
+        (see fwfr.ParseOptions for more details).
+    cache_dir : string or path
+        Directory holding the cached tables; tables are only cached if it
+        exists and is writable.
+    read_options : fwfr.ReadOptions, optional
+        Options for the FWF reader
+        (see fwfr.ReadOptions for more details).
+    convert_options : fwfr.ConvertOptions, optional
+        Options for the FWF converter
+        (see fwfr.ConvertOptions for more details).
+    hash_contents : bool, optional (default False)
+        Whether to also key the cache by a hash of the file contents,
+        rather than trusting its size and modification time alone.
+    memory_pool : MemoryPool, optional
+        Pool to allocate Table memory from on a miss.
+
+    Returns
+    -------
+    :class:`pyarrow.Table`
+        Contents of the FWF file.
+    """
+    cdef:
+        c_string c_path = tobytes(os.fspath(input_file))
         CFWFReadOptions c_read_options
         CFWFParseOptions c_parse_options
         CFWFConvertOptions c_convert_options
-        shared_ptr[CFWFReader] reader
+        CFWFCacheOptions c_cache_options = CFWFCacheOptions.Defaults()
+        CMemoryPool* pool = maybe_unbox_memory_pool(memory_pool)
         shared_ptr[CTable] table
 
-    _get_reader(input_file, &stream)
     _get_read_options(read_options, &c_read_options)
     _get_parse_options(parse_options, &c_parse_options)
     _get_convert_options(convert_options, &c_convert_options)
+    c_cache_options.directory = tobytes(os.fspath(cache_dir))
+    c_cache_options.hash_contents = hash_contents
 
-    check_status(CFWFReader.Make(maybe_unbox_memory_pool(memory_pool),
-                                 stream, c_read_options, c_parse_options,
-                                 c_convert_options, &reader))
     with nogil:
-        check_status(reader.get().Read(&table))
+        check_status(ReadCachedTable(pool, c_path, c_read_options,
+                                     c_parse_options, c_convert_options,
+                                     c_cache_options, &table))
 
     return pyarrow_wrap_table(table)
+
+
+def read_fwf_dataset(input_files, parse_options, read_options=None,
+                     convert_options=None, per_file=False,
+                     MemoryPool memory_pool=None):
+    """
+    Read many fixed_width files of the same layout as one dataset. The
+    files share one pool of conversion tasks and one schema, with types
+    inferred over all files, and the next file is read while the last
+    blocks of the previous one convert, keeping all cores busy across file
+    boundaries. Each file has its own header (unless
+    read_options.column_names is set), and all must have the same column
+    names.
+
+    Parameters
+    ----------
+    input_files : list of strings or paths
+        The locations of the FWF files, in order.
+    parse_options : fwfr.ParseOptions, required
+        Options for the FWF parser
+        (see fwfr.ParseOptions for more details).
+    read_options : fwfr.ReadOptions, optional
+        Options for the FWF reader
+        (see fwfr.ReadOptions for more details).
+    convert_options : fwfr.ConvertOptions, optional
+        Options for the FWF converter
+        (see fwfr.ConvertOptions for more details).
+    per_file : bool, optional (default False)
+        Whether to return a Table per file, rather than one for all.
+    memory_pool : MemoryPool, optional
+        Pool to allocate Table memory from.
+
+    Returns
+    -------
+    :class:`pyarrow.Table`, or list of :class:`pyarrow.Table`
+        Contents of the FWF files.
+    """
+    cdef:
+        vector[c_string] c_paths
+        CFWFReadOptions c_read_options
+        CFWFParseOptions c_parse_options
+        CFWFConvertOptions c_convert_options
+        shared_ptr[CFWFDatasetReader] reader
+        shared_ptr[CTable] table
+        vector[shared_ptr[CTable]] tables
+
+    for input_file in input_files:
+        c_paths.push_back(tobytes(os.fspath(input_file)))
+    _get_read_options(read_options, &c_read_options)
+    _get_parse_options(parse_options, &c_parse_options)
+    _get_convert_options(convert_options, &c_convert_options)
+
+    check_status(CFWFDatasetReader.Make(maybe_unbox_memory_pool(memory_pool),
+                                        c_paths, c_read_options,
+                                        c_parse_options, c_convert_options,
+                                        &reader))
+    if per_file:
+        with nogil:
+            check_status(reader.get().ReadPerFile(&tables))
+        return [pyarrow_wrap_table(t) for t in tables]
+
+    with nogil:
+        check_status(reader.get().Read(&table))
+    return pyarrow_wrap_table(table)
+
+
+def read_fwf_layouts(input_file, parse_options, read_options=None,
+                     convert_options=None, MemoryPool memory_pool=None):
+    """
+    Read a stream of fixed_width data mixing the record types of
+    parse_options.layouts, in a single pass. Parameters are as in read_fwf.
+
+    Returns
+    -------
+    dict
+        A :class:`pyarrow.Table` per record type code.
+    """
+    cdef:
+        shared_ptr[CFWFReader] reader
+        unordered_map[c_string, shared_ptr[CTable]] tables
+        unordered_map[c_string, shared_ptr[CTable]].iterator it
+
+    _make_fwf_reader(input_file, parse_options, read_options,
+                     convert_options, memory_pool, &reader)
+    with nogil:
+        check_status(reader.get().ReadLayouts(&tables))
+
+    result = {}
+    it = tables.begin()
+    while it != tables.end():
+        result[frombytes(deref(it).first)] = pyarrow_wrap_table(deref(it).second)
+        inc(it)
+    return result
+
+
+def read_fwf_lazy(input_file, parse_options, read_options=None,
+                  convert_options=None, MemoryPool memory_pool=None):
+    """
+    Parse a stream of fixed_width data, deferring the conversion of each
+    column until it is first accessed. Parameters are as in read_fwf.
+
+    Returns
+    -------
+    :class:`fwfr.LazyTable`
+        Parsed contents of the FWF file.
+    """
+    cdef:
+        shared_ptr[CFWFReader] reader
+        shared_ptr[CFWFLazyTable] table
+
+    _make_fwf_reader(input_file, parse_options, read_options,
+                     convert_options, memory_pool, &reader)
+    with nogil:
+        check_status(reader.get().ReadLazy(&table))
+
+    return LazyTable.wrap(table)
+
+
+def read_fwf_stream(input_file, parse_options, read_options=None,
+                    convert_options=None, MemoryPool memory_pool=None):
+    """
+    Read a stream of fixed_width data as record batches, one per block.
+    Blocks are parsed and converted ahead of the consumer on the thread
+    pool, a bounded number at a time, so memory use does not grow with the
+    input. Columns without a declared type get the type inferred from the
+    first block (string if it only holds nulls), and later blocks must
+    convert to it. Parameters are as in read_fwf.
+
+    Returns
+    -------
+    :class:`fwfr.RecordBatchStream`
+        Iterable of the RecordBatches of the FWF file.
+    """
+    cdef:
+        shared_ptr[CFWFReader] reader
+        shared_ptr[CRecordBatchReader] stream
+
+    _make_fwf_reader(input_file, parse_options, read_options,
+                     convert_options, memory_pool, &reader)
+    with nogil:
+        check_status(reader.get().ReadStream(&stream))
+
+    return RecordBatchStream.wrap(stream)
+
+
+cdef class Copybook:
+    """
+    A COBOL copybook compiled into fwfr options. Create with
+    compile_copybook().
+    """
+    cdef:
+        CFWFCopybook copybook
+
+    def __init__(self):
+        raise TypeError("Do not call Copybook's constructor directly, "
+                        "use fwfr.compile_copybook() instead.")
+
+    @property
+    def parse_options(self):
+        """
+        ParseOptions with the field widths, skipping FILLER fields.
+        """
+        cdef ParseOptions out = ParseOptions.__new__(ParseOptions)
+        out.options = self.copybook.parse_options
+        return out
+
+    @property
+    def convert_options(self):
+        """
+        ConvertOptions declaring each column's type and numeric format.
+        """
+        cdef ConvertOptions out = ConvertOptions.__new__(ConvertOptions)
+        out.options = self.copybook.convert_options
+        return out
+
+    @property
+    def column_names(self):
+        """
+        Names of the columns read, for ReadOptions.column_names.
+        """
+        return [frombytes(x) for x in self.copybook.column_names]
+
+    @property
+    def schema(self):
+        """
+        Schema of the tables read.
+        """
+        return pyarrow_wrap_schema(self.copybook.schema)
+
+
+def compile_copybook(source):
+    """
+    Compile a COBOL copybook's record description into fwfr options.
+
+    Supports PICTURE, USAGE (DISPLAY, COMP / BINARY, COMP-3), SIGN,
+    OCCURS, REDEFINES (the first definition is read) and FILLER, in fixed
+    or free source format. Records with binary fields must not be
+    newline-terminated.
+
+    Parameters
+    ----------
+    source : string
+        Text of the copybook.
+
+    Returns
+    -------
+    :class:`fwfr.Copybook`
+        Options to read the described records with, e.g.
+        read_fwf(path, copybook.parse_options,
+                 ReadOptions(column_names=copybook.column_names),
+                 copybook.convert_options).
+    """
+    cdef:
+        c_string c_source = tobytes(source)
+        Copybook out = Copybook.__new__(Copybook)
+
+    with nogil:
+        check_status(CompileCopybook(c_source, &out.copybook))
+    return out
+
+
+def get_scheduler_stats():
+    """
+    Return the load of every threaded read with tasks queued or running on
+    the default thread pool, as dicts of 'id' (in the order reads were
+    made), 'priority', 'queued' and 'running' tasks, 'max_parallelism' and
+    'tasks_run' so far.
+    """
+    cdef:
+        vector[CFWFReadQueueStats] c_stats
+        CFWFReadQueueStats stats
+
+    with nogil:
+        c_stats = GetSchedulerStats()
+    out = []
+    for stats in c_stats:
+        out.append({'id': stats.id,
+                    'priority': next(k for k, v in _priorities.items()
+                                     if v == stats.priority),
+                    'queued': stats.queued,
+                    'running': stats.running,
+                    'max_parallelism': stats.max_parallelism,
+                    'tasks_run': stats.tasks_run})
+    return out
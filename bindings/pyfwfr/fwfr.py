@@ -7,4 +7,9 @@
 #
 # Distributed under terms of the license.
 
-from pyfwfr._fwfr import ReadOptions, ParseOptions, ConvertOptions, read_fwf
+from pyfwfr._fwfr import (ReadOptions, ParseOptions, RecordLayout,
+                          ConvertOptions, ColumnConvertOptions, LazyTable,
+                          RecordBatchStream, Copybook, read_fwf, read_fwf_cached,
+                          read_fwf_dataset, read_fwf_lazy, read_fwf_layouts,
+                          read_fwf_stream, compile_copybook,
+                          get_scheduler_stats)
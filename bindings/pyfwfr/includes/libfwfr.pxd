@@ -8,7 +8,7 @@
 
 # distutils: language = c++
 
-from libc.stdint cimport int32_t, uint32_t
+from libc.stdint cimport int32_t, int64_t, uint32_t
 from libcpp cimport bool as c_bool
 from libcpp.memory cimport shared_ptr
 from libcpp.string cimport string as c_string
@@ -17,27 +17,100 @@ from libcpp.unordered_map cimport unordered_map
 
 from pyarrow.compat import frombytes, tobytes, Mapping
 from pyarrow.includes.common cimport CStatus
-from pyarrow.includes.libarrow cimport CDataType, CMemoryPool, CTable, InputStream
+from pyarrow.includes.libarrow cimport (CDataType, CMemoryPool, CRecordBatchReader,
+                                        CSchema, CTable, InputStream)
 
 cdef extern from "../include/fwfr/api.h" namespace "fwfr" nogil:
+    enum CFWFPredicateKind" fwfr::Predicate::Kind":
+        CFWFPredicate_EQUAL" fwfr::Predicate::EQUAL"
+        CFWFPredicate_IN" fwfr::Predicate::IN"
+        CFWFPredicate_RANGE" fwfr::Predicate::RANGE"
+        CFWFPredicate_PREFIX" fwfr::Predicate::PREFIX"
+
+    cdef cppclass CFWFPredicate" fwfr::Predicate":
+        c_string column
+        CFWFPredicateKind kind
+        vector[c_string] values
+        double min
+        double max
+
+    enum CFWFPriority" fwfr::ReadOptions::Priority":
+        CFWFPriority_HIGH" fwfr::ReadOptions::HIGH"
+        CFWFPriority_NORMAL" fwfr::ReadOptions::NORMAL"
+        CFWFPriority_LOW" fwfr::ReadOptions::LOW"
+
     cdef cppclass CFWFReadOptions" fwfr::ReadOptions":
         c_string encoding
         c_bool use_threads
-        int32_t block_size
+        int64_t block_size
+        c_bool adaptive_block_size
+        int64_t min_block_size
+        int64_t output_chunk_rows
+        c_bool decompress
+        int32_t max_parallelism
+        CFWFPriority priority
+        int64_t max_memory_bytes
+        int64_t max_recycled_bytes
         int32_t skip_rows
         vector[c_string] column_names
+        c_bool raw_records
+        vector[c_string] raw_key_columns
+        vector[CFWFPredicate] predicates
         
         @staticmethod
         CFWFReadOptions Defaults()    
         
+    cdef cppclass CFWFRecordLayout" fwfr::RecordLayout":
+        c_string type_code
+        vector[uint32_t] field_widths
+        vector[uint32_t] skip_columns
+        vector[c_string] column_names
+
+    enum CFWFRecordFormat" fwfr::ParseOptions::RecordFormat":
+        CFWFRecordFormat_LINES" fwfr::ParseOptions::LINES"
+        CFWFRecordFormat_RDW" fwfr::ParseOptions::RDW"
+        CFWFRecordFormat_BDW" fwfr::ParseOptions::BDW"
+
     cdef cppclass CFWFParseOptions" fwfr::ParseOptions":
         vector[uint32_t] field_widths
         c_bool ignore_empty_lines
         vector[uint32_t] skip_columns
+        CFWFRecordFormat record_format
+        vector[CFWFRecordLayout] layouts
+        uint32_t type_code_offset
 
         @staticmethod
         CFWFParseOptions Defaults()
 
+    enum CFWFNumericEncoding" fwfr::NumericFormat::Encoding":
+        CFWFNumericEncoding_TEXT" fwfr::NumericFormat::TEXT"
+        CFWFNumericEncoding_ZONED" fwfr::NumericFormat::ZONED"
+        CFWFNumericEncoding_BINARY" fwfr::NumericFormat::BINARY"
+        CFWFNumericEncoding_PACKED" fwfr::NumericFormat::PACKED"
+
+    enum CFWFNumericSign" fwfr::NumericFormat::Sign":
+        CFWFNumericSign_UNSIGNED" fwfr::NumericFormat::UNSIGNED"
+        CFWFNumericSign_TRAILING" fwfr::NumericFormat::TRAILING"
+        CFWFNumericSign_LEADING" fwfr::NumericFormat::LEADING"
+        CFWFNumericSign_TRAILING_SEPARATE" fwfr::NumericFormat::TRAILING_SEPARATE"
+        CFWFNumericSign_LEADING_SEPARATE" fwfr::NumericFormat::LEADING_SEPARATE"
+
+    cdef cppclass CFWFNumericFormat" fwfr::NumericFormat":
+        CFWFNumericEncoding encoding
+        CFWFNumericSign sign
+
+    cdef cppclass CFWFColumnConvertOptions" fwfr::ColumnConvertOptions":
+        c_bool is_cobol
+        vector[c_string] null_values
+        vector[c_string] true_values
+        vector[c_string] false_values
+        int32_t implied_decimals
+        c_bool strings_can_be_null
+        CFWFNumericFormat numeric_format
+
+        @staticmethod
+        CFWFColumnConvertOptions Defaults()
+
     cdef cppclass CFWFConvertOptions" fwfr::ConvertOptions":
         unordered_map[c_string, shared_ptr[CDataType]] column_types
         c_bool is_cobol
@@ -46,11 +119,61 @@ cdef extern from "../include/fwfr/api.h" namespace "fwfr" nogil:
         vector[c_string] null_values
         vector[c_string] true_values
         vector[c_string] false_values
+        int32_t implied_decimals
         c_bool strings_can_be_null
+        CFWFNumericFormat numeric_format
+        int32_t inference_blocks
+        c_string inference_spill_directory
+        c_bool large_strings
+        unordered_map[c_string, CFWFColumnConvertOptions] column_options
+        unordered_map[int32_t, CFWFColumnConvertOptions] column_index_options
 
         @staticmethod
         CFWFConvertOptions Defaults()
 
+    cdef cppclass CFWFCopybook" fwfr::Copybook":
+        CFWFParseOptions parse_options
+        vector[c_string] column_names
+        CFWFConvertOptions convert_options
+        shared_ptr[CSchema] schema
+
+    CStatus CompileCopybook(c_string source, CFWFCopybook* out)
+
+    cdef cppclass CFWFCacheOptions" fwfr::CacheOptions":
+        c_string directory
+        c_bool hash_contents
+
+        @staticmethod
+        CFWFCacheOptions Defaults()
+
+    CStatus ReadCachedTable(CMemoryPool* pool, c_string path,
+                            CFWFReadOptions read_options,
+                            CFWFParseOptions parse_options,
+                            CFWFConvertOptions convert_options,
+                            CFWFCacheOptions cache_options,
+                            shared_ptr[CTable]* out)
+
+    cdef cppclass CFWFLazyTable" fwfr::LazyTable":
+        int32_t num_columns()
+        int64_t num_rows()
+        vector[c_string] column_names()
+        shared_ptr[CDataType] column_type(int32_t i)
+        CStatus Select(vector[c_string] names, shared_ptr[CTable]* out)
+        CStatus ToTable(shared_ptr[CTable]* out)
+
+    cdef cppclass CFWFStageMemoryStats" fwfr::StageMemoryStats":
+        int64_t bytes_allocated
+        int64_t max_memory
+
+    cdef cppclass CFWFReadMemoryStats" fwfr::ReadMemoryStats":
+        CFWFStageMemoryStats readahead
+        CFWFStageMemoryStats parse
+        CFWFStageMemoryStats convert
+        CFWFStageMemoryStats output
+        CFWFStageMemoryStats budget
+        CFWFStageMemoryStats recycled
+        int64_t reused_bytes
+
     cdef cppclass CFWFReader" fwfr::TableReader":
         @staticmethod
         CStatus Make(CMemoryPool*, shared_ptr[InputStream],
@@ -58,3 +181,26 @@ cdef extern from "../include/fwfr/api.h" namespace "fwfr" nogil:
                      shared_ptr[CFWFReader]* out)
 
         CStatus Read(shared_ptr[CTable]* out)
+        CStatus ReadLazy(shared_ptr[CFWFLazyTable]* out)
+        CStatus ReadLayouts(unordered_map[c_string, shared_ptr[CTable]]* out)
+        CStatus ReadStream(shared_ptr[CRecordBatchReader]* out)
+        CFWFReadMemoryStats memory_stats()
+
+    cdef cppclass CFWFDatasetReader" fwfr::DatasetReader":
+        @staticmethod
+        CStatus Make(CMemoryPool*, vector[c_string] paths,
+                     CFWFReadOptions, CFWFParseOptions, CFWFConvertOptions,
+                     shared_ptr[CFWFDatasetReader]* out)
+
+        CStatus Read(shared_ptr[CTable]* out)
+        CStatus ReadPerFile(vector[shared_ptr[CTable]]* out)
+
+    cdef cppclass CFWFReadQueueStats" fwfr::ReadQueueStats":
+        int64_t id
+        CFWFPriority priority
+        int64_t queued
+        int32_t running
+        int32_t max_parallelism
+        int64_t tasks_run
+
+    vector[CFWFReadQueueStats] GetSchedulerStats()
@@ -6,13 +6,26 @@
 # by the Minister of Statistics Canada, 2019.
 #
 # Distributed under terms of the license.
+import gzip
+import os
 import pyarrow as pa
 import pyfwfr as pf
+import shutil
+import struct
+import subprocess
+import tempfile
+import threading
 import unittest
 import warnings
+import zlib
 
 from pyfwfr.tests.common import make_random_fwf, read_bytes
 
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
 
 def ignore_numpy_warning(test_func):
     """
@@ -28,6 +41,53 @@ def ignore_numpy_warning(test_func):
 
 
 class TestPyfwfr(unittest.TestCase):
+    @ignore_numpy_warning
+    def test_adaptive_block_size(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        parallelism = pa.cpu_count()
+
+        # Chunk sizes follow the measured task times, within the block size,
+        # starting with a block spread over all workers (rows of 122 bytes)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=20000)
+        read_options = pf.ReadOptions(adaptive_block_size=True,
+                                      min_block_size=4096, block_size=100000)
+        table = read_bytes(fwf, parse_options, read_options=read_options)
+        assert table.equals(expected)
+        lengths = [len(chunk) for chunk in table.column(0).data.chunks]
+        assert len(lengths) >= 20000 // (100000 // 122 + 1)
+        assert max(lengths) <= 100000 // 122 + 1
+        assert lengths[0] <= max(4096, 100000 // parallelism) // 122 + 1
+
+        # An input smaller than a chunk of min_block_size per worker is
+        # split evenly over the workers
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=1000)
+        read_options = pf.ReadOptions(adaptive_block_size=True,
+                                      min_block_size=65536, block_size=1 << 20)
+        table = read_bytes(fwf, parse_options, read_options=read_options)
+        assert table.equals(expected)
+        lengths = [len(chunk) for chunk in table.column(0).data.chunks]
+        assert max(lengths) <= 1001 // parallelism + 2
+
+        # Binary records back to back, each ending with 0x0D and followed
+        # by one starting with 0x0A, are cut between records
+        copybook = pf.compile_copybook(
+            '       01  REC.\n'
+            '           05  A          PIC S9(4) COMP.\n'
+            '           05  B          PIC S9(4) COMP.\n')
+        rows = b''.join(struct.pack('>hh', 0x0A00 + i % 256,
+                                    (i % 100) * 256 + 0x0D)
+                        for i in range(20000))
+        read_options = pf.ReadOptions(adaptive_block_size=True,
+                                      min_block_size=4096, block_size=100000,
+                                      column_names=copybook.column_names)
+        table = read_bytes(rows, copybook.parse_options,
+                           read_options=read_options,
+                           convert_options=copybook.convert_options)
+        assert table.to_pydict() == {
+            'A': [0x0A00 + i % 256 for i in range(20000)],
+            'B': [(i % 100) * 256 + 0x0D for i in range(20000)]}
+        assert table.column(0).data.num_chunks > 1
+
     @ignore_numpy_warning
     def test_big(self):
         field_widths = []
@@ -56,6 +116,72 @@ class TestPyfwfr(unittest.TestCase):
         assert table.equals(expected)
         assert table.to_pydict() == expected.to_pydict()
 
+    @ignore_numpy_warning
+    def test_cache(self):
+        parse_options = pf.ParseOptions([4, 4])
+        fwf, expected = make_random_fwf(num_rows=100)
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'data.txt')
+            cache_dir = os.path.join(tmpdir, 'cache')
+            os.mkdir(cache_dir)
+            with open(path, 'wb') as f:
+                f.write(fwf)
+
+            # A miss, then a hit
+            for i in range(2):
+                table = pf.read_fwf_cached(path, parse_options, cache_dir)
+                assert table.schema == expected.schema
+                assert table.equals(expected)
+                assert len(os.listdir(cache_dir)) == 1
+
+            # Other options are another entry
+            convert_options = pf.ConvertOptions(column_types={'aa': pa.string()})
+            table = pf.read_fwf_cached(path, parse_options, cache_dir,
+                                       convert_options=convert_options)
+            assert table.schema.field_by_name('aa').type == pa.string()
+            assert len(os.listdir(cache_dir)) == 2
+
+            # As are large strings, which change the inferred string types
+            convert_options = pf.ConvertOptions(large_strings=True)
+            num_entries = 2
+            if hasattr(pa, 'large_string'):
+                pf.read_fwf_cached(path, parse_options, cache_dir,
+                                   convert_options=convert_options)
+                num_entries += 1
+                assert len(os.listdir(cache_dir)) == num_entries
+            else:
+                # Large types need Arrow 0.15 or later
+                with self.assertRaises(NotImplementedError):
+                    pf.read_fwf_cached(path, parse_options, cache_dir,
+                                       convert_options=convert_options)
+
+            # So are other file contents
+            fwf, expected = make_random_fwf(num_rows=100)
+            with open(path, 'wb') as f:
+                f.write(fwf)
+            os.utime(path, ns=(0, 0))
+            table = pf.read_fwf_cached(path, parse_options, cache_dir,
+                                       hash_contents=True)
+            assert table.equals(expected)
+            assert len(os.listdir(cache_dir)) == num_entries + 1
+
+            # An unreadable entry is a miss, and is replaced
+            for name in os.listdir(cache_dir):
+                os.remove(os.path.join(cache_dir, name))
+            pf.read_fwf_cached(path, parse_options, cache_dir)
+            entry = os.path.join(cache_dir, os.listdir(cache_dir)[0])
+            with open(entry, 'wb') as f:
+                f.write(b'not an arrow file')
+            table = pf.read_fwf_cached(path, parse_options, cache_dir)
+            assert table.equals(expected)
+            assert os.path.getsize(entry) > len(b'not an arrow file')
+
+            # A table that cannot be cached is still read
+            missing_dir = os.path.join(tmpdir, 'missing')
+            table = pf.read_fwf_cached(path, parse_options, missing_dir)
+            assert table.equals(expected)
+            assert not os.path.exists(missing_dir)
+
     def test_cobol(self):
         rows = b'a  b  c \r\n1A ab 12\r\n33Jcde34\r\n6}  fg56\r\n 3Dhij78'
         parse_options = pf.ParseOptions([3, 3, 2])
@@ -69,6 +195,24 @@ class TestPyfwfr(unittest.TestCase):
                                      'c': [12, 34, 56, 78]}
         assert table.column(0).type == 'int64'
 
+    def test_column_options(self):
+        rows = b'a   b   \r\nN/A N/A \r\n1   2   '
+        parse_options = pf.ParseOptions([4, 4])
+        convert_options = pf.ConvertOptions(column_options={
+            'a': pf.ColumnConvertOptions(null_values=['N/A']),
+            1: pf.ColumnConvertOptions()})
+        table = read_bytes(rows, parse_options,
+                           convert_options=convert_options)
+        assert table.column(0).type == 'int64'
+        assert table.column(1).type == 'string'
+        assert table.to_pydict() == {'a': [None, 1], 'b': ['N/A', '2']}
+
+        opts = convert_options.column_options
+        assert opts['a'].null_values == ['N/A']
+        assert opts[1].null_values == []
+        assert opts[1].is_cobol is False
+        assert 'true' in opts[1].true_values
+
     def test_convert_options(self):
         cls = pf.ConvertOptions
         opts = cls()
@@ -107,12 +251,37 @@ class TestPyfwfr(unittest.TestCase):
         opts.is_cobol = True
         assert opts.is_cobol is True
 
+        assert opts.implied_decimals == 0
+        opts.implied_decimals = 2
+        assert opts.implied_decimals == 2
+
         opts.pos_values = {'a': '1', 'b': '2'}
         assert opts.pos_values == {'a': '1', 'b': '2'}
 
         opts.neg_values = {'a': 'b', '3': '4'}
         assert opts.neg_values == {'a': 'b', '3': '4'}
 
+        assert opts.numeric_encoding == 'text'
+        opts.numeric_encoding = 'packed'
+        assert opts.numeric_encoding == 'packed'
+        assert opts.numeric_sign == 'trailing'
+        opts.numeric_sign = 'leading_separate'
+        assert opts.numeric_sign == 'leading_separate'
+        with self.assertRaises(ValueError):
+            opts.numeric_encoding = 'comp-1'
+
+        assert opts.inference_blocks == 0
+        opts.inference_blocks = 4
+        assert opts.inference_blocks == 4
+        with self.assertRaises(ValueError):
+            opts.inference_blocks = -1
+        assert opts.inference_spill_directory == ''
+        opts.inference_spill_directory = '/tmp'
+        assert opts.inference_spill_directory == '/tmp'
+        assert opts.large_strings is False
+        opts.large_strings = True
+        assert opts.large_strings is True
+
         opts = cls(column_types={'a': pa.null()}, is_cobol=True,
                    pos_values={'a': '1'}, neg_values={'b': '2'},
                    null_values=['N', 'nn'], true_values=['T', 'tt'],
@@ -126,6 +295,241 @@ class TestPyfwfr(unittest.TestCase):
         assert opts.false_values == ['F', 'ff']
         assert opts.strings_can_be_null is True
 
+    def test_copybook(self):
+        copybook = pf.compile_copybook(
+            '      * Monthly sales\n'
+            '       01  SALE-REC.\n'
+            '           05  REGION     PIC X(2).\n'
+            '           05  FILLER     PIC X.\n'
+            '           05  QTY        PIC S9(3).\n'
+            '           05  PRICE      PIC 9(3)V99 COMP-3.\n'
+            '           05  UNITS      PIC S9(4) COMP.\n'
+            '           05  MONTHLY    PIC 9(2) OCCURS 2 TIMES.\n')
+        assert copybook.parse_options.field_widths == [2, 1, 3, 3, 2, 4]
+        assert copybook.parse_options.skip_columns == [1]
+        assert copybook.column_names == ['REGION', 'QTY', 'PRICE', 'UNITS',
+                                         'MONTHLY']
+        assert copybook.schema.types == [pa.string(), pa.int16(),
+                                         pa.float64(), pa.int16(),
+                                         pa.list_(pa.int16(), 2)]
+        column_options = copybook.convert_options.column_options
+        assert column_options['QTY'].numeric_encoding == 'zoned'
+        assert column_options['PRICE'].numeric_encoding == 'packed'
+        assert column_options['PRICE'].implied_decimals == 2
+        assert column_options['UNITS'].numeric_encoding == 'binary'
+        assert column_options['MONTHLY'].numeric_sign == 'unsigned'
+
+        # Binary records are back to back, without line separators
+        rows = (b'ON 12J\x12\x34\x5f\x01\x2c0102'
+                b'QCx045\x00\x05\x0c\xff\xfe  07')
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads,
+                                          column_names=copybook.column_names)
+            table = read_bytes(rows, copybook.parse_options,
+                               read_options=read_options,
+                               convert_options=copybook.convert_options)
+            assert table.schema == copybook.schema
+            assert table.to_pydict() == {'REGION': ['ON', 'QC'],
+                                         'QTY': [-121, 45],
+                                         'PRICE': [123.45, 0.5],
+                                         'UNITS': [300, -2],
+                                         'MONTHLY': [[1, 2], [None, 7]]}
+
+        with self.assertRaises(NotImplementedError):
+            pf.compile_copybook('01 R. 05 F PIC S9(4)V99 COMP-1.')
+
+    def test_copybook_block_boundary(self):
+        copybook = pf.compile_copybook(
+            '       01  REC.\n'
+            '           05  CODE       PIC X(2).\n'
+            '           05  UNITS      PIC S9(4) COMP.\n')
+        # The second record's binary field is 0x0D0A, split between blocks
+        rows = b'AA\x00\x01BB\x0d\x0aCC\x00\x02'
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads,
+                                          block_size=7,
+                                          column_names=copybook.column_names)
+            table = read_bytes(rows, copybook.parse_options,
+                               read_options=read_options,
+                               convert_options=copybook.convert_options)
+            assert table.to_pydict() == {'CODE': ['AA', 'BB', 'CC'],
+                                         'UNITS': [1, 3338, 2]}
+
+    @ignore_numpy_warning
+    def test_dataset(self):
+        parse_options = pf.ParseOptions([4, 4])
+        fwfs, expected = [], []
+        for i in range(5):
+            fwf, table = make_random_fwf(num_rows=1000)
+            fwfs.append(fwf)
+            expected.append(table)
+        # Inference spans files: a float in the last file makes the column
+        # double in all of them
+        fwfs[-1] = fwfs[-1].replace(fwfs[-1].splitlines()[1][:4], b'1.50', 1)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            paths = []
+            for i, fwf in enumerate(fwfs):
+                paths.append(os.path.join(tmpdir, 'data%d.txt' % i))
+                with open(paths[-1], 'wb') as f:
+                    f.write(fwf)
+
+            for use_threads in (True, False):
+                read_options = pf.ReadOptions(use_threads=use_threads,
+                                              block_size=1000)
+                table = pf.read_fwf_dataset(paths, parse_options,
+                                            read_options=read_options)
+                assert table.num_rows == 5000
+                assert table.schema.field_by_name('aa').type == pa.float64()
+                assert (table.column('ab').to_pylist() ==
+                        sum((t.column('ab').to_pylist() for t in expected), []))
+
+                tables = pf.read_fwf_dataset(paths, parse_options,
+                                             read_options=read_options,
+                                             per_file=True)
+                assert len(tables) == 5
+                for table, expected_table in zip(tables, expected):
+                    assert table.schema == tables[0].schema
+                    assert table.column('ab').to_pylist() == \
+                        expected_table.column('ab').to_pylist()
+
+            # Files must share their column names
+            with open(paths[-1], 'wb') as f:
+                f.write(b'xx  yy  \n12345678\n')
+            with self.assertRaises(pa.ArrowInvalid):
+                pf.read_fwf_dataset(paths, parse_options)
+
+    def test_decompress(self):
+        def bgzf_block(data):
+            # A gzip member with its compressed size in a 'BC' extra subfield
+            compressor = zlib.compressobj(6, zlib.DEFLATED, -15)
+            deflated = compressor.compress(data) + compressor.flush()
+            header = (b'\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00BC' +
+                      struct.pack('<HH', 2, 18 + len(deflated) + 8 - 1))
+            return (header + deflated +
+                    struct.pack('<II', zlib.crc32(data) & 0xffffffff, len(data)))
+
+        parse_options = pf.ParseOptions([4, 4])
+        fwf, expected = make_random_fwf(num_rows=5000)
+        compressed = {
+            'gzip': gzip.compress(fwf),
+            'multi-member gzip': gzip.compress(fwf[:30000]) + gzip.compress(fwf[30000:]),
+            'bgzf': b''.join(bgzf_block(fwf[i:i + 4000])
+                             for i in range(0, len(fwf), 4000)) + bgzf_block(b''),
+        }
+        for name, data in compressed.items():
+            for use_threads in [True, False]:
+                read_options = pf.ReadOptions(use_threads=use_threads,
+                                              block_size=10000)
+                table = read_bytes(data, parse_options,
+                                   read_options=read_options)
+                assert table.equals(expected), name
+
+            with self.assertRaises(pa.ArrowInvalid):
+                read_bytes(data[:-10], parse_options)
+
+        # Compressed files are read as is, then decompressed by fwfr
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'data.bgz')
+            with open(path, 'wb') as f:
+                f.write(compressed['bgzf'])
+            assert pf.read_fwf(path, parse_options).equals(expected)
+
+    @ignore_numpy_warning
+    @unittest.skipUnless(zstandard, 'zstandard is not installed')
+    def test_decompress_zstd(self):
+        def skippable_frame(payload):
+            return struct.pack('<II', 0x184D2A50, len(payload)) + payload
+
+        parse_options = pf.ParseOptions([4, 4])
+        fwf, expected = make_random_fwf(num_rows=5000)
+        sized = zstandard.ZstdCompressor()
+        unsized = zstandard.ZstdCompressor(write_content_size=False)
+        compressed = {
+            'zstd': sized.compress(fwf),
+            'zstd frames': b''.join(sized.compress(fwf[i:i + 4000])
+                                    for i in range(0, len(fwf), 4000)),
+            'zstd frames without content size': b''.join(
+                unsized.compress(fwf[i:i + 4000])
+                for i in range(0, len(fwf), 4000)),
+            # As in the seekable format, with a seek table at the end
+            'skippable frames': (skippable_frame(b'head') +
+                                 sized.compress(fwf[:30000]) +
+                                 skippable_frame(b'') +
+                                 sized.compress(fwf[30000:]) +
+                                 skippable_frame(b'\0' * 12)),
+        }
+        for name, data in compressed.items():
+            for use_threads in [True, False]:
+                read_options = pf.ReadOptions(use_threads=use_threads,
+                                              block_size=10000)
+                table = read_bytes(data, parse_options,
+                                   read_options=read_options)
+                assert table.equals(expected), name
+
+            # A truncated frame is decompressed by streaming, which fails
+            with self.assertRaises(pa.ArrowInvalid):
+                read_bytes(data[:-10], parse_options)
+
+    def test_fixed_size_list(self):
+        rows = b'id amounts  \r\n  1 10 20 30\r\n  2 40 50 60'
+        parse_options = pf.ParseOptions([3, 9])
+        convert_options = pf.ConvertOptions(
+            column_types={'amounts': pa.list_(pa.int32(), 3)})
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads)
+            table = read_bytes(rows, parse_options, read_options=read_options,
+                               convert_options=convert_options)
+            assert table.schema.field_by_name('amounts').type == \
+                pa.list_(pa.int32(), 3)
+            assert table.to_pydict() == {'id': [1, 2],
+                                         'amounts': [[10, 20, 30],
+                                                     [40, 50, 60]]}
+
+        # Values parsed one slice at a time, however wide the whole field
+        rows = (b'id totals                        \r\n'
+                b'  1-1234567892147483648         0\r\n'
+                b'  2      9999-999999999 999999999')
+        parse_options = pf.ParseOptions([3, 30])
+        convert_options = pf.ConvertOptions(
+            column_types={'totals': pa.list_(pa.int64(), 3)})
+        table = read_bytes(rows, parse_options,
+                           convert_options=convert_options)
+        assert table.to_pydict() == {'id': [1, 2],
+                                     'totals': [[-123456789, 2147483648, 0],
+                                                [9999, -999999999, 999999999]]}
+
+    @ignore_numpy_warning
+    @unittest.skipUnless(shutil.which('fwfr2parquet'),
+                         'fwfr2parquet is not built')
+    def test_fwfr2parquet(self):
+        import pyarrow.parquet as pq
+        fwf, expected = make_random_fwf(num_rows=1000)
+        with tempfile.TemporaryDirectory() as tmpdir:
+            input_path = os.path.join(tmpdir, 'data.txt')
+            output_path = os.path.join(tmpdir, 'data.parquet')
+            with open(input_path, 'wb') as f:
+                f.write(fwf)
+
+            # Batches of a block each are carried across row groups of
+            # exactly row_group_size rows, but the last
+            subprocess.check_call(['fwfr2parquet', '--field_widths=[4, 4]',
+                                   '--block_size=1000',
+                                   '--row_group_size=300',
+                                   input_path, output_path])
+            parquet_file = pq.ParquetFile(output_path)
+            metadata = parquet_file.metadata
+            assert [metadata.row_group(i).num_rows
+                    for i in range(metadata.num_row_groups)] == [300, 300,
+                                                                  300, 100]
+            assert parquet_file.read().to_pydict() == expected.to_pydict()
+
+            # Integers out of range are refused, not cast
+            assert subprocess.call(['fwfr2parquet', '--field_widths=[4, 4]',
+                                    '--row_group_size=1e20',
+                                    input_path, output_path],
+                                   stderr=subprocess.DEVNULL) == 1
+
     def test_header(self):
         rows = b'abcdef'
         parse_options = pf.ParseOptions([2, 3, 1])
@@ -135,6 +539,269 @@ class TestPyfwfr(unittest.TestCase):
         assert table.column_names == ['ab', 'cde', 'f']
         assert table.num_rows == 0
 
+    def test_implied_decimals(self):
+        rows = b'a     b     \r\n001234  1.50\r\n-00005    25'
+        parse_options = pf.ParseOptions([6, 6])
+        convert_options = pf.ConvertOptions(column_types={'a': pa.float64(),
+                                                          'b': pa.float32()},
+                                            implied_decimals=2)
+        table = read_bytes(rows, parse_options,
+                           convert_options=convert_options)
+        assert table.column(0).type == 'double'
+        assert table.column(1).type == 'float'
+        assert table.to_pydict() == {'a': [12.34, -0.05], 'b': [1.5, 0.25]}
+
+        convert_options.implied_decimals = -1
+        with self.assertRaises(pa.ArrowInvalid):
+            read_bytes(rows, parse_options, convert_options=convert_options)
+
+    def test_inference(self):
+        # Integers for many blocks, then a value only a string fits
+        rows = b''.join(b'%6d\r\n' % i for i in range(5000)) + b'    x \r\n'
+        parse_options = pf.ParseOptions([6])
+        read_options = pf.ReadOptions(column_names=['a'], block_size=1000)
+        expected = [str(i) for i in range(5000)] + ['x']
+
+        # Blocks reconverted from memory or from disk
+        with tempfile.TemporaryDirectory() as tmpdir:
+            for spill_dir in ['', tmpdir]:
+                convert_options = pf.ConvertOptions(
+                    inference_spill_directory=spill_dir)
+                table = read_bytes(rows, parse_options, read_options=read_options,
+                                   convert_options=convert_options)
+                assert table.column(0).type == 'string'
+                assert table.to_pydict() == {'a': expected}
+            # The spill file is already gone
+            assert os.listdir(tmpdir) == []
+
+        # The type locked as int64 before 'x' (in order, when serial)
+        read_options.use_threads = False
+        convert_options = pf.ConvertOptions(inference_blocks=2)
+        with self.assertRaises(pa.ArrowInvalid):
+            read_bytes(rows, parse_options, read_options=read_options,
+                       convert_options=convert_options)
+
+    def test_integer_bounds(self):
+        # Through the fast kernel (a sign and up to 19 digits) or, past it,
+        # the generic converter, values convert the same
+        def read(values, type, width):
+            rows = b'a'.ljust(width) + b''.join(b'\r\n' + value.rjust(width)
+                                                 for value in values)
+            convert_options = pf.ConvertOptions(column_types={'a': type})
+            table = read_bytes(rows, pf.ParseOptions([width]),
+                               convert_options=convert_options)
+            return table.column(0).to_pylist()
+
+        for width in [20, 21]:
+            assert read([b'-9223372036854775808', b'9223372036854775807',
+                         b'-1', b'0'], pa.int64(), width) == \
+                [-2 ** 63, 2 ** 63 - 1, -1, 0]
+            assert read([b'00000000000000000042', b'-0000000000000000042'],
+                        pa.int64(), width) == [42, -42]
+            assert read([b'18446744073709551615', b'9999999999999999999'],
+                        pa.uint64(), width) == [2 ** 64 - 1, 10 ** 19 - 1]
+        assert read([b'127', b'-128', b'-0'], pa.int8(), 4) == [127, -128, 0]
+        assert read([b'255', b'0'], pa.uint8(), 4) == [255, 0]
+
+        # Out of range values, or signs on unsigned types, are errors
+        for values, type, width in [([b'9223372036854775808'], pa.int64(), 20),
+                                    ([b'-9223372036854775809'], pa.int64(), 20),
+                                    ([b'99999999999999999999'], pa.int64(), 20),
+                                    ([b'18446744073709551616'], pa.uint64(), 20),
+                                    ([b'128'], pa.int8(), 4),
+                                    ([b'-129'], pa.int8(), 4),
+                                    ([b'-1'], pa.uint8(), 4)]:
+            with self.assertRaises(pa.ArrowInvalid):
+                read(values, type, width)
+
+        # Inferred integers that overflow int64 are read as doubles
+        rows = b'a                   \r\n' + b'9223372036854775808'.rjust(20)
+        table = read_bytes(rows, pf.ParseOptions([20]))
+        assert table.column(0).type == pa.float64()
+        assert table.column(0).to_pylist() == [9223372036854775808.0]
+
+    def test_large_strings(self):
+        rows = b'a  b  \n1  ab \n2  cd '
+        parse_options = pf.ParseOptions([3, 3])
+        convert_options = pf.ConvertOptions(large_strings=True)
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads)
+            if not hasattr(pa, 'large_string'):
+                # Large types need Arrow 0.15 or later
+                with self.assertRaises(NotImplementedError):
+                    read_bytes(rows, parse_options, read_options=read_options,
+                               convert_options=convert_options)
+                continue
+            table = read_bytes(rows, parse_options, read_options=read_options,
+                               convert_options=convert_options)
+            assert table.column('a').type == pa.int64()
+            assert table.column('b').type == pa.large_string()
+            assert table.to_pydict() == {'a': [1, 2], 'b': ['ab', 'cd']}
+
+    def test_layouts(self):
+        rows = (b'H20190101\r\nD0001  12.5\r\nD0002   7.0\r\n\r\n'
+                b'T2\r\nD0003  -1.5')
+        layouts = [pf.RecordLayout('H', [1, 8], ['type', 'date']),
+                   pf.RecordLayout('D', [1, 4, 6], ['id', 'amount'],
+                                   skip_columns=[0]),
+                   pf.RecordLayout('T', [1, 1], ['type', 'count'])]
+        parse_options = pf.ParseOptions([], layouts=layouts)
+        assert [x.type_code for x in parse_options.layouts] == ['H', 'D', 'T']
+        assert parse_options.layouts[1].skip_columns == [0]
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads)
+            tables = pf.read_fwf_layouts(pa.py_buffer(rows), parse_options,
+                                         read_options=read_options)
+            assert sorted(tables.keys()) == ['D', 'H', 'T']
+            assert tables['H'].to_pydict() == {'type': ['H'],
+                                               'date': [20190101]}
+            assert tables['D'].to_pydict() == {'id': [1, 2, 3],
+                                               'amount': [12.5, 7.0, -1.5]}
+            assert tables['T'].to_pydict() == {'type': ['T'], 'count': [2]}
+
+    @ignore_numpy_warning
+    def test_lazy(self):
+        rows = b'a  b  c  \r\n1  ab 2.5\r\n2  cd 3.5'
+        parse_options = pf.ParseOptions([3, 3, 3])
+        convert_options = pf.ConvertOptions(column_types={'c': pa.float32()})
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads)
+            lazy = pf.read_fwf_lazy(pa.py_buffer(rows), parse_options,
+                                    read_options=read_options,
+                                    convert_options=convert_options)
+            assert lazy.column_names == ['a', 'b', 'c']
+            assert lazy.num_rows == 2
+            assert lazy.column_types == {'a': None, 'b': None,
+                                         'c': pa.float32()}
+            assert lazy.column('b').to_pylist() == ['ab', 'cd']
+            assert lazy.column_types['b'] == pa.string()
+            assert lazy.column_types['a'] is None
+            table = lazy.select(['c', 'a'])
+            assert table.to_pydict() == {'c': [2.5, 3.5], 'a': [1, 2]}
+            assert lazy.to_table().column_names == ['a', 'b', 'c']
+
+        # Columns converted from several threads at once
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=10000)
+        lazy = pf.read_fwf_lazy(pa.py_buffer(fwf), parse_options,
+                                read_options=pf.ReadOptions(block_size=10000))
+        tables = [None] * 4
+
+        def select(k):
+            tables[k] = lazy.select(expected.column_names[k:k + 20])
+
+        threads = [threading.Thread(target=select, args=(k,)) for k in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        values = expected.to_pydict()
+        for k, table in enumerate(tables):
+            names = expected.column_names[k:k + 20]
+            assert table.to_pydict() == {name: values[name] for name in names}
+
+    @ignore_numpy_warning
+    def test_max_memory_bytes(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=10000)
+        # Declared types, so that no parser is kept for type inference
+        convert_options = pf.ConvertOptions(
+            column_types={name: pa.int64() for name in expected.column_names})
+
+        memory_stats = {}
+        table = read_bytes(fwf, parse_options, convert_options=convert_options,
+                           memory_stats=memory_stats)
+        assert table.equals(expected)
+        assert memory_stats['budget']['max_memory'] == 0
+
+        # Held to a few blocks' worth of memory: blocks are only read and
+        # submitted under the budget, so it is exceeded by no more than the
+        # parsers of the blocks in flight
+        max_bytes = 50000
+        read_options = pf.ReadOptions(max_memory_bytes=max_bytes,
+                                      block_size=10000, max_parallelism=2)
+        memory_stats = {}
+        table = read_bytes(fwf, parse_options, read_options=read_options,
+                           convert_options=convert_options,
+                           memory_stats=memory_stats)
+        assert table.equals(expected)
+        budget = memory_stats['budget']
+        assert 10000 <= budget['max_memory'] <= 4 * max_bytes
+        assert budget['max_memory'] <= (memory_stats['readahead']['max_memory'] +
+                                        memory_stats['parse']['max_memory'])
+        assert memory_stats['convert']['max_memory'] > 0
+
+    @ignore_numpy_warning
+    def test_max_parallelism(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=20000)
+
+        for max_parallelism in [1, 2, 0, 1000]:
+            # Snapshots of the scheduler while the read runs
+            tables = []
+            read_options = pf.ReadOptions(max_parallelism=max_parallelism,
+                                          block_size=10000)
+            thread = threading.Thread(target=lambda: tables.append(
+                read_bytes(fwf, parse_options, read_options=read_options)))
+            thread.start()
+            snapshots = []
+            while thread.is_alive():
+                snapshots.extend(pf.get_scheduler_stats())
+            thread.join()
+            assert tables[0].equals(expected)
+
+            # At most max_parallelism blocks at once, up to the cores
+            expected_parallelism = min(max_parallelism or pa.cpu_count(),
+                                       pa.cpu_count())
+            assert snapshots
+            for stats in snapshots:
+                assert stats['max_parallelism'] == expected_parallelism
+                assert stats['running'] <= expected_parallelism
+
+    @ignore_numpy_warning
+    def test_max_recycled_bytes(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=10000)
+        # Declared types, so that parsers are freed once converted
+        convert_options = pf.ConvertOptions(
+            column_types={name: pa.int64() for name in expected.column_names})
+
+        # Blocks large enough for their buffers to be recycled
+        for use_threads in [True, False]:
+            for max_recycled_bytes in [64 << 20, 200000, 0]:
+                read_options = pf.ReadOptions(
+                    use_threads=use_threads, block_size=100000,
+                    max_recycled_bytes=max_recycled_bytes)
+                memory_stats = {}
+                table = read_bytes(fwf, parse_options,
+                                   read_options=read_options,
+                                   convert_options=convert_options,
+                                   memory_stats=memory_stats)
+                assert table.equals(expected)
+                recycled = memory_stats['recycled']
+                assert recycled['max_memory'] <= max_recycled_bytes
+                if max_recycled_bytes > 0:
+                    # Later blocks reuse the buffers of earlier ones
+                    assert memory_stats['reused_bytes'] > 0
+                else:
+                    assert memory_stats['reused_bytes'] == 0
+
+    def test_memory_pool(self):
+        field_widths = [4] * 10
+        parse_options = pf.ParseOptions(field_widths)
+        fwf, expected = make_random_fwf(num_cols=10, num_rows=1000)
+        for use_threads in [True, False]:
+            # The converted columns are allocated from the given pool, and
+            # the blocks and parsers freed once read
+            pool = pa.proxy_memory_pool(pa.default_memory_pool())
+            read_options = pf.ReadOptions(use_threads=use_threads)
+            table = read_bytes(fwf, parse_options, read_options=read_options,
+                               memory_pool=pool)
+            assert table.equals(expected)
+            assert pool.bytes_allocated() > 0
+            del table
+            assert pool.bytes_allocated() == 0
+
     def test_no_header(self):
         rows = b'123456789'
         parse_options = pf.ParseOptions([1, 2, 3, 3])
@@ -143,6 +810,32 @@ class TestPyfwfr(unittest.TestCase):
         assert table.to_pydict() == {'a': [1], 'b': [23],
                                      'c': [456], 'd': [789]}
 
+    def test_null_widths(self):
+        # Null spellings shorter than the field, padded on either side,
+        # exactly as wide, or too long to fit
+        rows = [(b'a', b'b'), (b'NA', b'NA'), (b'    NA', b' 1'), (b'  NA', b'1 '),
+                (b'NULL', b'NA'), (b'MISSIN', b'22'), (b'NAN', b' 3'),
+                (b'N A', b'4 '), (b'', b'  ')]
+        data = b'\r\n'.join(a.ljust(6) + b.ljust(2) for a, b in rows)
+        parse_options = pf.ParseOptions([6, 2])
+        convert_options = pf.ConvertOptions(
+            column_types={'a': pa.string(), 'b': pa.int64()},
+            null_values=['NA', 'NULL', 'MISSING', ''],
+            strings_can_be_null=True)
+        table = read_bytes(data, parse_options,
+                           convert_options=convert_options)
+        assert table.to_pydict() == {
+            'a': [None, None, None, None, 'MISSIN', 'NAN', 'N A', None],
+            'b': [None, 1, 1, None, 22, 3, 4, None]}
+
+        # No spelling fits a one-byte field, so none is looked for
+        data = b'ab\r\nN1\r\nA2'
+        convert_options = pf.ConvertOptions(null_values=['NA', 'NULL'],
+                                            strings_can_be_null=True)
+        table = read_bytes(data, pf.ParseOptions([1, 1]),
+                           convert_options=convert_options)
+        assert table.to_pydict() == {'a': ['N', 'A'], 'b': [1, 2]}
+
     def test_nulls_bools(self):
         rows = b'a     b     \r\n null N/A   \r\n123456  true'
         parse_options = pf.ParseOptions([6, 6])
@@ -152,6 +845,46 @@ class TestPyfwfr(unittest.TestCase):
         assert(table.column(1).type == 'bool')
         assert table.to_pydict() == {'a': [None, 123456], 'b': [None, True]}
 
+    @ignore_numpy_warning
+    def test_output_chunk_rows(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=10000)
+        # Rows of 122 bytes, so blocks of at most 82 rows
+        block_rows = 10000 // 122 + 1
+
+        for use_threads in [True, False]:
+            for output_chunk_rows in [0, 1, 4000, 20000]:
+                read_options = pf.ReadOptions(
+                    use_threads=use_threads, block_size=10000,
+                    output_chunk_rows=output_chunk_rows)
+                table = read_bytes(fwf, parse_options,
+                                   read_options=read_options)
+                assert table.equals(expected)
+
+                # All columns are chunked alike
+                lengths = [len(chunk) for chunk in table.column(0).data.chunks]
+                for column in table.columns:
+                    assert [len(chunk) for chunk in column.data.chunks] == lengths
+
+                if output_chunk_rows <= 1:
+                    # One chunk per block
+                    assert len(lengths) >= 10000 // block_rows
+                    assert max(lengths) <= block_rows
+                elif output_chunk_rows < 10000:
+                    # Blocks are gathered until there are enough rows
+                    assert len(lengths) == 3
+                    for length in lengths[:-1]:
+                        assert (output_chunk_rows <= length <
+                                output_chunk_rows + block_rows)
+                else:
+                    assert lengths == [10000]
+
+                # Lazily converted columns are gathered alike
+                lazy = pf.read_fwf_lazy(pa.py_buffer(fwf), parse_options,
+                                        read_options=read_options)
+                column = lazy.column(expected.column_names[0])
+                assert [len(chunk) for chunk in column.data.chunks] == lengths
+
     def test_parse_options(self):
         cls = pf.ParseOptions
         with self.assertRaises(Exception):
@@ -166,10 +899,74 @@ class TestPyfwfr(unittest.TestCase):
         opts.ignore_empty_lines = False
         assert opts.ignore_empty_lines is False
 
+        assert opts.type_code_offset == 0
+        opts.type_code_offset = 3
+        assert opts.type_code_offset == 3
+
+        assert opts.layouts == []
+        opts.layouts = [pf.RecordLayout('AB', [2, 3], ['a', 'b'])]
+        layout = opts.layouts[0]
+        assert layout.type_code == 'AB'
+        assert layout.field_widths == [2, 3]
+        assert layout.column_names == ['a', 'b']
+        assert layout.skip_columns == []
+
+        assert opts.record_format == 'lines'
+        opts.record_format = 'bdw'
+        assert opts.record_format == 'bdw'
+        with self.assertRaises(ValueError):
+            opts.record_format = 'vbs'
+
         opts = cls([1, 2], ignore_empty_lines=False)
         assert opts.field_widths == [1, 2]
         assert opts.ignore_empty_lines is False
 
+    def test_predicates(self):
+        rows = (b'regyear name\r\nON 2014 ab  \r\nQC 2016 cd  \r\n'
+                b'ON 2016 abc \r\nBC 2019 ax  \r\nON      abd ')
+        parse_options = pf.ParseOptions([3, 5, 4])
+        for use_threads in [True, False]:
+            read_options = pf.ReadOptions(use_threads=use_threads, predicates=[
+                ('reg', 'in', ['ON', 'BC']), ('year', '>=', 2015)])
+            table = read_bytes(rows, parse_options, read_options=read_options)
+            assert table.to_pydict() == {'reg': ['ON', 'BC'],
+                                         'year': [2016, 2019],
+                                         'name': ['abc', 'ax']}
+
+        read_options = pf.ReadOptions(predicates=[('name', 'startswith', 'ab'),
+                                                  ('reg', '==', 'ON')])
+        table = read_bytes(rows, parse_options, read_options=read_options)
+        assert table.column('name').to_pylist() == ['ab', 'abc', 'abd']
+
+        read_options = pf.ReadOptions(predicates=[('year', 'between',
+                                                   (2015, 2016))])
+        table = read_bytes(rows, parse_options, read_options=read_options)
+        assert table.column('name').to_pylist() == ['cd', 'abc']
+
+    def test_raw_records(self):
+        rows = b'id  val \r\n0001  ab\r\n0002  cd\r\n0003  ef'
+        parse_options = pf.ParseOptions([4, 4])
+        read_options = pf.ReadOptions(raw_records=True, raw_key_columns=['id'])
+        table = read_bytes(rows, parse_options, read_options=read_options)
+        assert table.column_names == ['record', 'id']
+        assert table.column(0).type == pa.binary(10)
+        assert table.to_pydict() == {'record': [b'0001  ab\r\n', b'0002  cd\r\n',
+                                                b'0003  ef\r\n'],
+                                     'id': [1, 2, 3]}
+
+        # The header's line separator is not part of the first record, even
+        # when a block ends within it
+        for block_size in [9, 10, 1 << 20]:
+            read_options = pf.ReadOptions(raw_records=True, block_size=block_size)
+            table = read_bytes(rows, parse_options, read_options=read_options)
+            assert table.column(0).to_pylist() == [b'0001  ab\r\n',
+                                                   b'0002  cd\r\n',
+                                                   b'0003  ef\r\n']
+        rows = rows.replace(b'\r\n', b'\n')
+        table = read_bytes(rows, parse_options, read_options=read_options)
+        assert table.column(0).to_pylist() == [b'0001  ab\n', b'0002  cd\n',
+                                               b'0003  ef\n']
+
     def test_read_options(self):
         cls = pf.ReadOptions
         opts = cls()
@@ -185,6 +982,52 @@ class TestPyfwfr(unittest.TestCase):
         assert opts.block_size > 0
         opts.block_size = 12345
         assert opts.block_size == 12345
+        opts.block_size = 3 << 30
+        assert opts.block_size == 3 << 30
+
+        assert opts.adaptive_block_size is False
+        opts.adaptive_block_size = True
+        assert opts.adaptive_block_size is True
+
+        assert opts.min_block_size == 64 << 10
+        opts.min_block_size = 4096
+        assert opts.min_block_size == 4096
+        with self.assertRaises(ValueError):
+            opts.min_block_size = 0
+
+        assert opts.output_chunk_rows == 0
+        opts.output_chunk_rows = 100000
+        assert opts.output_chunk_rows == 100000
+        with self.assertRaises(ValueError):
+            opts.output_chunk_rows = -1
+
+        assert opts.decompress is True
+        opts.decompress = False
+        assert opts.decompress is False
+
+        assert opts.max_parallelism == 0
+        opts.max_parallelism = 2
+        assert opts.max_parallelism == 2
+        with self.assertRaises(ValueError):
+            opts.max_parallelism = -1
+
+        assert opts.priority == 'normal'
+        opts.priority = 'low'
+        assert opts.priority == 'low'
+        with self.assertRaises(ValueError):
+            opts.priority = 'urgent'
+
+        assert opts.max_memory_bytes == 0
+        opts.max_memory_bytes = 1 << 24
+        assert opts.max_memory_bytes == 1 << 24
+        with self.assertRaises(ValueError):
+            opts.max_memory_bytes = -1
+
+        assert opts.max_recycled_bytes == 64 << 20
+        opts.max_recycled_bytes = 0
+        assert opts.max_recycled_bytes == 0
+        with self.assertRaises(ValueError):
+            opts.max_recycled_bytes = -1
 
         assert opts.skip_rows == 0
         opts.skip_rows = 5
@@ -194,6 +1037,21 @@ class TestPyfwfr(unittest.TestCase):
         opts.column_names = ['ab', 'cd']
         assert opts.column_names == ['ab', 'cd']
 
+        assert opts.raw_records is False
+        opts.raw_records = True
+        assert opts.raw_records is True
+
+        assert opts.raw_key_columns == []
+        opts.raw_key_columns = ['ab']
+        assert opts.raw_key_columns == ['ab']
+
+        assert opts.predicates == []
+        predicates = [('ab', '==', 'x'), ('ab', 'in', ['x', 'y']),
+                      ('cd', 'startswith', 'z'), ('cd', '>=', 1.0),
+                      ('cd', '<=', 2.0), ('cd', 'between', (1.0, 2.0))]
+        opts.predicates = predicates
+        assert opts.predicates == predicates
+
         opts = cls(encoding='abcd', use_threads=False, block_size=1234,
                    skip_rows=1, column_names=['a', 'b', 'c'])
         assert opts.encoding == 'abcd'
@@ -202,6 +1060,93 @@ class TestPyfwfr(unittest.TestCase):
         assert opts.skip_rows == 1
         assert opts.column_names == ['a', 'b', 'c']
 
+    def test_record_format(self):
+        # Descriptor words hold big-endian lengths, themselves included
+        records = b'\x00\x09\x00\x00ab123' + b'\x00\x06\x00\x00cd'
+        blocks = {'rdw': records,
+                  'bdw': b'\x00\x13\x00\x00' + records}
+        for record_format, rows in blocks.items():
+            parse_options = pf.ParseOptions([2, 3], record_format=record_format)
+            for use_threads in [True, False]:
+                read_options = pf.ReadOptions(use_threads=use_threads,
+                                              column_names=['a', 'b'])
+                table = read_bytes(rows, parse_options,
+                                   read_options=read_options)
+                # The short record is padded with spaces
+                assert table.to_pydict() == {'a': ['ab', 'cd'],
+                                             'b': [123, None]}
+
+            with self.assertRaises(pa.ArrowInvalid):
+                read_bytes(rows[:-1], parse_options,
+                           read_options=pf.ReadOptions(column_names=['a', 'b']))
+
+    @ignore_numpy_warning
+    def test_scheduler(self):
+        parse_options = pf.ParseOptions([4] * 30)
+        fwf, expected = make_random_fwf(num_cols=30, num_rows=50000)
+
+        def read_concurrently(priorities):
+            # Start the reads in order, and take snapshots of the scheduler
+            # until they are done
+            tables = [None] * len(priorities)
+
+            def read(i):
+                read_options = pf.ReadOptions(block_size=10000,
+                                              priority=priorities[i])
+                tables[i] = read_bytes(fwf, parse_options,
+                                       read_options=read_options)
+
+            threads = [threading.Thread(target=read, args=(i,))
+                       for i in range(len(priorities))]
+            for thread in threads:
+                thread.start()
+            snapshots = []
+            while any(thread.is_alive() for thread in threads):
+                snapshots.append({stats['id']: stats
+                                  for stats in pf.get_scheduler_stats()})
+            for thread in threads:
+                thread.join()
+            for table in tables:
+                assert table.equals(expected)
+            return snapshots
+
+        def tasks_run_while_queued(snapshots, ids):
+            # Tasks each read ran between the first and last snapshots where
+            # all of them had tasks waiting
+            queued = [snapshot for snapshot in snapshots
+                      if all(i in snapshot and snapshot[i]['queued'] > 0
+                             for i in ids)]
+            assert len(queued) >= 2
+            return [queued[-1][i]['tasks_run'] - queued[0][i]['tasks_run']
+                    for i in ids]
+
+        # With a single worker, reads only progress through the scheduler
+        cpu_count = pa.cpu_count()
+        pa.set_cpu_count(1)
+        try:
+            # A high priority read runs before a low priority one, even
+            # started later
+            snapshots = read_concurrently(['low', 'high'])
+            ids = {}
+            for snapshot in snapshots:
+                for stats in snapshot.values():
+                    assert stats['running'] <= 1
+                    ids[stats['priority']] = stats['id']
+            low, high = tasks_run_while_queued(snapshots,
+                                               [ids['low'], ids['high']])
+            assert high > 0
+            assert low <= high // 4
+
+            # Reads of the same priority take turns
+            snapshots = read_concurrently(['normal', 'normal'])
+            ids = sorted({i for snapshot in snapshots for i in snapshot})
+            assert len(ids) == 2
+            first, second = tasks_run_while_queued(snapshots, ids)
+            assert first + second > 0
+            assert abs(first - second) <= (first + second) // 4 + 2
+        finally:
+            pa.set_cpu_count(cpu_count)
+
     def test_serial_read(self):
         parse_options = pf.ParseOptions([4, 4])
         read_options = pf.ReadOptions(use_threads=False)
@@ -229,6 +1174,11 @@ class TestPyfwfr(unittest.TestCase):
         assert table.equals(expected)
         assert table.to_pydict() == expected.to_pydict()
 
+        # A small input is split over the workers
+        read_options = pf.ReadOptions(adaptive_block_size=True)
+        table = read_bytes(fwf, parse_options, read_options=read_options)
+        assert table.equals(expected)
+
     def test_small_encoded(self):
         parse_options = pf.ParseOptions([4, 4])
         read_options = pf.ReadOptions(encoding='Big5')
@@ -238,3 +1188,75 @@ class TestPyfwfr(unittest.TestCase):
         assert table.schema == expected.schema
         assert table.equals(expected)
         assert table.to_pydict() == expected.to_pydict()
+
+    @ignore_numpy_warning
+    def test_stream(self):
+        parse_options = pf.ParseOptions([4] * 10)
+        fwf, expected = make_random_fwf(num_cols=10, num_rows=5000)
+        for use_threads in (True, False):
+            read_options = pf.ReadOptions(use_threads=use_threads,
+                                          block_size=10000)
+            stream = pf.read_fwf_stream(pa.py_buffer(fwf), parse_options,
+                                        read_options=read_options)
+            assert stream.schema == expected.schema
+
+            batches = list(stream)
+            assert len(batches) > 1
+            assert stream.read_next_batch() is None
+            table = pa.Table.from_batches(batches)
+            assert table.equals(expected)
+
+        # Declared types are kept
+        convert_options = pf.ConvertOptions(column_types={'aa': pa.string()})
+        stream = pf.read_fwf_stream(pa.py_buffer(fwf), parse_options,
+                                    convert_options=convert_options)
+        assert stream.schema.field_by_name('aa').type == pa.string()
+        assert stream.schema.field_by_name('ab').type == pa.int64()
+        table = pa.Table.from_batches(list(stream))
+        assert table.num_rows == expected.num_rows
+
+    @ignore_numpy_warning
+    def test_wide(self):
+        # Blocks of a few rows of many columns
+        parse_options = pf.ParseOptions([4] * 600)
+        fwf, expected = make_random_fwf(num_cols=600, num_rows=200)
+        for use_threads in (True, False):
+            read_options = pf.ReadOptions(use_threads=use_threads,
+                                          block_size=50000)
+            table = read_bytes(fwf, parse_options, read_options=read_options)
+            assert table.schema == expected.schema
+            assert table.equals(expected)
+            assert table.column(0).data.num_chunks > 1
+
+    def test_zoned_blanks(self):
+        # Zoned values padded with blanks on either side, or blank (null)
+        rows = (b'a    b    \r\n'
+                b'  12J  -12\r\n'
+                b'12J  -12  \r\n'
+                b'     +7   ')
+        parse_options = pf.ParseOptions([5, 5])
+        convert_options = pf.ConvertOptions(
+            column_types={'a': pa.int64(), 'b': pa.int64()},
+            column_options={
+                'a': pf.ColumnConvertOptions(numeric_encoding='zoned',
+                                             numeric_sign='trailing'),
+                'b': pf.ColumnConvertOptions(numeric_encoding='zoned',
+                                             numeric_sign='leading_separate')})
+        table = read_bytes(rows, parse_options,
+                           convert_options=convert_options)
+        assert table.to_pydict() == {'a': [-121, -121, None],
+                                     'b': [-12, -12, 7]}
+
+        # The digit 5 overpunched with either sign
+        rows = b'a  b  \r\n12EN12\r\nE  N  '
+        parse_options = pf.ParseOptions([3, 3])
+        convert_options = pf.ConvertOptions(
+            column_types={'a': pa.int64(), 'b': pa.int64()},
+            column_options={
+                'a': pf.ColumnConvertOptions(numeric_encoding='zoned',
+                                             numeric_sign='trailing'),
+                'b': pf.ColumnConvertOptions(numeric_encoding='zoned',
+                                             numeric_sign='leading')})
+        table = read_bytes(rows, parse_options,
+                           convert_options=convert_options)
+        assert table.to_pydict() == {'a': [125, 5], 'b': [-512, -5]}
@@ -12,7 +12,10 @@
 #ifndef FWFR_API_H
 #define FWFR_API_H
 
+#include <fwfr/cache.h>
+#include <fwfr/copybook.h>
 #include <fwfr/options.h>
 #include <fwfr/reader.h>
+#include <fwfr/scheduler.h>
 
 #endif  // FWFR_API_H
@@ -0,0 +1,105 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/block-sizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <utility>
+
+#include <fwfr/forwarding-task-group.h>
+
+namespace fwfr {
+
+constexpr int64_t BlockSizer::kTargetTaskTime;
+
+int64_t BlockSizer::NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Task group timing its tasks
+
+class TimedTaskGroup : public ForwardingTaskGroup {
+ public:
+  TimedTaskGroup(BlockSizer* sizer, std::shared_ptr<arrow::internal::TaskGroup> task_group)
+      : ForwardingTaskGroup(std::move(task_group)), sizer_(sizer) {}
+
+ protected:
+  std::function<arrow::Status()> Wrap(std::function<arrow::Status()> task) override {
+    BlockSizer* sizer = sizer_;
+    return [sizer, task]() {
+      const int64_t start = BlockSizer::NowNanos();
+      arrow::Status status = task();
+      sizer->task_time_ += BlockSizer::NowNanos() - start;
+      return status;
+    };
+  }
+
+  BlockSizer* sizer_;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// BlockSizer
+
+BlockSizer::BlockSizer(int64_t min_size, int64_t max_size, int32_t parallelism,
+                       int64_t total_size)
+    : min_size_(std::min(min_size, max_size)),
+      max_size_(max_size),
+      parallelism_(std::max(parallelism, 1)),
+      total_size_(total_size),
+      // Spread a first block over all workers
+      chunk_size_(std::max(min_size_, max_size / parallelism_)) {}
+
+void BlockSizer::SetTotalSize(int64_t total_size) { total_size_ = total_size; }
+
+int64_t BlockSizer::NextChunkSize(int64_t consumed) {
+  const int64_t parsed_bytes = parsed_bytes_;
+  if (parsed_chunks_ >= parallelism_ && parsed_bytes > 0) {
+    // Worker and reading thread time per byte.  Conversion tasks of the last
+    // chunks may still be running, which only delays their share.
+    const double worker_time = static_cast<double>(task_time_) / parsed_bytes;
+    const double reader_time = static_cast<double>(read_time_ + chunk_time_) /
+                               std::max<int64_t>(consumed, 1);
+    int64_t size = worker_time > 0
+                       ? static_cast<int64_t>(kTargetTaskTime / worker_time)
+                       : max_size_;
+    if (reader_time * parallelism_ > worker_time) {
+      // Workers are waiting on the reading thread whatever the size
+      size = std::max(size, 2 * chunk_size_);
+    }
+    chunk_size_ = std::max(min_size_, std::min(max_size_, size));
+  }
+
+  int64_t size = chunk_size_;
+  if (total_size_ >= 0) {
+    // Spread the rest of the input over all workers, in chunks of at least
+    // min_size unless the input is small
+    const int64_t floor_size =
+        std::min(min_size_, (total_size_ + parallelism_ - 1) / parallelism_);
+    const int64_t remaining = std::max<int64_t>(total_size_ - consumed, 0);
+    size = std::min(size, std::max(floor_size, (remaining + parallelism_ - 1) /
+                                                   parallelism_));
+  }
+  return std::max<int64_t>(size, 1);
+}
+
+std::shared_ptr<arrow::internal::TaskGroup> BlockSizer::WrapTaskGroup(
+    const std::shared_ptr<arrow::internal::TaskGroup>& task_group) {
+  // The task group is used by the read, which holds the sizer until all
+  // tasks have finished
+  return std::make_shared<TimedTaskGroup>(this, task_group);
+}
+
+}  // namespace fwfr
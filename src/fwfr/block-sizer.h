@@ -0,0 +1,97 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_BLOCK_SIZER_H
+#define FWFR_BLOCK_SIZER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    namespace internal {
+        class TaskGroup;
+    }
+}
+
+namespace fwfr {
+
+/// \class BlockSizer
+/// \brief Picks the size of the chunks a threaded read hands to its workers
+///
+/// The reading thread reads the input in blocks of max_size bytes and cuts
+/// them into chunks, each parsed then converted by tasks on the workers.
+/// Chunks are sized so that the tasks of one take about kTargetTaskTime,
+/// going by the worker time per byte measured so far (parsing and
+/// converting, over all columns): short enough that
+/// the last chunks are spread over all workers and few bytes are in flight,
+/// long enough that the cost of each task stays small.  While the reading
+/// thread is the bottleneck, so that smaller chunks would not keep more
+/// workers busy, chunks grow instead.  Sizes stay within [min_size,
+/// max_size], except that an input smaller than parallelism chunks of
+/// min_size is split into parallelism chunks.
+class ARROW_EXPORT BlockSizer {
+ public:
+  // Worker time aimed at per chunk
+  static constexpr int64_t kTargetTaskTime = 20 * 1000 * 1000;  // 20 ms
+
+  /// total_size is the size of the input, or -1 if unknown
+  BlockSizer(int64_t min_size, int64_t max_size, int32_t parallelism, int64_t total_size);
+
+  /// \brief Set the size of the input, once known
+  void SetTotalSize(int64_t total_size);
+
+  /// \brief Return the size of the next chunk, consumed bytes of the input
+  /// being already handed out
+  int64_t NextChunkSize(int64_t consumed);
+
+  /// Time the reading thread waited for input blocks
+  void AddReadTime(int64_t nanos) { read_time_ += nanos; }
+  /// Time the reading thread took to find the end of a chunk
+  void AddChunkTime(int64_t nanos) { chunk_time_ += nanos; }
+  /// Bytes of a chunk parsed by a worker
+  void AddParsedChunk(int64_t bytes) {
+    parsed_bytes_ += bytes;
+    ++parsed_chunks_;
+  }
+
+  /// \brief Wrap a task group so that the run time of its tasks counts as
+  /// worker time
+  std::shared_ptr<arrow::internal::TaskGroup> WrapTaskGroup(
+      const std::shared_ptr<arrow::internal::TaskGroup>& task_group);
+
+  /// Current chunk size
+  int64_t chunk_size() const { return chunk_size_; }
+
+  static int64_t NowNanos();
+
+ protected:
+  friend class TimedTaskGroup;
+
+  const int64_t min_size_;
+  const int64_t max_size_;
+  const int32_t parallelism_;
+  int64_t total_size_;
+  // Only used by the reading thread
+  int64_t chunk_size_;
+
+  std::atomic<int64_t> read_time_{0};
+  std::atomic<int64_t> chunk_time_{0};
+  std::atomic<int64_t> task_time_{0};
+  std::atomic<int64_t> parsed_bytes_{0};
+  std::atomic<int64_t> parsed_chunks_{0};
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_BLOCK_SIZER_H
@@ -0,0 +1,123 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/buffer-pool.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace fwfr {
+
+constexpr int64_t BufferPool::kMinRecycledSize;
+
+std::shared_ptr<BufferPool> BufferPool::Make(arrow::MemoryPool* pool,
+                                             int64_t max_pooled_bytes) {
+  return Adopt(new BufferPool(pool, max_pooled_bytes));
+}
+
+int64_t BufferPool::SizeClass(int64_t size) {
+  if (size < kMinRecycledSize) {
+    return size;
+  }
+  // Round up to an eighth of the highest power of two in size
+  int64_t step = 1;
+  while (step <= size / 8) {
+    step *= 2;
+  }
+  return (size + step - 1) / step * step;
+}
+
+arrow::Status BufferPool::Allocate(int64_t size, uint8_t** out) {
+  const int64_t size_class = SizeClass(size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AddAllocation(size_class);
+    auto it = free_buffers_.find(size_class);
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      *out = it->second.back();
+      it->second.pop_back();
+      pooled_bytes_ -= size_class;
+      reused_bytes_ += size_class;
+      return arrow::Status::OK();
+    }
+  }
+  arrow::Status status = pool_->Allocate(size_class, out);
+  if (!status.ok()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RemoveAllocation(size_class);
+  }
+  return status;
+}
+
+arrow::Status BufferPool::Reallocate(int64_t old_size, int64_t new_size,
+                                     uint8_t** ptr) {
+  const int64_t old_class = SizeClass(old_size);
+  const int64_t new_class = SizeClass(new_size);
+  if (old_class == new_class) {
+    // The buffer already has the room
+    return arrow::Status::OK();
+  }
+  if (old_size < kMinRecycledSize && new_size < kMinRecycledSize) {
+    RETURN_NOT_OK(pool_->Reallocate(old_size, new_size, ptr));
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResizeAllocation(new_size - old_size);
+    return arrow::Status::OK();
+  }
+  // Move to a buffer of the new class, so the old one can be recycled
+  uint8_t* new_buffer;
+  RETURN_NOT_OK(Allocate(new_size, &new_buffer));
+  std::memcpy(new_buffer, *ptr, static_cast<size_t>(std::min(old_size, new_size)));
+  Free(*ptr, old_size);
+  *ptr = new_buffer;
+  return arrow::Status::OK();
+}
+
+void BufferPool::Free(uint8_t* buffer, int64_t size) {
+  const int64_t size_class = SizeClass(size);
+  std::unique_lock<std::mutex> lock(mutex_);
+  RemoveAllocation(size_class);
+  if (size >= kMinRecycledSize && !released_ &&
+      pooled_bytes_ + size_class <= max_pooled_bytes_) {
+    free_buffers_[size_class].push_back(buffer);
+    pooled_bytes_ += size_class;
+    peak_pooled_bytes_ = std::max(peak_pooled_bytes_, pooled_bytes_);
+  } else {
+    pool_->Free(buffer, size_class);
+  }
+  MaybeDelete(&lock);
+}
+
+int64_t BufferPool::pooled_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pooled_bytes_;
+}
+
+int64_t BufferPool::peak_pooled_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return peak_pooled_bytes_;
+}
+
+int64_t BufferPool::reused_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reused_bytes_;
+}
+
+void BufferPool::OnReleased() {
+  for (auto& free_buffers : free_buffers_) {
+    for (uint8_t* buffer : free_buffers.second) {
+      pool_->Free(buffer, free_buffers.first);
+    }
+  }
+  free_buffers_.clear();
+  pooled_bytes_ = 0;
+}
+
+}  // namespace fwfr
@@ -0,0 +1,84 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_BUFFER_POOL_H
+#define FWFR_BUFFER_POOL_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+#include <fwfr/counting-pool.h>
+
+namespace fwfr {
+
+/// \class BufferPool
+/// \brief Memory pool recycling the large buffers of a read
+///
+/// Every block allocates and frees buffers of about the same sizes: the
+/// readahead buffer, and the values and parsed data of its parser.  Rather
+/// than handing them back to the allocator, which unmaps large buffers so
+/// that the next block faults their pages in again, freed buffers of at
+/// least kMinRecycledSize bytes are kept for the next allocation of their
+/// size class, up to max_pooled_bytes.  Size classes are spaced eight per
+/// power of two, so a buffer is at most 12.5% larger than asked for, and a
+/// buffer resized within its class keeps its memory.  Once the read is
+/// done (the pointer returned by Make() is gone), buffers are not kept
+/// anymore.  bytes_allocated() counts the buffers handed out, rounded up to
+/// their size class.
+class ARROW_EXPORT BufferPool : public CountingPool {
+ public:
+  static constexpr int64_t kMinRecycledSize = 64 * 1024;
+
+  /// \brief Make a buffer pool over pool, keeping at most max_pooled_bytes
+  /// of freed buffers
+  static std::shared_ptr<BufferPool> Make(arrow::MemoryPool* pool,
+                                          int64_t max_pooled_bytes);
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  /// Bytes of freed buffers kept for reuse
+  int64_t pooled_bytes() const;
+  /// Peak of pooled_bytes()
+  int64_t peak_pooled_bytes() const;
+  /// Bytes of the allocations served from kept buffers so far
+  int64_t reused_bytes() const;
+
+ protected:
+  BufferPool(arrow::MemoryPool* pool, int64_t max_pooled_bytes)
+      : CountingPool(pool), max_pooled_bytes_(max_pooled_bytes) {}
+
+  // Size actually allocated for size bytes
+  static int64_t SizeClass(int64_t size);
+
+  // Free the pooled buffers once the read is done
+  void OnReleased() override;
+
+  // Cap on pooled_bytes_
+  const int64_t max_pooled_bytes_;
+
+  // Freed buffers, by size class
+  std::map<int64_t, std::vector<uint8_t*>> free_buffers_;
+  int64_t pooled_bytes_ = 0;
+  int64_t peak_pooled_bytes_ = 0;
+  int64_t reused_bytes_ = 0;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_BUFFER_POOL_H
@@ -0,0 +1,392 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/cache.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <fwfr/reader.h>
+
+#include <arrow/buffer.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/type.h>
+#include <arrow/util/key_value_metadata.h>
+
+namespace fwfr {
+
+CacheOptions CacheOptions::Defaults() { return CacheOptions(); }
+
+// Part of every key: bump it when the cached tables of the same file and
+// options may change, so that older entries are no longer hit
+static constexpr char kCacheVersion[] = "fwfr-cache-1";
+// Schema metadata holding the key of a cached table
+static constexpr char kCacheKeyMetadata[] = "fwfr.cache_key";
+// File contents are hashed 1 MB at a time
+static constexpr int64_t kHashChunkSize = 1 << 20;
+
+static constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+static constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+static inline uint64_t HashBytes(const uint8_t* data, int64_t size, uint64_t hash) {
+  // 64-bit FNV-1a
+  for (int64_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Cache keys
+
+// The serialized fingerprint of a file and options.  Every value is
+// length-prefixed, so that distinct inputs never serialize alike; the whole
+// key is stored with the cached table to rule out hash collisions.
+class CacheKey {
+ public:
+  void Add(const std::string& value) {
+    key_ += std::to_string(value.size());
+    key_ += ':';
+    key_ += value;
+  }
+
+  void Add(const char* value) { Add(std::string(value)); }
+
+  void Add(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    Add(std::string(buffer));
+  }
+
+  template <typename T>
+  void AddInt(T value) {
+    Add(std::to_string(static_cast<int64_t>(value)));
+  }
+
+  template <typename T>
+  void AddInts(const std::vector<T>& values) {
+    AddInt(values.size());
+    for (const auto& value : values) {
+      AddInt(value);
+    }
+  }
+
+  void AddStrings(const std::vector<std::string>& values) {
+    AddInt(values.size());
+    for (const auto& value : values) {
+      Add(value);
+    }
+  }
+
+  void AddReadOptions(const ReadOptions& options) {
+    // use_threads, the block sizes and output_chunk_rows only change how
+    // the table is chunked, and are left out so that reads differing only in
+    // them share an entry: a hit returns the table chunked as the read that
+    // cached it was, whatever chunking the current options would give
+    Add(options.encoding);
+    AddInt(options.decompress);
+    AddInt(options.skip_rows);
+    AddStrings(options.column_names);
+    AddInt(options.raw_records);
+    AddStrings(options.raw_key_columns);
+    AddInt(options.predicates.size());
+    for (const auto& predicate : options.predicates) {
+      Add(predicate.column);
+      AddInt(predicate.kind);
+      AddStrings(predicate.values);
+      Add(predicate.min);
+      Add(predicate.max);
+    }
+  }
+
+  void AddParseOptions(const ParseOptions& options) {
+    AddInts(options.field_widths);
+    AddInt(options.newlines_in_values);
+    AddInt(options.ignore_empty_lines);
+    AddInts(options.skip_columns);
+    AddInt(options.record_format);
+    AddInt(options.layouts.size());
+    for (const auto& layout : options.layouts) {
+      Add(layout.type_code);
+      AddInts(layout.field_widths);
+      AddInts(layout.skip_columns);
+      AddStrings(layout.column_names);
+    }
+    AddInt(options.type_code_offset);
+  }
+
+  void AddConvertOptions(const ConvertOptions& options) {
+    // Maps are added in key order
+    std::vector<std::pair<std::string, std::string>> column_types;
+    for (const auto& item : options.column_types) {
+      column_types.emplace_back(item.first, item.second->ToString());
+    }
+    std::sort(column_types.begin(), column_types.end());
+    AddInt(column_types.size());
+    for (const auto& item : column_types) {
+      Add(item.first);
+      Add(item.second);
+    }
+    AddInt(options.is_cobol);
+    AddCharMap(options.pos_values);
+    AddCharMap(options.neg_values);
+    AddStrings(options.null_values);
+    AddStrings(options.true_values);
+    AddStrings(options.false_values);
+    AddInt(options.implied_decimals);
+    AddInt(options.strings_can_be_null);
+    AddInt(options.numeric_format.encoding);
+    AddInt(options.numeric_format.sign);
+    AddInt(options.large_strings);
+
+    std::vector<std::string> names;
+    for (const auto& item : options.column_options) {
+      names.push_back(item.first);
+    }
+    std::sort(names.begin(), names.end());
+    AddInt(names.size());
+    for (const auto& name : names) {
+      Add(name);
+      AddColumnOptions(options.column_options.at(name));
+    }
+    std::vector<int32_t> indices;
+    for (const auto& item : options.column_index_options) {
+      indices.push_back(item.first);
+    }
+    std::sort(indices.begin(), indices.end());
+    AddInt(indices.size());
+    for (const auto index : indices) {
+      AddInt(index);
+      AddColumnOptions(options.column_index_options.at(index));
+    }
+  }
+
+  const std::string& key() const { return key_; }
+
+  uint64_t Hash() const {
+    return HashBytes(reinterpret_cast<const uint8_t*>(key_.data()),
+                     static_cast<int64_t>(key_.size()), kFnvOffsetBasis);
+  }
+
+ private:
+  void AddCharMap(const std::unordered_map<char, char>& values) {
+    std::vector<std::pair<char, char>> items(values.begin(), values.end());
+    std::sort(items.begin(), items.end());
+    AddInt(items.size());
+    for (const auto& item : items) {
+      Add(std::string{item.first, item.second});
+    }
+  }
+
+  void AddColumnOptions(const ColumnConvertOptions& options) {
+    AddInt(options.is_cobol);
+    AddStrings(options.null_values);
+    AddStrings(options.true_values);
+    AddStrings(options.false_values);
+    AddInt(options.implied_decimals);
+    AddInt(options.strings_can_be_null);
+    AddInt(options.numeric_format.encoding);
+    AddInt(options.numeric_format.sign);
+  }
+
+  std::string key_;
+};
+
+static arrow::Status HashContents(arrow::MemoryPool* pool, const std::string& path,
+                                  uint64_t* out) {
+  std::shared_ptr<arrow::io::ReadableFile> file;
+  RETURN_NOT_OK(arrow::io::ReadableFile::Open(path, pool, &file));
+  uint64_t hash = kFnvOffsetBasis;
+  while (true) {
+    std::shared_ptr<arrow::Buffer> buffer;
+    RETURN_NOT_OK(file->Read(kHashChunkSize, &buffer));
+    if (buffer->size() == 0) {
+      break;
+    }
+    hash = HashBytes(buffer->data(), buffer->size(), hash);
+  }
+  *out = hash;
+  return file->Close();
+}
+
+static std::string ToHex(uint64_t value) {
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx",
+                static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Cached tables
+
+// Memory-map the cached table at path, or leave out null if there is none
+// for this key
+static arrow::Status OpenCached(const std::string& path, const std::string& key,
+                                std::shared_ptr<arrow::Table>* out) {
+  out->reset();
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::io::MemoryMappedFile> file;
+  RETURN_NOT_OK(
+      arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ, &file));
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader;
+  RETURN_NOT_OK(arrow::ipc::RecordBatchFileReader::Open(file, &reader));
+
+  // A different key hashing alike
+  const auto metadata = reader->schema()->metadata();
+  if (metadata == nullptr) {
+    return arrow::Status::OK();
+  }
+  const int index = metadata->FindKey(kCacheKeyMetadata);
+  if (index < 0 || metadata->value(index) != key) {
+    return arrow::Status::OK();
+  }
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  for (int i = 0; i < reader->num_record_batches(); ++i) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    RETURN_NOT_OK(reader->ReadRecordBatch(i, &batch));
+    batches.push_back(batch);
+  }
+  std::shared_ptr<arrow::Table> table;
+  RETURN_NOT_OK(arrow::Table::FromRecordBatches(reader->schema(), batches, &table));
+  *out = table->ReplaceSchemaMetadata(nullptr);
+  return arrow::Status::OK();
+}
+
+static arrow::Status WriteTable(const std::string& path, const std::string& key,
+                                const arrow::Table& table) {
+  auto metadata = std::make_shared<arrow::KeyValueMetadata>(
+      std::vector<std::string>{kCacheKeyMetadata}, std::vector<std::string>{key});
+  const auto schema = table.schema()->AddMetadata(metadata);
+
+  std::shared_ptr<arrow::io::OutputStream> sink;
+  RETURN_NOT_OK(arrow::io::FileOutputStream::Open(path, &sink));
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  RETURN_NOT_OK(arrow::ipc::RecordBatchFileWriter::Open(sink.get(), schema, &writer));
+  arrow::TableBatchReader reader(table);
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    RETURN_NOT_OK(reader.ReadNext(&batch));
+    if (!batch) {
+      break;
+    }
+    RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  }
+  RETURN_NOT_OK(writer->Close());
+  return sink->Close();
+}
+
+// Write the table to a temporary file, then rename it to path
+static arrow::Status WriteCached(const std::string& path, const std::string& key,
+                                 const arrow::Table& table) {
+  std::random_device random;
+  const std::string temp_path = path + ".tmp-" + std::to_string(getpid()) + "-" +
+                                ToHex((static_cast<uint64_t>(random()) << 32) ^ random());
+
+  arrow::Status status = WriteTable(temp_path, key, table);
+  if (status.ok() && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    status = arrow::Status::IOError("Cannot rename '", temp_path, "' to '", path,
+                                    "': ", std::strerror(errno));
+  }
+  if (!status.ok()) {
+    std::remove(temp_path.c_str());
+  }
+  return status;
+}
+
+arrow::Status ReadCachedTable(arrow::MemoryPool* pool, const std::string& path,
+                              const ReadOptions& read_options,
+                              const ParseOptions& parse_options,
+                              const ConvertOptions& convert_options,
+                              const CacheOptions& cache_options,
+                              std::shared_ptr<arrow::Table>* out) {
+  if (cache_options.directory.empty()) {
+    return arrow::Status::Invalid("The cache directory must be set");
+  }
+
+  // Fingerprint the file, then the options
+  char* real_path = realpath(path.c_str(), nullptr);
+  if (real_path == nullptr) {
+    return arrow::Status::IOError("Cannot resolve '", path, "': ", std::strerror(errno));
+  }
+  CacheKey key;
+  key.Add(kCacheVersion);
+  key.Add(real_path);
+  std::free(real_path);
+
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return arrow::Status::IOError("Cannot stat '", path, "': ", std::strerror(errno));
+  }
+  key.AddInt(info.st_size);
+#ifdef __APPLE__
+  key.AddInt(info.st_mtimespec.tv_sec);
+  key.AddInt(info.st_mtimespec.tv_nsec);
+#else
+  key.AddInt(info.st_mtim.tv_sec);
+  key.AddInt(info.st_mtim.tv_nsec);
+#endif
+  if (cache_options.hash_contents) {
+    uint64_t hash;
+    RETURN_NOT_OK(HashContents(pool, path, &hash));
+    key.Add(ToHex(hash));
+  } else {
+    key.Add("");
+  }
+  key.AddReadOptions(read_options);
+  key.AddParseOptions(parse_options);
+  key.AddConvertOptions(convert_options);
+
+  const std::string cache_path =
+      cache_options.directory + "/" + ToHex(key.Hash()) + ".arrow";
+  // The cache is best-effort: an entry that cannot be read is dropped and
+  // the file read again
+  if (!OpenCached(cache_path, key.key(), out).ok()) {
+    out->reset();
+    std::remove(cache_path.c_str());
+  }
+  if (*out != nullptr) {
+    return arrow::Status::OK();
+  }
+
+  // Miss: read the file, and cache the table
+  std::shared_ptr<arrow::io::ReadableFile> file;
+  RETURN_NOT_OK(arrow::io::ReadableFile::Open(path, pool, &file));
+  std::shared_ptr<TableReader> reader;
+  RETURN_NOT_OK(TableReader::Make(pool, file, read_options, parse_options,
+                                  convert_options, &reader));
+  std::shared_ptr<arrow::Table> table;
+  RETURN_NOT_OK(reader->Read(&table));
+  // A table that cannot be cached (read-only or full directory) is still
+  // returned
+  ARROW_UNUSED(WriteCached(cache_path, key.key(), *table));
+  *out = table;
+  return arrow::Status::OK();
+}
+
+}  // namespace fwfr
@@ -0,0 +1,65 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_CACHE_H
+#define FWFR_CACHE_H
+
+#include <memory>
+#include <string>
+
+#include <fwfr/options.h>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    class MemoryPool;
+    class Table;
+}
+
+namespace fwfr {
+
+struct ARROW_EXPORT CacheOptions {
+  // Result cache options
+
+  // Directory holding the cached tables, as Arrow IPC files -- REQUIRED
+  std::string directory;
+  // Whether to fingerprint the file contents too, rather than trusting its
+  // size and modification time alone.  This reads the whole file on every
+  // lookup, which is still far cheaper than parsing it.
+  bool hash_contents = false;
+
+  static CacheOptions Defaults();
+};
+
+/// \brief Read a table from a file, through a cache of previous results
+///
+/// Entries are keyed by a fingerprint of the file (absolute path, size,
+/// modification time and optionally a hash of its contents) and of every
+/// read, parse and convert option.  On a hit, the cached Arrow IPC file is
+/// memory-mapped, so the table's buffers are read without copying.  On a
+/// miss, the file is read as by TableReader::Read and the table is written
+/// to the cache, through a temporary file renamed into place so that
+/// concurrent readers only ever see complete entries.  Stale entries are
+/// never reused, but not removed either.  The cache is best-effort: an
+/// entry that cannot be read is removed and the file read again, and a
+/// table that cannot be written to the cache is still returned.
+ARROW_EXPORT arrow::Status ReadCachedTable(arrow::MemoryPool* pool,
+                                           const std::string& path,
+                                           const ReadOptions& read_options,
+                                           const ParseOptions& parse_options,
+                                           const ConvertOptions& convert_options,
+                                           const CacheOptions& cache_options,
+                                           std::shared_ptr<arrow::Table>* out);
+
+}  // namespace fwfr
+
+#endif  // FWFR_CACHE_H
@@ -30,7 +30,7 @@ namespace {
 
 // Find the last newline character in the given data block.
 // nullptr is returned if not found (like memchr()).
-const char* FindNewlineReverse(const char* data, uint32_t size) {
+const char* FindNewlineReverse(const char* data, int64_t size) {
   if (size == 0) {
     return nullptr;
   }
@@ -90,7 +90,7 @@ AbortLine:
   return nullptr;
 }
 
-arrow::Status Chunker::Process(const char* start, uint32_t size, uint32_t* out_size) {
+arrow::Status Chunker::Process(const char* start, int64_t size, int64_t* out_size) {
   if (!options_.newlines_in_values) {
     // If newlines are not accepted in FWF values, we can simply search for
     // the last newline character.
@@ -101,7 +101,7 @@ arrow::Status Chunker::Process(const char* start, uint32_t size, uint32_t* out_s
     if (nl == nullptr) {
       *out_size = 0;
     } else {
-      *out_size = static_cast<uint32_t>(nl - start + 1);
+      *out_size = static_cast<int64_t>(nl - start + 1);
     }
     return arrow::Status::OK();
   }
@@ -116,7 +116,7 @@ arrow::Status Chunker::Process(const char* start, uint32_t size, uint32_t* out_s
     }
     data = line_end;
   }
-  *out_size = static_cast<uint32_t>(data - start);
+  *out_size = static_cast<int64_t>(data - start);
   return arrow::Status::OK();
 }
 
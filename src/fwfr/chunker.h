@@ -55,7 +55,7 @@ class ARROW_EXPORT Chunker {
   ///
   /// Process a block of FWF data, reading up to size bytes.
   /// The number of bytes in the chunk is returned in out_size.
-  arrow::Status Process(const char* data, uint32_t size, uint32_t* out_size);
+  arrow::Status Process(const char* data, int64_t size, int64_t* out_size);
 
  protected:
   ARROW_DISALLOW_COPY_AND_ASSIGN(Chunker);
@@ -24,6 +24,16 @@
 
 #include <fwfr/column-builder.h>
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+
+#include <arrow/array/concatenate.h>
+#include <arrow/io/file.h>
+
 namespace fwfr {
 
 class BlockParser;
@@ -35,10 +45,44 @@ void ColumnBuilder::SetTaskGroup(
   task_group_ = task_group;
 }
 
+constexpr int64_t ColumnBuilder::kValuesPerTask;
+
 void ColumnBuilder::Append(const std::shared_ptr<BlockParser>& parser) {
   Insert(static_cast<int64_t>(chunks_.size()), parser);
 }
 
+void ColumnBuilder::Insert(int64_t block_index,
+                           const std::shared_ptr<BlockParser>& parser) {
+  PrepareBlock(block_index, parser);
+  // We're careful that all references in the closure outlive the Append() call
+  task_group_->Append([=]() { return ConvertBlock(block_index, parser); });
+}
+
+void ColumnBuilder::InsertColumns(
+    const std::vector<std::shared_ptr<ColumnBuilder>>& builders, int64_t block_index,
+    const std::shared_ptr<BlockParser>& parser) {
+  for (const auto& builder : builders) {
+    builder->PrepareBlock(block_index, parser);
+  }
+  const int64_t num_rows = std::max<int64_t>(parser->num_rows(), 1);
+  const size_t columns_per_task =
+      static_cast<size_t>(std::max<int64_t>(kValuesPerTask / num_rows, 1));
+  for (size_t begin = 0; begin < builders.size(); begin += columns_per_task) {
+    const size_t end = std::min(builders.size(), begin + columns_per_task);
+    // As with Insert(), the builders outlive their tasks
+    std::vector<ColumnBuilder*> batch;
+    for (size_t i = begin; i < end; ++i) {
+      batch.push_back(builders[i].get());
+    }
+    builders[begin]->task_group_->Append([=]() -> arrow::Status {
+      for (ColumnBuilder* builder : batch) {
+        RETURN_NOT_OK(builder->ConvertBlock(block_index, parser));
+      }
+      return arrow::Status::OK();
+    });
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Pre-typed column builder implementation
 
@@ -55,10 +99,14 @@ class TypedColumnBuilder : public ColumnBuilder {
 
   arrow::Status Init();
 
-  void Insert(int64_t block_index, const std::shared_ptr<BlockParser>& parser) override;
   arrow::Status Finish(std::shared_ptr<arrow::ChunkedArray>* out) override;
 
  protected:
+  void PrepareBlock(int64_t block_index,
+                    const std::shared_ptr<BlockParser>& parser) override;
+  arrow::Status ConvertBlock(int64_t block_index,
+                             const std::shared_ptr<BlockParser>& parser) override;
+
   arrow::Status WrapConversionError(const arrow::Status& st) {
     if (st.ok()) {
       return st;
@@ -83,31 +131,30 @@ arrow::Status TypedColumnBuilder::Init() {
   return Converter::Make(type_, options_, pool_, &converter_);
 }
 
-void TypedColumnBuilder::Insert(int64_t block_index,
-                                const std::shared_ptr<BlockParser>& parser) {
+void TypedColumnBuilder::PrepareBlock(int64_t block_index,
+                                      const std::shared_ptr<BlockParser>& parser) {
   DCHECK_NE(converter_, nullptr);
 
-  // Create a null Array pointer at the back at the list
-  // and spawn a task to initialize it after conversion
+  // Create a null Array pointer at the back at the list, to be initialized
+  // after conversion
   size_t chunk_index = static_cast<size_t>(block_index);
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (chunks_.size() <= chunk_index) {
-      chunks_.resize(chunk_index + 1);
-    }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (chunks_.size() <= chunk_index) {
+    chunks_.resize(chunk_index + 1);
   }
+}
 
-  // We're careful that all references in the closure outlive the Append() call
-  task_group_->Append([=]() -> arrow::Status {
-    std::shared_ptr<arrow::Array> res;
-    RETURN_NOT_OK(WrapConversionError(converter_->Convert(*parser, col_index_, &res)));
+arrow::Status TypedColumnBuilder::ConvertBlock(
+    int64_t block_index, const std::shared_ptr<BlockParser>& parser) {
+  size_t chunk_index = static_cast<size_t>(block_index);
+  std::shared_ptr<arrow::Array> res;
+  RETURN_NOT_OK(WrapConversionError(converter_->Convert(*parser, col_index_, &res)));
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    // Should not insert an already converted chunk
-    DCHECK_EQ(chunks_[chunk_index], nullptr);
-    chunks_[chunk_index] = std::move(res);
-    return arrow::Status::OK();
-  });
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Should not insert an already converted chunk
+  DCHECK_EQ(chunks_[chunk_index], nullptr);
+  chunks_[chunk_index] = std::move(res);
+  return arrow::Status::OK();
 }
 
 arrow::Status TypedColumnBuilder::Finish(std::shared_ptr<arrow::ChunkedArray>* out) {
@@ -138,12 +185,21 @@ class InferringColumnBuilder : public ColumnBuilder {
 
   arrow::Status Init();
 
-  void Insert(int64_t block_index, const std::shared_ptr<BlockParser>& parser) override;
   arrow::Status Finish(std::shared_ptr<arrow::ChunkedArray>* out) override;
 
  protected:
+  void PrepareBlock(int64_t block_index,
+                    const std::shared_ptr<BlockParser>& parser) override;
+  arrow::Status ConvertBlock(int64_t block_index,
+                             const std::shared_ptr<BlockParser>& parser) override {
+    return TryConvertChunk(static_cast<size_t>(block_index));
+  }
+
   arrow::Status LoosenType();
   arrow::Status UpdateType();
+  void LockType();
+  arrow::Status SpillChunk(size_t chunk_index, const BlockParser& parser);
+  arrow::Status ReadSpilledChunk(size_t chunk_index, std::shared_ptr<BlockParser>* out);
   arrow::Status TryConvertChunk(size_t chunk_index);
   // This must be called unlocked!
   void ScheduleConvertChunk(size_t chunk_index);
@@ -161,12 +217,35 @@ class InferringColumnBuilder : public ColumnBuilder {
   std::shared_ptr<arrow::DataType> infer_type_;
   InferKind infer_kind_;
   bool can_loosen_type_;
+  // Whether the type was locked by ConvertOptions::inference_blocks
+  bool locked_ = false;
+  // Chunks converted to the current type
+  int32_t num_converted_ = 0;
 
   // The parsers corresponding to each chunk (for reconverting)
   std::vector<std::shared_ptr<BlockParser>> parsers_;
+
+  // Spilled chunks: where each chunk's values are in the spill file, if
+  // its parser was released after spilling them
+  struct SpilledChunk {
+    int64_t position = -1;
+    int64_t size = 0;
+  };
+  std::vector<SpilledChunk> spilled_;
+  // The spill file, opened on first use and already unlinked, so that it
+  // goes away with the builder
+  std::mutex spill_mutex_;
+  std::shared_ptr<arrow::io::OutputStream> spill_out_;
+  std::shared_ptr<arrow::io::ReadableFile> spill_in_;
+  int64_t spill_size_ = 0;
+  uint32_t column_width_ = 0;
 };
 
 arrow::Status InferringColumnBuilder::Init() {
+  // Fail now if the string types are not available, rather than once the
+  // column turns out to hold text
+  std::shared_ptr<arrow::DataType> string_type;
+  RETURN_NOT_OK(InferredStringType(options_, false, &string_type));
   infer_kind_ = InferKind::Null;
   return UpdateType();
 }
@@ -175,6 +254,7 @@ arrow::Status InferringColumnBuilder::LoosenType() {
   // We are locked
 
   DCHECK(can_loosen_type_);
+  num_converted_ = 0;
   switch (infer_kind_) {
     case InferKind::Null:
       infer_kind_ = InferKind::Integer;
@@ -226,17 +306,76 @@ arrow::Status InferringColumnBuilder::UpdateType() {
       can_loosen_type_ = true;
       break;
     case InferKind::Text:
-      infer_type_ = arrow::utf8();
-      can_loosen_type_ = true;
+      // UTF8 is not validated, so any value fits and the Binary fallback is
+      // never needed
+      RETURN_NOT_OK(InferredStringType(options_, false, &infer_type_));
+      can_loosen_type_ = false;
       break;
     case InferKind::Binary:
-      infer_type_ = arrow::binary();
+      RETURN_NOT_OK(InferredStringType(options_, true, &infer_type_));
       can_loosen_type_ = false;
       break;
   }
   return Converter::Make(infer_type_, options_, pool_, &converter_);
 }
 
+void InferringColumnBuilder::LockType() {
+  // We are locked
+
+  can_loosen_type_ = false;
+  locked_ = true;
+  // Chunks being converted release their parser when done
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    if (chunks_[i]) {
+      parsers_[i].reset();
+    }
+  }
+}
+
+arrow::Status InferringColumnBuilder::SpillChunk(size_t chunk_index,
+                                                 const BlockParser& parser) {
+  int64_t position;
+  int64_t size;
+  {
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    if (!spill_out_) {
+      std::random_device random;
+      const std::string path = options_.inference_spill_directory + "/fwfr-spill-" +
+                               std::to_string(getpid()) + "-" +
+                               std::to_string(random()) + "-" + std::to_string(col_index_);
+      RETURN_NOT_OK(arrow::io::FileOutputStream::Open(path, &spill_out_));
+      arrow::Status status = arrow::io::ReadableFile::Open(path, pool_, &spill_in_);
+      std::remove(path.c_str());
+      RETURN_NOT_OK(status);
+      column_width_ = parser.column_width(col_index_);
+    }
+    position = spill_size_;
+    RETURN_NOT_OK(parser.WriteColumn(col_index_, spill_out_.get(), &size));
+    spill_size_ += size;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (spilled_.size() <= chunk_index) {
+    spilled_.resize(chunk_index + 1);
+  }
+  spilled_[chunk_index].position = position;
+  spilled_[chunk_index].size = size;
+  parsers_[chunk_index].reset();
+  return arrow::Status::OK();
+}
+
+arrow::Status InferringColumnBuilder::ReadSpilledChunk(
+    size_t chunk_index, std::shared_ptr<BlockParser>* out) {
+  SpilledChunk spilled;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DCHECK_LT(chunk_index, spilled_.size());
+    spilled = spilled_[chunk_index];
+  }
+  return BlockParser::ReadColumn(pool_, column_width_, spill_in_.get(), spilled.position,
+                                 spilled.size, out);
+}
+
 void InferringColumnBuilder::ScheduleConvertChunk(size_t chunk_index) {
   // We're careful that all values in the closure outlive the Append() call
   task_group_->Append([=]() { return TryConvertChunk(chunk_index); });
@@ -249,10 +388,14 @@ arrow::Status InferringColumnBuilder::TryConvertChunk(size_t chunk_index) {
   std::shared_ptr<arrow::Array> res;
   InferKind kind = infer_kind_;
 
-  DCHECK_NE(parser, nullptr);
-
   lock.unlock();
-  arrow::Status st = converter->Convert(*parser, col_index_, &res);
+  int32_t col_index = col_index_;
+  if (parser == nullptr) {
+    // The chunk's values were spilled: read them back, as the only column
+    RETURN_NOT_OK(ReadSpilledChunk(chunk_index, &parser));
+    col_index = 0;
+  }
+  arrow::Status st = converter->Convert(*parser, col_index, &res);
   lock.lock();
 
   if (kind != infer_kind_) {
@@ -265,9 +408,18 @@ arrow::Status InferringColumnBuilder::TryConvertChunk(size_t chunk_index) {
   if (st.ok()) {
     // Conversion succeeded
     chunks_[chunk_index] = std::move(res);
+    if (can_loosen_type_ && options_.inference_blocks > 0 &&
+        ++num_converted_ >= options_.inference_blocks) {
+      // The type held long enough
+      LockType();
+    }
     if (!can_loosen_type_) {
       // We won't try to reconvert anymore
       parsers_[chunk_index].reset();
+    } else if (!options_.inference_spill_directory.empty() && parsers_[chunk_index]) {
+      // Keep the values on disk rather than in memory
+      lock.unlock();
+      return SpillChunk(chunk_index, *parser);
     }
     return arrow::Status::OK();
   } else if (can_loosen_type_) {
@@ -293,32 +445,32 @@ arrow::Status InferringColumnBuilder::TryConvertChunk(size_t chunk_index) {
     ScheduleConvertChunk(chunk_index);
 
     return arrow::Status::OK();
+  } else if (locked_) {
+    return arrow::Status(st.code(), st.message() + " (type inferred from the first " +
+                                        std::to_string(options_.inference_blocks) +
+                                        " blocks)");
   } else {
     // Conversion failed but cannot loosen more
     return st;
   }
 }
 
-void InferringColumnBuilder::Insert(int64_t block_index,
-                                    const std::shared_ptr<BlockParser>& parser) {
-  // Create a slot for the new chunk and spawn a task to convert it
+void InferringColumnBuilder::PrepareBlock(int64_t block_index,
+                                          const std::shared_ptr<BlockParser>& parser) {
+  // Create a slot for the new chunk, keeping its parser for conversion
   size_t chunk_index = static_cast<size_t>(block_index);
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
 
-    DCHECK_NE(converter_, nullptr);
-    if (chunks_.size() <= chunk_index) {
-      chunks_.resize(chunk_index + 1);
-    }
-    if (parsers_.size() <= chunk_index) {
-      parsers_.resize(chunk_index + 1);
-    }
-    // Should not insert an already converting chunk
-    DCHECK_EQ(parsers_[chunk_index], nullptr);
-    parsers_[chunk_index] = parser;
+  DCHECK_NE(converter_, nullptr);
+  if (chunks_.size() <= chunk_index) {
+    chunks_.resize(chunk_index + 1);
   }
-
-  ScheduleConvertChunk(chunk_index);
+  if (parsers_.size() <= chunk_index) {
+    parsers_.resize(chunk_index + 1);
+  }
+  // Should not insert an already converting chunk
+  DCHECK_EQ(parsers_[chunk_index], nullptr);
+  parsers_[chunk_index] = parser;
 }
 
 arrow::Status InferringColumnBuilder::Finish(std::shared_ptr<arrow::ChunkedArray>* out) {
@@ -335,7 +487,75 @@ arrow::Status InferringColumnBuilder::Finish(std::shared_ptr<arrow::ChunkedArray
   *out = std::make_shared<arrow::ChunkedArray>(chunks_, infer_type_);
   chunks_.clear();
   parsers_.clear();
+  spilled_.clear();
+
+  return arrow::Status::OK();
+}
+
+////////////////////////////////////////////////////////////////////////
+// Output chunks
+
+static arrow::Status CoalesceChunks(const arrow::ChunkedArray& array, int64_t chunk_rows,
+                                    arrow::MemoryPool* pool,
+                                    std::shared_ptr<arrow::ChunkedArray>* out) {
+  arrow::ArrayVector chunks;
+  arrow::ArrayVector group;
+  int64_t group_rows = 0;
+  auto flush_group = [&]() -> arrow::Status {
+    std::shared_ptr<arrow::Array> chunk;
+    if (group.size() == 1) {
+      chunks.push_back(group[0]);
+    } else {
+      RETURN_NOT_OK(arrow::Concatenate(group, pool, &chunk));
+      chunks.push_back(chunk);
+    }
+    group.clear();
+    group_rows = 0;
+    return arrow::Status::OK();
+  };
 
+  for (const auto& chunk : array.chunks()) {
+    group.push_back(chunk);
+    group_rows += chunk->length();
+    if (group_rows >= chunk_rows) {
+      RETURN_NOT_OK(flush_group());
+    }
+  }
+  if (!group.empty()) {
+    RETURN_NOT_OK(flush_group());
+  }
+  *out = std::make_shared<arrow::ChunkedArray>(chunks, array.type());
+  return arrow::Status::OK();
+}
+
+arrow::Status CoalesceColumns(int64_t chunk_rows, arrow::MemoryPool* pool,
+                              const std::shared_ptr<TaskGroup>& task_group,
+                              std::vector<std::shared_ptr<arrow::Column>>* columns) {
+  std::vector<std::shared_ptr<arrow::Column>> coalesced(columns->size());
+  std::atomic<bool> not_implemented(false);
+  for (size_t i = 0; i < columns->size(); ++i) {
+    std::shared_ptr<arrow::Column> column = (*columns)[i];
+    std::shared_ptr<arrow::Column>* out = &coalesced[i];
+    task_group->Append([=, &not_implemented]() -> arrow::Status {
+      if (not_implemented) {
+        return arrow::Status::OK();
+      }
+      std::shared_ptr<arrow::ChunkedArray> array;
+      arrow::Status status = CoalesceChunks(*column->data(), chunk_rows, pool, &array);
+      if (status.IsNotImplemented()) {
+        // A type Arrow cannot concatenate: keep every column as it is
+        not_implemented = true;
+        return arrow::Status::OK();
+      }
+      RETURN_NOT_OK(status);
+      *out = std::make_shared<arrow::Column>(column->field(), array);
+      return arrow::Status::OK();
+    });
+  }
+  RETURN_NOT_OK(task_group->Finish());
+  if (!not_implemented) {
+    *columns = std::move(coalesced);
+  }
   return arrow::Status::OK();
 }
 
@@ -345,10 +565,10 @@ arrow::Status InferringColumnBuilder::Finish(std::shared_ptr<arrow::ChunkedArray
 arrow::Status ColumnBuilder::Make(const std::shared_ptr<arrow::DataType>& type, 
                                   int32_t col_index,
                                   const ConvertOptions& options,
+                                  arrow::MemoryPool* pool,
                                   const std::shared_ptr<TaskGroup>& task_group,
                                   std::shared_ptr<ColumnBuilder>* out) {
-    auto ptr = new TypedColumnBuilder(type, col_index, options, 
-                                      arrow::default_memory_pool(), task_group);
+    auto ptr = new TypedColumnBuilder(type, col_index, options, pool, task_group);
     auto res = std::shared_ptr<ColumnBuilder>(ptr);
     RETURN_NOT_OK(ptr->Init());
     *out = res;
@@ -356,10 +576,10 @@ arrow::Status ColumnBuilder::Make(const std::shared_ptr<arrow::DataType>& type,
 }
 
 arrow::Status ColumnBuilder::Make(int32_t col_index, const ConvertOptions& options,
+                                  arrow::MemoryPool* pool,
                                   const std::shared_ptr<TaskGroup>& task_group,
                                   std::shared_ptr<ColumnBuilder>* out) {
-    auto ptr = new InferringColumnBuilder(col_index, options, 
-                                          arrow::default_memory_pool(), task_group);
+    auto ptr = new InferringColumnBuilder(col_index, options, pool, task_group);
     auto res = std::shared_ptr<ColumnBuilder>(ptr);
     RETURN_NOT_OK(ptr->Init());
     *out = res;
@@ -70,8 +70,18 @@ class ColumnBuilder {
   virtual void Append(const std::shared_ptr<BlockParser>& parser);
 
   /// Spawn a task that will try to convert and insert the given FWF block
-  virtual void Insert(int64_t block_index,
-                      const std::shared_ptr<BlockParser>& parser) = 0;
+  void Insert(int64_t block_index, const std::shared_ptr<BlockParser>& parser);
+
+  /// Spawn tasks that will try to convert and insert the given FWF block
+  /// into each of builders, which must share a task group.  Each task
+  /// converts as many columns as take kValuesPerTask values, so that a
+  /// block of a wide table is not converted by one task of a few rows per
+  /// column.
+  static void InsertColumns(const std::vector<std::shared_ptr<ColumnBuilder>>& builders,
+                            int64_t block_index,
+                            const std::shared_ptr<BlockParser>& parser);
+
+  static constexpr int64_t kValuesPerTask = 1 << 16;
 
   /// Return the final chunked array.  The TaskGroup _must_ have finished!
   virtual arrow::Status Finish(std::shared_ptr<arrow::ChunkedArray>* out) = 0;
@@ -81,14 +91,18 @@ class ColumnBuilder {
 
   std::shared_ptr<arrow::internal::TaskGroup> task_group() { return task_group_; }
 
-  /// Construct a strictly-typed ColumnBuilder.
+  /// Construct a strictly-typed ColumnBuilder, allocating the converted
+  /// arrays from pool.
   static arrow::Status Make(const std::shared_ptr<arrow::DataType>& type, 
                             int32_t col_index, const ConvertOptions& options,
+                            arrow::MemoryPool* pool,
                             const std::shared_ptr<arrow::internal::TaskGroup>& task_group,
                             std::shared_ptr<ColumnBuilder>* out);
 
-  /// Construct a type-inferring ColumnBuilder.
+  /// Construct a type-inferring ColumnBuilder, allocating the converted
+  /// arrays from pool.
   static arrow::Status Make(int32_t col_index, const ConvertOptions& options,
+                            arrow::MemoryPool* pool,
                             const std::shared_ptr<arrow::internal::TaskGroup>& task_group,
                             std::shared_ptr<ColumnBuilder>* out);
 
@@ -96,10 +110,26 @@ class ColumnBuilder {
   explicit ColumnBuilder(const std::shared_ptr<arrow::internal::TaskGroup>& task_group)
       : task_group_(task_group) {}
 
+  // Make room for the given block's chunk, before converting it
+  virtual void PrepareBlock(int64_t block_index,
+                            const std::shared_ptr<BlockParser>& parser) = 0;
+  // Convert the given block's chunk, from a task
+  virtual arrow::Status ConvertBlock(int64_t block_index,
+                                     const std::shared_ptr<BlockParser>& parser) = 0;
+
   std::shared_ptr<arrow::internal::TaskGroup> task_group_;
   arrow::ArrayVector chunks_;
 };
 
+/// Replace each column with one whose consecutive chunks are concatenated
+/// (from pool) into chunks of at least chunk_rows rows, but the last, a
+/// column per task appended to task_group, which is then finished.  If Arrow
+/// cannot concatenate some column's type, every column is kept as it is.
+ARROW_EXPORT arrow::Status CoalesceColumns(
+    int64_t chunk_rows, arrow::MemoryPool* pool,
+    const std::shared_ptr<arrow::internal::TaskGroup>& task_group,
+    std::vector<std::shared_ptr<arrow::Column>>* columns);
+
 }  // namespace fwfr
 
 #endif  // FWFR_COLUMN_BUILDER_H
@@ -24,11 +24,16 @@
 
 #include <fwfr/converter.h>
 
+#include <array>
+#include <utility>
+
+#include <fwfr/whitespace.h>
+
+#include <arrow/array.h>
+
 namespace fwfr {
 
 using arrow::internal::StringConverter;
-using arrow::internal::Trie;
-using arrow::internal::TrieBuilder;
 
 namespace {
 
@@ -40,41 +45,155 @@ arrow::Status GenericConversionError(const std::shared_ptr<arrow::DataType>& typ
                                     reinterpret_cast<const char*>(data), size), "'");
 }
 
-inline bool IsWhitespace(uint8_t c) {
-  if (ARROW_PREDICT_TRUE(c > ' ')) {
-    return false;
+arrow::Status EncodedConversionError(const std::shared_ptr<arrow::DataType>& type,
+                                     const uint8_t* data, uint32_t size) {
+  // Encoded values may be binary, so show their bytes
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  std::string hex;
+  for (uint32_t i = 0; i < size; ++i) {
+    hex.push_back(kHexDigits[data[i] >> 4]);
+    hex.push_back(kHexDigits[data[i] & 0x0F]);
   }
-  return c == ' ' || c == '\t';
+  return arrow::Status::Invalid("FWF conversion error to ", type->ToString(),
+                                ": invalid encoded value 0x", hex);
 }
 
-arrow::Status InitializeTrie(const std::vector<std::string>& inputs,
-                             arrow::internal::Trie* trie) {
-  arrow::internal::TrieBuilder builder;
-  for (const auto& s : inputs) {
-    RETURN_NOT_OK(builder.Append(s, true /* allow_duplicates */));
+// Decoder for zoned decimal (COBOL DISPLAY) values, with the sign either
+// overpunched on a digit ('{' and 'A'-'I' for +0 to +9, '}' and 'J'-'R' for
+// -0 to -9) or separate.  Leading and trailing blanks are ignored, and blank
+// values are null.
+class ZonedDecoder {
+ public:
+  explicit ZonedDecoder(const ConvertOptions& options)
+      : sign_(options.numeric_format.sign) {
+    // Overpunched digits, plus 10 when negative
+    overpunch_.fill(-1);
+    for (int8_t digit = 0; digit <= 9; ++digit) {
+      overpunch_['0' + digit] = digit;
+      overpunch_[digit == 0 ? '{' : 'A' + digit - 1] = digit;
+      overpunch_[digit == 0 ? '}' : 'J' + digit - 1] = static_cast<int8_t>(10 + digit);
+    }
   }
-  *trie = builder.Finish();
-  return arrow::Status::OK();
-}
+
+  bool operator()(const uint8_t* data, uint32_t size, int64_t* out,
+                  bool* is_null) const {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    while (p < end && *p == ' ') {
+      ++p;
+    }
+    while (end > p && end[-1] == ' ') {
+      --end;
+    }
+    *is_null = (p == end);
+    if (*is_null) {
+      return true;
+    }
+
+    bool negative = false;
+    if (sign_ == NumericFormat::LEADING_SEPARATE ||
+        sign_ == NumericFormat::TRAILING_SEPARATE) {
+      const uint8_t c = (sign_ == NumericFormat::LEADING_SEPARATE) ? *p++ : *--end;
+      if (c == '-') {
+        negative = true;
+      } else if (c != '+') {
+        return false;
+      }
+    }
+    if (ARROW_PREDICT_FALSE(p == end || end - p > 18)) {
+      return false;
+    }
+    const uint8_t* overpunched = (sign_ == NumericFormat::TRAILING) ? end - 1
+                                 : (sign_ == NumericFormat::LEADING) ? p
+                                                                     : nullptr;
+    uint64_t value = 0;
+    for (; p < end; ++p) {
+      uint8_t digit = static_cast<uint8_t>(*p - '0');
+      if (ARROW_PREDICT_FALSE(digit > 9)) {
+        if (p != overpunched || overpunch_[*p] < 0) {
+          return false;
+        }
+        digit = static_cast<uint8_t>(overpunch_[*p] % 10);
+        negative = overpunch_[*p] >= 10;
+      }
+      value = value * 10 + digit;
+    }
+    *out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    return true;
+  }
+
+ protected:
+  NumericFormat::Sign sign_;
+  std::array<int8_t, 256> overpunch_;
+};
 
 class ConcreteConverter : public Converter {
  public:
   using Converter::Converter;
 
+  // Split each field into list_size values of equal width, converted
+  // in one strided pass (for FixedSizeListConverter)
+  void set_list_size(int32_t list_size) { list_size_ = list_size; }
+
  protected:
   arrow::Status Initialize() override;
   inline bool IsNull(const uint8_t* data, uint32_t size);
+  // Whether any null spelling fits in the given column's values
+  inline bool CanBeNull(const BlockParser& parser, int32_t col_index);
+
+  // Visit the given column's values, and count them
+  template <typename Visitor>
+  arrow::Status VisitValues(const BlockParser& parser, int32_t col_index,
+                            Visitor&& visit);
+  int64_t NumValues(const BlockParser& parser) const {
+    return static_cast<int64_t>(parser.num_rows()) * list_size_;
+  }
+  // Width of each of the given column's values
+  uint32_t ValueWidth(const BlockParser& parser, int32_t col_index) const {
+    return parser.column_width(col_index) / list_size_;
+  }
 
-  arrow::internal::Trie null_trie_;
+  ValueMatcher null_matcher_;
+  int32_t list_size_ = 1;
 };
 
 arrow::Status ConcreteConverter::Initialize() {
-  return InitializeTrie(options_.null_values, &null_trie_);
+  if (options_.implied_decimals < 0) {
+    return arrow::Status::Invalid("implied_decimals must be non-negative, got ",
+                                  options_.implied_decimals);
+  }
+  null_matcher_ = ValueMatcher(options_.null_values);
+  return arrow::Status::OK();
 }
 
 bool ConcreteConverter::IsNull(const uint8_t* data, uint32_t size) {
-  return null_trie_.Find(arrow::util::string_view(
-              reinterpret_cast<const char*>(data), size)) >= 0;
+  return null_matcher_.Find(data, size);
+}
+
+bool ConcreteConverter::CanBeNull(const BlockParser& parser, int32_t col_index) {
+  return null_matcher_.CanMatch(ValueWidth(parser, col_index));
+}
+
+template <typename Visitor>
+arrow::Status ConcreteConverter::VisitValues(const BlockParser& parser,
+                                             int32_t col_index, Visitor&& visit) {
+  if (ARROW_PREDICT_TRUE(list_size_ == 1)) {
+    return parser.VisitColumn(col_index, std::forward<Visitor>(visit));
+  }
+  const uint32_t list_size = static_cast<uint32_t>(list_size_);
+  auto visit_slices = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
+    if (ARROW_PREDICT_FALSE(size % list_size != 0)) {
+      return arrow::Status::Invalid("FWF conversion error to ", type_->ToString(),
+                                    ": cannot split a ", size, "-byte field into ",
+                                    list_size, " values");
+    }
+    const uint32_t width = size / list_size;
+    for (uint32_t i = 0; i < list_size; ++i, data += width) {
+      RETURN_NOT_OK(visit(data, width));
+    }
+    return arrow::Status::OK();
+  };
+  return parser.VisitColumn(col_index, visit_slices);
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -99,7 +218,7 @@ arrow::Status NullConverter::Convert(const BlockParser& parser, int32_t col_inde
       return GenericConversionError(type_, data, size);
     }
   };
-  RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+  RETURN_NOT_OK(VisitValues(parser, col_index, visit));
   RETURN_NOT_OK(builder.Finish(out));
 
   return arrow::Status::OK();
@@ -143,10 +262,10 @@ class VarSizeBinaryConverter : public ConcreteConverter {
       return arrow::Status::OK();
     };
 
-    RETURN_NOT_OK(builder.Resize(parser.num_rows()));
+    RETURN_NOT_OK(builder.Resize(NumValues(parser)));
     RETURN_NOT_OK(builder.ReserveData(parser.num_bytes()));
 
-    if (options_.strings_can_be_null) {
+    if (options_.strings_can_be_null && CanBeNull(parser, col_index)) {
       auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
         // Skip trailing whitespace
         if (ARROW_PREDICT_TRUE(size > 0) &&
@@ -171,9 +290,9 @@ class VarSizeBinaryConverter : public ConcreteConverter {
           return visit_non_null(data, size);
         }
       };
-      RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+      RETURN_NOT_OK(VisitValues(parser, col_index, visit));
     } else {
-      RETURN_NOT_OK(parser.VisitColumn(col_index, visit_non_null));
+      RETURN_NOT_OK(VisitValues(parser, col_index, visit_non_null));
     }
 
     RETURN_NOT_OK(builder.Finish(out));
@@ -212,8 +331,8 @@ arrow::Status FixedSizeBinaryConverter::Convert(const BlockParser& parser,
     }
     return builder.Append(data);
   };
-  RETURN_NOT_OK(builder.Resize(parser.num_rows()));
-  RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+  RETURN_NOT_OK(builder.Resize(NumValues(parser)));
+  RETURN_NOT_OK(VisitValues(parser, col_index, visit));
   RETURN_NOT_OK(builder.Finish(out));
 
   return arrow::Status::OK();
@@ -231,18 +350,19 @@ class BooleanConverter : public ConcreteConverter {
 
  protected:
   arrow::Status Initialize() override {
-    RETURN_NOT_OK(InitializeTrie(options_.true_values, &true_trie_));
-    RETURN_NOT_OK(InitializeTrie(options_.false_values, &false_trie_));
+    true_matcher_ = ValueMatcher(options_.true_values);
+    false_matcher_ = ValueMatcher(options_.false_values);
     return ConcreteConverter::Initialize();
   }
 
-  arrow::internal::Trie true_trie_;
-  arrow::internal::Trie false_trie_;
+  ValueMatcher true_matcher_;
+  ValueMatcher false_matcher_;
 };
 
 arrow::Status BooleanConverter::Convert(const BlockParser& parser, int32_t col_index,
                                         std::shared_ptr<arrow::Array>* out) {
-    arrow::BooleanBuilder builder(type_, pool_);
+  arrow::BooleanBuilder builder(type_, pool_);
+  const bool check_nulls = CanBeNull(parser, col_index);
 
   auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
     // Skip trailing whitespace
@@ -261,24 +381,22 @@ arrow::Status BooleanConverter::Convert(const BlockParser& parser, int32_t col_i
         ++data;
       }
     } 
-    if (IsNull(data, size)) {
+    if (check_nulls && IsNull(data, size)) {
       builder.UnsafeAppendNull();
       return arrow::Status::OK();
     }
-    if (false_trie_.Find(arrow::util::string_view(
-                    reinterpret_cast<const char*>(data), size)) >= 0) {
+    if (false_matcher_.Find(data, size)) {
       builder.UnsafeAppend(false);
       return arrow::Status::OK();
     }
-    if (true_trie_.Find(arrow::util::string_view(
-                    reinterpret_cast<const char*>(data), size)) >= 0) {
+    if (true_matcher_.Find(data, size)) {
       builder.UnsafeAppend(true);
       return arrow::Status::OK();
     }
     return GenericConversionError(type_, data, size);
   };
-  RETURN_NOT_OK(builder.Resize(parser.num_rows()));
-  RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+  RETURN_NOT_OK(builder.Resize(NumValues(parser)));
+  RETURN_NOT_OK(VisitValues(parser, col_index, visit));
   RETURN_NOT_OK(builder.Finish(out));
 
   return arrow::Status::OK();
@@ -294,16 +412,95 @@ class NumericConverter : public ConcreteConverter {
 
   arrow::Status Convert(const BlockParser& parser, int32_t col_index,
                         std::shared_ptr<arrow::Array>* out) override;
+
+ protected:
+  // Convert values in a NumericFormat other than TEXT
+  arrow::Status ConvertEncoded(const BlockParser& parser, int32_t col_index,
+                               std::shared_ptr<arrow::Array>* out);
+  template <typename Decoder>
+  arrow::Status ConvertDecoded(const BlockParser& parser, int32_t col_index,
+                               Decoder&& decode, std::shared_ptr<arrow::Array>* out);
 };
 
+template <typename T>
+arrow::Status NumericConverter<T>::ConvertEncoded(const BlockParser& parser,
+                                                  int32_t col_index,
+                                                  std::shared_ptr<arrow::Array>* out) {
+  // The decoder is picked once per column, outside of the value loop
+  switch (options_.numeric_format.encoding) {
+    case NumericFormat::ZONED:
+      return ConvertDecoded(parser, col_index, ZonedDecoder(options_), out);
+    case NumericFormat::BINARY: {
+      const bool is_signed = options_.numeric_format.sign != NumericFormat::UNSIGNED;
+      auto decode = [is_signed](const uint8_t* data, uint32_t size, int64_t* value,
+                                bool* is_null) {
+        *is_null = false;
+        return DecodeBinary(data, size, is_signed, value);
+      };
+      return ConvertDecoded(parser, col_index, decode, out);
+    }
+    case NumericFormat::PACKED: {
+      auto decode = [](const uint8_t* data, uint32_t size, int64_t* value,
+                       bool* is_null) {
+        *is_null = false;
+        return DecodePacked(data, size, value);
+      };
+      return ConvertDecoded(parser, col_index, decode, out);
+    }
+    default:
+      return arrow::Status::UnknownError("Shouldn't come here");
+  }
+}
+
+template <typename T>
+template <typename Decoder>
+arrow::Status NumericConverter<T>::ConvertDecoded(const BlockParser& parser,
+                                                  int32_t col_index, Decoder&& decode,
+                                                  std::shared_ptr<arrow::Array>* out) {
+  using BuilderType = typename arrow::TypeTraits<T>::BuilderType;
+  using value_type = typename T::c_type;
+
+  BuilderType builder(type_, pool_);
+  const int32_t implied_decimals = options_.implied_decimals;
+
+  auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
+    int64_t mantissa;
+    bool is_null;
+    value_type value;
+    if (ARROW_PREDICT_FALSE(!decode(data, size, &mantissa, &is_null))) {
+      return EncodedConversionError(type_, data, size);
+    }
+    if (is_null) {
+      builder.UnsafeAppendNull();
+      return arrow::Status::OK();
+    }
+    if (ARROW_PREDICT_FALSE(!ScaleMantissa(mantissa, implied_decimals, &value))) {
+      return EncodedConversionError(type_, data, size);
+    }
+    builder.UnsafeAppend(value);
+    return arrow::Status::OK();
+  };
+  RETURN_NOT_OK(builder.Resize(NumValues(parser)));
+  RETURN_NOT_OK(VisitValues(parser, col_index, visit));
+  RETURN_NOT_OK(builder.Finish(out));
+
+  return arrow::Status::OK();
+}
+
 template <typename T>
 arrow::Status NumericConverter<T>::Convert(const BlockParser& parser, int32_t col_index,
                                            std::shared_ptr<arrow::Array>* out) {
   using BuilderType = typename arrow::TypeTraits<T>::BuilderType;
-  using value_type = typename StringConverter<T>::value_type;
+  using value_type = typename FixedWidthParser<T>::value_type;
+
+  if (options_.numeric_format.encoding != NumericFormat::TEXT) {
+    return ConvertEncoded(parser, col_index, out);
+  }
 
   BuilderType builder(type_, pool_);
-  StringConverter<T> converter;
+  // Picks the fastest kernel for the column's width
+  FixedWidthParser<T> convert(ValueWidth(parser, col_index), options_.implied_decimals);
+  const bool check_nulls = CanBeNull(parser, col_index);
 
   auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
     value_type value;
@@ -323,7 +520,7 @@ arrow::Status NumericConverter<T>::Convert(const BlockParser& parser, int32_t co
         ++data;
       }
     } 
-    if (IsNull(data, size)) {
+    if (check_nulls && IsNull(data, size)) {
       builder.UnsafeAppendNull();
       return arrow::Status::OK();
     } 
@@ -362,7 +559,7 @@ arrow::Status NumericConverter<T>::Convert(const BlockParser& parser, int32_t co
       // Determine datatype and value of data
       if (is_modified) {
         if (ARROW_PREDICT_FALSE(
-                    !converter(reinterpret_cast<const char*>(new_data), size, &value))) {
+                    !convert(reinterpret_cast<const char*>(new_data), size, &value))) {
           return GenericConversionError(type_, 
                                         reinterpret_cast<const uint8_t*>(new_data), size);
         }
@@ -371,14 +568,14 @@ arrow::Status NumericConverter<T>::Convert(const BlockParser& parser, int32_t co
       }
     }
     if (ARROW_PREDICT_FALSE(
-            !converter(reinterpret_cast<const char*>(data), size, &value))) {
+            !convert(reinterpret_cast<const char*>(data), size, &value))) {
       return GenericConversionError(type_, data, size);
     }
     builder.UnsafeAppend(value);
     return arrow::Status::OK();
   };
-  RETURN_NOT_OK(builder.Resize(parser.num_rows()));
-  RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+  RETURN_NOT_OK(builder.Resize(NumValues(parser)));
+  RETURN_NOT_OK(VisitValues(parser, col_index, visit));
   RETURN_NOT_OK(builder.Finish(out));
 
   return arrow::Status::OK();
@@ -397,6 +594,7 @@ class TimestampConverter : public ConcreteConverter {
 
     arrow::TimestampBuilder builder(type_, pool_);
     StringConverter<arrow::TimestampType> converter(type_);
+    const bool check_nulls = CanBeNull(parser, col_index);
 
     auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
       value_type value = 0;
@@ -416,7 +614,7 @@ class TimestampConverter : public ConcreteConverter {
           ++data;
         }
       }
-      if (IsNull(data, size)) {
+      if (check_nulls && IsNull(data, size)) {
         builder.UnsafeAppendNull();
         return arrow::Status::OK();
       }
@@ -427,14 +625,47 @@ class TimestampConverter : public ConcreteConverter {
       builder.UnsafeAppend(value);
       return arrow::Status::OK();
     };
-    RETURN_NOT_OK(builder.Resize(parser.num_rows()));
-    RETURN_NOT_OK(parser.VisitColumn(col_index, visit));
+    RETURN_NOT_OK(builder.Resize(NumValues(parser)));
+    RETURN_NOT_OK(VisitValues(parser, col_index, visit));
     RETURN_NOT_OK(builder.Finish(out));
 
     return arrow::Status::OK();
   }
 };
 
+/////////////////////////////////////////////////////////////////////////
+// Converter for fixed size lists, splitting each field into equal-width
+// values decoded in a single pass over the column
+
+class FixedSizeListConverter : public Converter {
+ public:
+  using Converter::Converter;
+
+  arrow::Status Convert(const BlockParser& parser, int32_t col_index,
+                        std::shared_ptr<arrow::Array>* out) override {
+    std::shared_ptr<arrow::Array> values;
+    RETURN_NOT_OK(value_converter_->Convert(parser, col_index, &values));
+    *out = std::make_shared<arrow::FixedSizeListArray>(type_, parser.num_rows(), values);
+    return arrow::Status::OK();
+  }
+
+ protected:
+  arrow::Status Initialize() override {
+    const auto& list_type = static_cast<const arrow::FixedSizeListType&>(*type_);
+    std::shared_ptr<Converter> converter;
+    RETURN_NOT_OK(Converter::Make(list_type.value_type(), options_, pool_, &converter));
+    value_converter_ = std::dynamic_pointer_cast<ConcreteConverter>(converter);
+    if (value_converter_ == nullptr || list_type.list_size() < 1) {
+      return arrow::Status::NotImplemented("FWF conversion to ", type_->ToString(),
+                                           " is not supported");
+    }
+    value_converter_->set_list_size(list_type.list_size());
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<ConcreteConverter> value_converter_;
+};
+
 }  // namespace
 
 /////////////////////////////////////////////////////////////////////////
@@ -470,6 +701,13 @@ arrow::Status Converter::Make(const std::shared_ptr<arrow::DataType>& type,
     CONVERTER_CASE(arrow::Type::TIMESTAMP, TimestampConverter)
     CONVERTER_CASE(arrow::Type::BINARY, (VarSizeBinaryConverter<arrow::BinaryType>))
     CONVERTER_CASE(arrow::Type::FIXED_SIZE_BINARY, FixedSizeBinaryConverter)
+    CONVERTER_CASE(arrow::Type::FIXED_SIZE_LIST, FixedSizeListConverter)
+#ifdef FWFR_HAVE_LARGE_STRINGS
+    CONVERTER_CASE(arrow::Type::LARGE_BINARY,
+                   (VarSizeBinaryConverter<arrow::LargeBinaryType>))
+    CONVERTER_CASE(arrow::Type::LARGE_STRING,
+                   (VarSizeBinaryConverter<arrow::LargeStringType>))
+#endif
 
   case arrow::Type::STRING:
       result = new VarSizeBinaryConverter<arrow::StringType>(type, options, pool);
@@ -492,4 +730,18 @@ arrow::Status Converter::Make(const std::shared_ptr<arrow::DataType>& type,
   return Make(type, options, arrow::default_memory_pool(), out);
 }
 
+arrow::Status InferredStringType(const ConvertOptions& options, bool binary,
+                                 std::shared_ptr<arrow::DataType>* out) {
+  if (!options.large_strings) {
+    *out = binary ? arrow::binary() : arrow::utf8();
+    return arrow::Status::OK();
+  }
+#ifdef FWFR_HAVE_LARGE_STRINGS
+  *out = binary ? arrow::large_binary() : arrow::large_utf8();
+  return arrow::Status::OK();
+#else
+  return arrow::Status::NotImplemented("Large strings need Arrow 0.15 or later");
+#endif
+}
+
 }  // namespace fwfr
@@ -25,8 +25,10 @@
 #ifndef FWFR_CONVERTER_H
 #define FWFR_CONVERTER_H
 
+#include <fwfr/numeric-parsing.h>
 #include <fwfr/options.h>
 #include <fwfr/parser.h>
+#include <fwfr/value-matcher.h>
 
 #include <cstring>
 #include <cstdint>
@@ -43,7 +45,6 @@
 #include <arrow/type_traits.h>
 #include <arrow/util/macros.h>
 #include <arrow/util/parsing.h>  // IWYU pragma: keep
-#include <arrow/util/trie.h>
 #include <arrow/util/visibility.h>
 
 namespace arrow {
@@ -85,6 +86,13 @@ class ARROW_EXPORT Converter {
   std::shared_ptr<arrow::DataType> type_;
 };
 
+/// \brief Return the type of inferred string (or binary) columns: utf8
+/// (binary), or large_utf8 (large_binary) if options.large_strings
+///
+/// Large types need Arrow 0.15 or later, NotImplemented is returned before.
+ARROW_EXPORT arrow::Status InferredStringType(const ConvertOptions& options, bool binary,
+                                              std::shared_ptr<arrow::DataType>* out);
+
 }  // namespace fwfr
 
 #endif  // FWFR_CONVERTER_H
@@ -0,0 +1,627 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/copybook.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <arrow/type.h>
+
+namespace fwfr {
+
+namespace {
+
+using Sentence = std::vector<std::string>;
+
+std::string ToUpper(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+  return s;
+}
+
+bool IsBlank(const std::string& line) {
+  return std::all_of(line.begin(), line.end(),
+                     [](unsigned char c) { return std::isspace(c) != 0; });
+}
+
+// Whether a line has a fixed format sequence area (columns 1-6) and
+// indicator area (column 7)
+bool IsFixedFormatLine(const std::string& line) {
+  if (line.size() < 7) {
+    return false;
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    if (line[i] != ' ' && !std::isdigit(static_cast<unsigned char>(line[i]))) {
+      return false;
+    }
+  }
+  return std::string(" */-Dd").find(line[6]) != std::string::npos;
+}
+
+// Drop a "*>" comment, if any, outside of literals
+void StripInlineComment(std::string* line) {
+  char quote = 0;
+  for (size_t i = 0; i < line->size(); ++i) {
+    const char c = (*line)[i];
+    if (quote != 0) {
+      if (c == quote) {
+        quote = 0;
+      }
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '*' && i + 1 < line->size() && (*line)[i + 1] == '>') {
+      line->resize(i);
+      return;
+    }
+  }
+}
+
+// Reduce the source to its program text, dropping sequence and
+// indicator areas, comments and debugging lines
+std::string ProgramText(const std::string& source) {
+  std::vector<std::string> lines;
+  std::istringstream stream(source);
+  std::string line;
+  while (std::getline(stream, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    lines.push_back(line);
+  }
+
+  bool is_fixed = false;
+  for (const auto& l : lines) {
+    if (IsBlank(l)) {
+      continue;
+    }
+    if (!IsFixedFormatLine(l)) {
+      is_fixed = false;
+      break;
+    }
+    is_fixed = true;
+  }
+
+  std::string text;
+  for (auto& l : lines) {
+    bool is_continuation = false;
+    if (is_fixed) {
+      if (IsBlank(l)) {
+        continue;
+      }
+      const char indicator = l[6];
+      if (indicator == '*' || indicator == '/' || indicator == 'D' || indicator == 'd') {
+        continue;
+      }
+      is_continuation = (indicator == '-');
+      // Program text is in columns 8-72
+      l = l.substr(7, 65);
+    }
+    StripInlineComment(&l);
+    if (is_continuation) {
+      l.erase(0, l.find_first_not_of(' '));
+    } else {
+      text.push_back(' ');
+    }
+    text += l;
+  }
+  return text;
+}
+
+// Split program text into sentences of tokens, ending at separator
+// periods (those followed by a space).  Separator commas and semicolons
+// are dropped, and literals are kept whole.
+std::vector<Sentence> Tokenize(const std::string& text) {
+  std::vector<Sentence> sentences;
+  Sentence sentence;
+  auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+  size_t i = 0;
+  const size_t n = text.size();
+  while (i < n) {
+    if (is_space(text[i])) {
+      ++i;
+      continue;
+    }
+    const size_t start = i;
+    if (text[i] == '"' || text[i] == '\'') {
+      const char quote = text[i++];
+      while (i < n && text[i] != quote) {
+        ++i;
+      }
+      i = std::min(i + 1, n);
+    }
+    while (i < n && !is_space(text[i])) {
+      ++i;
+    }
+    std::string token = text.substr(start, i - start);
+    bool ends_sentence = false;
+    if (token.back() == '.') {
+      token.pop_back();
+      ends_sentence = true;
+    } else if (token.back() == ',' || token.back() == ';') {
+      token.pop_back();
+    }
+    if (!token.empty()) {
+      sentence.push_back(token);
+    }
+    if (ends_sentence && !sentence.empty()) {
+      sentences.push_back(sentence);
+      sentence.clear();
+    }
+  }
+  if (!sentence.empty()) {
+    sentences.push_back(sentence);
+  }
+  return sentences;
+}
+
+enum class Usage { UNSET, DISPLAY, BINARY, PACKED };
+enum class SignPosition { UNSET, LEADING, TRAILING };
+
+// A data description entry
+struct Item {
+  int32_t level = 0;
+  std::string name;
+  bool is_filler = false;
+  bool is_redefinition = false;
+  std::string picture;
+  Usage usage = Usage::UNSET;
+  SignPosition sign = SignPosition::UNSET;
+  bool sign_is_separate = false;
+  // Number of repetitions (0 if not repeated)
+  int32_t occurs = 0;
+  std::vector<size_t> children;
+};
+
+const std::unordered_set<std::string>& ClauseKeywords() {
+  static const std::unordered_set<std::string> keywords = {
+      "PIC",            "PICTURE",         "USAGE",           "DISPLAY",
+      "COMP",           "COMP-1",          "COMP-2",          "COMP-3",
+      "COMP-4",         "COMP-5",          "COMPUTATIONAL",   "COMPUTATIONAL-1",
+      "COMPUTATIONAL-2", "COMPUTATIONAL-3", "COMPUTATIONAL-4", "COMPUTATIONAL-5",
+      "BINARY",         "PACKED-DECIMAL",  "INDEX",           "POINTER",
+      "SIGN",           "LEADING",         "TRAILING",        "REDEFINES",
+      "OCCURS",         "VALUE",           "VALUES",          "JUSTIFIED",
+      "JUST",           "BLANK",           "SYNC",            "SYNCHRONIZED",
+      "INDEXED",        "ASCENDING",       "DESCENDING",      "GLOBAL",
+      "EXTERNAL"};
+  return keywords;
+}
+
+bool IsClauseKeyword(const std::string& token) {
+  return ClauseKeywords().count(ToUpper(token)) > 0;
+}
+
+arrow::Status ParseUsage(const std::string& keyword, const std::string& name,
+                         Usage* out) {
+  if (keyword == "DISPLAY") {
+    *out = Usage::DISPLAY;
+  } else if (keyword == "COMP" || keyword == "COMP-4" || keyword == "COMP-5" ||
+             keyword == "COMPUTATIONAL" || keyword == "COMPUTATIONAL-4" ||
+             keyword == "COMPUTATIONAL-5" || keyword == "BINARY") {
+    *out = Usage::BINARY;
+  } else if (keyword == "COMP-3" || keyword == "COMPUTATIONAL-3" ||
+             keyword == "PACKED-DECIMAL") {
+    *out = Usage::PACKED;
+  } else {
+    return arrow::Status::NotImplemented("Copybook item '", name, "' has USAGE ",
+                                         keyword);
+  }
+  return arrow::Status::OK();
+}
+
+// Parse a data description entry.  Sets *skip for entries that declare
+// no data (level 66 and 88 entries).
+arrow::Status ParseItem(const Sentence& sentence, Item* item, bool* skip) {
+  const std::string& level = sentence[0];
+  if (!std::all_of(level.begin(), level.end(),
+                   [](unsigned char c) { return std::isdigit(c) != 0; })) {
+    return arrow::Status::Invalid("Copybook entry starts with '", level,
+                                  "' instead of a level number");
+  }
+  item->level = std::stoi(level);
+  *skip = (item->level == 66 || item->level == 88);
+  if (*skip) {
+    return arrow::Status::OK();
+  }
+  if (item->level == 77) {
+    item->level = 1;
+  }
+  if (item->level < 1 || item->level > 49) {
+    return arrow::Status::Invalid("Copybook entry has invalid level number ", level);
+  }
+
+  size_t i = 1;
+  const size_t n = sentence.size();
+  if (i < n && !IsClauseKeyword(sentence[i])) {
+    item->name = sentence[i++];
+  }
+  item->is_filler = item->name.empty() || ToUpper(item->name) == "FILLER";
+  const std::string name = item->is_filler ? "FILLER" : item->name;
+
+  // Return the next token, uppercased, skipping an optional noise word
+  auto next = [&](const char* noise) -> std::string {
+    if (i < n && ToUpper(sentence[i]) == noise) {
+      ++i;
+    }
+    return i < n ? ToUpper(sentence[i++]) : "";
+  };
+  auto skip_operands = [&]() {
+    while (i < n && !IsClauseKeyword(sentence[i])) {
+      ++i;
+    }
+  };
+
+  while (i < n) {
+    const std::string clause = ToUpper(sentence[i++]);
+    if (clause == "PIC" || clause == "PICTURE") {
+      if (i < n && ToUpper(sentence[i]) == "IS") {
+        ++i;
+      }
+      if (i == n) {
+        return arrow::Status::Invalid("Copybook item '", name, "' has an empty PICTURE");
+      }
+      item->picture = ToUpper(sentence[i++]);
+    } else if (clause == "USAGE") {
+      RETURN_NOT_OK(ParseUsage(next("IS"), name, &item->usage));
+    } else if (clause == "SIGN" || clause == "LEADING" || clause == "TRAILING") {
+      const std::string position = (clause == "SIGN") ? next("IS") : clause;
+      if (position == "LEADING") {
+        item->sign = SignPosition::LEADING;
+      } else if (position == "TRAILING") {
+        item->sign = SignPosition::TRAILING;
+      } else {
+        return arrow::Status::Invalid("Copybook item '", name, "' has SIGN ", position);
+      }
+      if (i < n && ToUpper(sentence[i]) == "SEPARATE") {
+        item->sign_is_separate = true;
+        ++i;
+        if (i < n && ToUpper(sentence[i]) == "CHARACTER") {
+          ++i;
+        }
+      }
+    } else if (clause == "REDEFINES") {
+      item->is_redefinition = true;
+      ++i;
+    } else if (clause == "OCCURS") {
+      const std::string count = next("");
+      if (count.empty() ||
+          !std::all_of(count.begin(), count.end(),
+                       [](unsigned char c) { return std::isdigit(c) != 0; })) {
+        return arrow::Status::Invalid("Copybook item '", name, "' has OCCURS '", count,
+                                      "'");
+      }
+      item->occurs = std::stoi(count);
+      if (i < n && ToUpper(sentence[i]) == "TIMES") {
+        ++i;
+      }
+      if (i < n && (ToUpper(sentence[i]) == "TO" || ToUpper(sentence[i]) == "DEPENDING")) {
+        return arrow::Status::NotImplemented("Copybook item '", name,
+                                             "' has a variable OCCURS");
+      }
+      if (item->occurs < 1) {
+        return arrow::Status::Invalid("Copybook item '", name, "' has OCCURS 0");
+      }
+    } else if (clause == "VALUE" || clause == "VALUES" || clause == "JUSTIFIED" ||
+               clause == "JUST" || clause == "BLANK" || clause == "SYNC" ||
+               clause == "SYNCHRONIZED" || clause == "INDEXED" ||
+               clause == "ASCENDING" || clause == "DESCENDING" || clause == "GLOBAL" ||
+               clause == "EXTERNAL") {
+      // Clauses without effect on the record layout
+      skip_operands();
+    } else if (IsClauseKeyword(clause)) {
+      RETURN_NOT_OK(ParseUsage(clause, name, &item->usage));
+    } else {
+      return arrow::Status::Invalid("Copybook item '", name, "' has unknown clause '",
+                                    sentence[i - 1], "'");
+    }
+  }
+  return arrow::Status::OK();
+}
+
+// The characteristics of an elementary item's PICTURE
+struct Picture {
+  // Number of digit positions, and how many follow the assumed decimal point
+  int32_t digits = 0;
+  int32_t scale = 0;
+  // Number of character positions (excluding S and V)
+  int32_t size = 0;
+  bool is_signed = false;
+  // Whether only S, 9 and V appear
+  bool is_numeric = true;
+};
+
+arrow::Status AnalyzePicture(const std::string& name, const std::string& picture,
+                             Picture* out) {
+  bool seen_decimal_point = false;
+  size_t i = 0;
+  while (i < picture.size()) {
+    // CR and DB are the only two-character symbols
+    const std::string symbol = picture.substr(i, 2);
+    size_t symbol_size = (symbol == "CR" || symbol == "DB") ? 2 : 1;
+    const char c = picture[i];
+    i += symbol_size;
+
+    int32_t count = 1;
+    if (i < picture.size() && picture[i] == '(') {
+      const size_t close = picture.find(')', i);
+      const std::string repeat =
+          close == std::string::npos ? "" : picture.substr(i + 1, close - i - 1);
+      if (repeat.empty() ||
+          !std::all_of(repeat.begin(), repeat.end(),
+                       [](unsigned char d) { return std::isdigit(d) != 0; })) {
+        return arrow::Status::Invalid("Copybook item '", name, "' has PICTURE ",
+                                      picture);
+      }
+      count = std::stoi(repeat);
+      i = close + 1;
+    }
+
+    switch (c) {
+      case 'S':
+        if (out->is_signed || out->size > 0 || count != 1) {
+          return arrow::Status::Invalid("Copybook item '", name, "' has PICTURE ",
+                                        picture);
+        }
+        out->is_signed = true;
+        break;
+      case '9':
+        out->digits += count;
+        out->scale += seen_decimal_point ? count : 0;
+        out->size += count;
+        break;
+      case 'V':
+        seen_decimal_point = true;
+        break;
+      case 'P':
+        return arrow::Status::NotImplemented("Copybook item '", name,
+                                             "' has scaling positions (P) in PICTURE ",
+                                             picture);
+      case 'X':
+      case 'A':
+      case 'Z':
+      case '*':
+      case '+':
+      case '-':
+      case '.':
+      case ',':
+      case 'B':
+      case '0':
+      case '/':
+      case '$':
+      case 'C':
+      case 'D':
+        // Alphanumeric or numeric-edited: read as text
+        if ((c == 'C' || c == 'D') && symbol_size != 2) {
+          return arrow::Status::Invalid("Copybook item '", name, "' has PICTURE ",
+                                        picture);
+        }
+        out->is_numeric = false;
+        out->size += count * static_cast<int32_t>(symbol_size);
+        break;
+      default:
+        return arrow::Status::Invalid("Copybook item '", name, "' has PICTURE ",
+                                      picture);
+    }
+  }
+  if (out->size == 0 || (out->is_numeric && out->digits == 0)) {
+    return arrow::Status::Invalid("Copybook item '", name, "' has PICTURE ", picture);
+  }
+  return arrow::Status::OK();
+}
+
+std::shared_ptr<arrow::DataType> IntegerType(int32_t digits) {
+  if (digits <= 4) {
+    return arrow::int16();
+  }
+  return digits <= 9 ? arrow::int32() : arrow::int64();
+}
+
+// Flattens the item tree into fields
+class CopybookCompiler {
+ public:
+  explicit CopybookCompiler(const std::vector<Item>& items) : items_(items) {}
+
+  arrow::Status Compile(Copybook* out) {
+    out->parse_options = ParseOptions::Defaults();
+    out->convert_options = ConvertOptions::Defaults();
+    out_ = out;
+
+    const Item& root = items_[0];
+    int32_t num_records = 0;
+    for (size_t child : root.children) {
+      const Item& item = items_[child];
+      if (item.is_redefinition) {
+        continue;
+      }
+      if (item.level == 1 && ++num_records > 1) {
+        return arrow::Status::Invalid(
+            "Copybook describes several records, which need a copybook each");
+      }
+      RETURN_NOT_OK(Flatten(item, "", Usage::UNSET, SignPosition::UNSET, false));
+    }
+    if (out->parse_options.field_widths.empty()) {
+      return arrow::Status::Invalid("Copybook has no elementary items");
+    }
+    if (out->column_names.empty()) {
+      return arrow::Status::Invalid("Copybook has only FILLER items");
+    }
+    if (has_binary_fields_) {
+      // Binary bytes may look like line separators, so records are read
+      // back to back by their width
+      out->parse_options.ignore_empty_lines = false;
+      out->parse_options.newlines_in_values = true;
+    }
+    out->schema = arrow::schema(fields_);
+    return arrow::Status::OK();
+  }
+
+ protected:
+  arrow::Status Flatten(const Item& item, const std::string& suffix, Usage usage,
+                        SignPosition sign, bool sign_is_separate) {
+    // USAGE and SIGN apply to a group's items
+    if (item.usage != Usage::UNSET) {
+      usage = item.usage;
+    }
+    if (item.sign != SignPosition::UNSET) {
+      sign = item.sign;
+      sign_is_separate = item.sign_is_separate;
+    }
+    if (item.children.empty()) {
+      // Repeated elementary items become a single fixed size list column
+      return AddField(item, suffix, usage, sign, sign_is_separate);
+    }
+    // Repeated groups are expanded, suffixing their items' names
+    const int32_t repeats = std::max(item.occurs, 1);
+    for (int32_t k = 1; k <= repeats; ++k) {
+      const std::string item_suffix =
+          item.occurs > 0 ? suffix + "_" + std::to_string(k) : suffix;
+      if (!item.picture.empty()) {
+        return arrow::Status::Invalid("Copybook group '", item.name,
+                                      "' has a PICTURE");
+      }
+      for (size_t child : item.children) {
+        if (!items_[child].is_redefinition) {
+          RETURN_NOT_OK(Flatten(items_[child], item_suffix, usage, sign,
+                                sign_is_separate));
+        }
+      }
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status AddField(const Item& item, const std::string& suffix, Usage usage,
+                         SignPosition sign, bool sign_is_separate) {
+    const std::string item_name = item.is_filler ? "FILLER" : item.name;
+    if (item.picture.empty()) {
+      return arrow::Status::Invalid("Copybook item '", item_name, "' has no PICTURE");
+    }
+    Picture picture;
+    RETURN_NOT_OK(AnalyzePicture(item_name, item.picture, &picture));
+
+    uint32_t width;
+    std::shared_ptr<arrow::DataType> type;
+    ColumnConvertOptions options = ColumnConvertOptions::Defaults();
+    if (!picture.is_numeric) {
+      if (usage != Usage::UNSET && usage != Usage::DISPLAY) {
+        return arrow::Status::Invalid("Copybook item '", item_name,
+                                      "' is not numeric, but has a binary USAGE");
+      }
+      width = static_cast<uint32_t>(picture.size);
+      type = arrow::utf8();
+    } else {
+      if (picture.digits > 18) {
+        return arrow::Status::NotImplemented("Copybook item '", item_name, "' has ",
+                                             picture.digits, " digits (at most 18)");
+      }
+      options.implied_decimals = picture.scale;
+      auto& format = options.numeric_format;
+      format.sign = picture.is_signed ? NumericFormat::TRAILING : NumericFormat::UNSIGNED;
+      switch (usage) {
+        case Usage::BINARY:
+          format.encoding = NumericFormat::BINARY;
+          width = picture.digits <= 4 ? 2 : (picture.digits <= 9 ? 4 : 8);
+          if (picture.scale > 0) {
+            type = arrow::float64();
+          } else if (width == 2) {
+            type = picture.is_signed ? arrow::int16() : arrow::uint16();
+          } else if (width == 4) {
+            type = picture.is_signed ? arrow::int32() : arrow::uint32();
+          } else {
+            type = picture.is_signed ? arrow::int64() : arrow::uint64();
+          }
+          break;
+        case Usage::PACKED:
+          format.encoding = NumericFormat::PACKED;
+          width = static_cast<uint32_t>(picture.digits / 2 + 1);
+          type = picture.scale > 0 ? arrow::float64() : IntegerType(picture.digits);
+          break;
+        default:
+          format.encoding = NumericFormat::ZONED;
+          width = static_cast<uint32_t>(picture.digits);
+          if (picture.is_signed) {
+            if (sign_is_separate) {
+              format.sign = (sign == SignPosition::LEADING)
+                                ? NumericFormat::LEADING_SEPARATE
+                                : NumericFormat::TRAILING_SEPARATE;
+              ++width;
+            } else if (sign == SignPosition::LEADING) {
+              format.sign = NumericFormat::LEADING;
+            }
+          }
+          type = picture.scale > 0 ? arrow::float64() : IntegerType(picture.digits);
+          break;
+      }
+      has_binary_fields_ |= (usage == Usage::BINARY || usage == Usage::PACKED);
+    }
+
+    if (item.occurs > 0) {
+      width *= static_cast<uint32_t>(item.occurs);
+      type = arrow::fixed_size_list(type, item.occurs);
+    }
+
+    auto& parse_options = out_->parse_options;
+    parse_options.field_widths.push_back(width);
+    if (item.is_filler) {
+      parse_options.skip_columns.push_back(
+          static_cast<uint32_t>(parse_options.field_widths.size() - 1));
+      return arrow::Status::OK();
+    }
+
+    // Names must be unique, as options are looked up by name
+    std::string name = item.name + suffix;
+    const int32_t seen = ++name_counts_[name];
+    if (seen > 1) {
+      name += "_" + std::to_string(seen);
+    }
+    out_->column_names.push_back(name);
+    out_->convert_options.column_types[name] = type;
+    out_->convert_options.column_options[name] = options;
+    fields_.push_back(arrow::field(name, type));
+    return arrow::Status::OK();
+  }
+
+  const std::vector<Item>& items_;
+  Copybook* out_ = nullptr;
+  std::vector<std::shared_ptr<arrow::Field>> fields_;
+  std::unordered_map<std::string, int32_t> name_counts_;
+  bool has_binary_fields_ = false;
+};
+
+}  // namespace
+
+arrow::Status CompileCopybook(const std::string& source, Copybook* out) {
+  // Build the item tree under a root item, nesting entries by level number
+  std::vector<Item> items(1);
+  std::vector<size_t> stack = {0};
+  for (const auto& sentence : Tokenize(ProgramText(source))) {
+    Item item;
+    bool skip;
+    RETURN_NOT_OK(ParseItem(sentence, &item, &skip));
+    if (skip) {
+      continue;
+    }
+    while (items[stack.back()].level >= item.level) {
+      stack.pop_back();
+    }
+    const size_t index = items.size();
+    items[stack.back()].children.push_back(index);
+    items.push_back(item);
+    stack.push_back(index);
+  }
+  return CopybookCompiler(items).Compile(out);
+}
+
+}  // namespace fwfr
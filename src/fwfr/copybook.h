@@ -0,0 +1,58 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_COPYBOOK_H
+#define FWFR_COPYBOOK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fwfr/options.h>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    class Schema;
+}
+
+namespace fwfr {
+
+/// \brief A COBOL record description compiled into fwfr options
+///
+/// Every elementary item becomes a field: FILLER items are skipped at parse
+/// time, and the others get a declared type and numeric format, so no type
+/// inference happens and each column's decoder is picked up front.
+struct ARROW_EXPORT Copybook {
+  // Field widths, with FILLER fields in skip_columns
+  ParseOptions parse_options;
+  // Names of the columns read, for ReadOptions::column_names
+  std::vector<std::string> column_names;
+  // Column types, numeric formats and implied decimals, by column name
+  ConvertOptions convert_options;
+  // Schema of the tables read
+  std::shared_ptr<arrow::Schema> schema;
+};
+
+/// \brief Compile a copybook (in fixed or free source format)
+///
+/// Supports PICTURE, USAGE (DISPLAY, COMP / BINARY, COMP-3), SIGN, OCCURS,
+/// REDEFINES (the first definition is read) and FILLER.  Repeated
+/// elementary items are read as fixed_size_list columns, while the items
+/// of repeated groups get a column per repetition (NAME_1, NAME_2...).
+/// Records with binary fields can hold any byte, so they must not be
+/// newline-terminated.
+ARROW_EXPORT arrow::Status CompileCopybook(const std::string& source, Copybook* out);
+
+}  // namespace fwfr
+
+#endif  // FWFR_COPYBOOK_H
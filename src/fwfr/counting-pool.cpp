@@ -0,0 +1,84 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/counting-pool.h>
+
+#include <algorithm>
+
+namespace fwfr {
+
+arrow::Status CountingPool::Allocate(int64_t size, uint8_t** out) {
+  RETURN_NOT_OK(pool_->Allocate(size, out));
+  std::lock_guard<std::mutex> lock(mutex_);
+  AddAllocation(size);
+  return arrow::Status::OK();
+}
+
+arrow::Status CountingPool::Reallocate(int64_t old_size, int64_t new_size,
+                                       uint8_t** ptr) {
+  RETURN_NOT_OK(pool_->Reallocate(old_size, new_size, ptr));
+  std::lock_guard<std::mutex> lock(mutex_);
+  ResizeAllocation(new_size - old_size);
+  return arrow::Status::OK();
+}
+
+void CountingPool::Free(uint8_t* buffer, int64_t size) {
+  pool_->Free(buffer, size);
+  std::unique_lock<std::mutex> lock(mutex_);
+  RemoveAllocation(size);
+  MaybeDelete(&lock);
+}
+
+int64_t CountingPool::bytes_allocated() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_allocated_;
+}
+
+int64_t CountingPool::max_memory() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_memory_;
+}
+
+void CountingPool::AddAllocation(int64_t size) {
+  ++num_allocations_;
+  bytes_allocated_ += size;
+  max_memory_ = std::max(max_memory_, bytes_allocated_);
+}
+
+void CountingPool::ResizeAllocation(int64_t delta) {
+  bytes_allocated_ += delta;
+  max_memory_ = std::max(max_memory_, bytes_allocated_);
+  if (delta < 0) {
+    OnFreed();
+  }
+}
+
+void CountingPool::RemoveAllocation(int64_t size) {
+  --num_allocations_;
+  bytes_allocated_ -= size;
+  OnFreed();
+}
+
+void CountingPool::Release() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  released_ = true;
+  OnReleased();
+  MaybeDelete(&lock);
+}
+
+void CountingPool::MaybeDelete(std::unique_lock<std::mutex>* lock) {
+  if (released_ && CanDelete()) {
+    lock->unlock();
+    delete this;
+  }
+}
+
+}  // namespace fwfr
@@ -0,0 +1,81 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_COUNTING_POOL_H
+#define FWFR_COUNTING_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace fwfr {
+
+/// \class CountingPool
+/// \brief Memory pool counting the bytes held through it
+///
+/// Allocations are forwarded to the wrapped pool.  Unlike
+/// arrow::ProxyMemoryPool, the pool may be freed to after the read is gone,
+/// as the table read holds buffers allocated through it: a pool made with
+/// Adopt() is only destroyed once the returned pointer is gone and
+/// CanDelete() holds, by default once all its allocations are freed.
+class ARROW_EXPORT CountingPool : public arrow::MemoryPool {
+ public:
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  /// Bytes currently held through the pool
+  int64_t bytes_allocated() const override;
+  /// Peak of bytes_allocated()
+  int64_t max_memory() const override;
+
+ protected:
+  explicit CountingPool(arrow::MemoryPool* pool) : pool_(pool) {}
+
+  // Hand out a pool, released when the returned pointer is gone
+  template <typename Pool>
+  static std::shared_ptr<Pool> Adopt(Pool* pool) {
+    return std::shared_ptr<Pool>(pool, [](Pool* p) { p->Release(); });
+  }
+
+  // Count an allocation, its resizing and its freeing, with mutex_ held
+  void AddAllocation(int64_t size);
+  void ResizeAllocation(int64_t delta);
+  void RemoveAllocation(int64_t size);
+
+  // Called with mutex_ held once bytes were freed
+  virtual void OnFreed() {}
+  // Called with mutex_ held when the pointer returned by Adopt() is gone
+  virtual void OnReleased() {}
+  // Whether the pool may be deleted once released, with mutex_ held
+  virtual bool CanDelete() const { return num_allocations_ == 0; }
+
+  void Release();
+  // Delete the pool if it is released and CanDelete()
+  void MaybeDelete(std::unique_lock<std::mutex>* lock);
+
+  arrow::MemoryPool* pool_;
+
+  mutable std::mutex mutex_;
+  int64_t bytes_allocated_ = 0;
+  int64_t max_memory_ = 0;
+  // Allocations not freed yet, including empty ones
+  int64_t num_allocations_ = 0;
+  bool released_ = false;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_COUNTING_POOL_H
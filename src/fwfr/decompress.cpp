@@ -0,0 +1,612 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/decompress.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <string>
+#include <utility>
+
+#include <fwfr/scheduler.h>
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <arrow/buffer.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/memory_pool.h>
+#include <arrow/util/macros.h>
+#include <arrow/util/string_view.h>
+#include <arrow/util/thread-pool.h>
+
+namespace fwfr {
+
+// Compressed data is read from the input stream 1 MB at a time
+static constexpr int64_t kInputChunkSize = 1 << 20;
+// Frames are buffered whole up to this size, before falling back to
+// decompressing them serially
+static constexpr int64_t kMaxFrameSize = 64 << 20;  // 64 MB
+// inflate() window bits for gzip-wrapped data
+static constexpr int kGzipWindowBits = 16 + MAX_WBITS;
+
+static inline uint32_t LoadLittleEndian32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Compression formats
+
+class Codec {
+ public:
+  virtual ~Codec() = default;
+
+  // Find the compressed size of the frame at the start of the data.
+  // frame_size is left at 0 if more data is needed, and set to -1 if the
+  // data can't be split into frames.
+  virtual arrow::Status FrameSize(const uint8_t* data, int64_t size,
+                                  int64_t* frame_size) const = 0;
+
+  // Decompress a whole frame; may be called from several threads at once
+  virtual arrow::Status DecompressFrame(arrow::MemoryPool* pool, const uint8_t* data,
+                                        int64_t size,
+                                        std::shared_ptr<arrow::Buffer>* out) const = 0;
+
+  // Decompress streaming data, across frames
+  virtual arrow::Status Stream(const uint8_t* in, int64_t in_size, int64_t* consumed,
+                               uint8_t* out, int64_t out_size, int64_t* produced) = 0;
+
+  // Whether the data streamed so far ends with a whole frame
+  virtual bool StreamFinished() const = 0;
+};
+
+// gzip members; BGZF blocks are members with their compressed size in an
+// extra "BC" subfield
+class GzipCodec : public Codec {
+ public:
+  ~GzipCodec() override {
+    if (stream_initialized_) {
+      inflateEnd(&stream_);
+    }
+  }
+
+  arrow::Status FrameSize(const uint8_t* data, int64_t size,
+                          int64_t* frame_size) const override {
+    // Fixed header, with the FEXTRA flag, then the length of the extra field
+    if (size < 12) {
+      return arrow::Status::OK();
+    }
+    if (data[2] != Z_DEFLATED || !(data[3] & 0x04)) {
+      *frame_size = -1;
+      return arrow::Status::OK();
+    }
+    const int64_t extra_size = data[10] | (data[11] << 8);
+    if (size < 12 + extra_size) {
+      return arrow::Status::OK();
+    }
+    const uint8_t* field = data + 12;
+    const uint8_t* end = field + extra_size;
+    while (end - field >= 4) {
+      const int64_t field_size = field[2] | (field[3] << 8);
+      if (field[0] == 'B' && field[1] == 'C' && field_size == 2 && end - field >= 6) {
+        *frame_size = (field[4] | (field[5] << 8)) + 1;
+        return arrow::Status::OK();
+      }
+      field += 4 + field_size;
+    }
+    *frame_size = -1;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status DecompressFrame(arrow::MemoryPool* pool, const uint8_t* data,
+                                int64_t size,
+                                std::shared_ptr<arrow::Buffer>* out) const override {
+    // The member ends with its decompressed size (modulo 2^32, but BGZF
+    // blocks are at most 64 kB)
+    if (size < 18) {
+      return arrow::Status::Invalid("Truncated BGZF block");
+    }
+    const uint32_t decompressed_size = LoadLittleEndian32(data + size - 4);
+    std::shared_ptr<arrow::Buffer> buffer;
+    RETURN_NOT_OK(arrow::AllocateBuffer(pool, decompressed_size, &buffer));
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, kGzipWindowBits) != Z_OK) {
+      return arrow::Status::OutOfMemory("Could not initialize gzip decompression");
+    }
+    // inflate() rejects a null output, even if empty (e.g. BGZF end blocks)
+    Bytef empty;
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = decompressed_size > 0 ? buffer->mutable_data() : &empty;
+    stream.avail_out = decompressed_size;
+    int ret = inflate(&stream, Z_FINISH);
+    const uLong total_out = stream.total_out;
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END || total_out != decompressed_size) {
+      return arrow::Status::Invalid("Corrupt BGZF block");
+    }
+    *out = buffer;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Stream(const uint8_t* in, int64_t in_size, int64_t* consumed,
+                       uint8_t* out, int64_t out_size, int64_t* produced) override {
+    if (!stream_initialized_) {
+      std::memset(&stream_, 0, sizeof(stream_));
+      if (inflateInit2(&stream_, kGzipWindowBits) != Z_OK) {
+        return arrow::Status::OutOfMemory("Could not initialize gzip decompression");
+      }
+      stream_initialized_ = true;
+    } else if (member_finished_ && in_size > 0) {
+      // Next member
+      inflateReset(&stream_);
+    }
+    member_finished_ = false;
+
+    stream_.next_in = const_cast<Bytef*>(in);
+    stream_.avail_in = static_cast<uInt>(in_size);
+    stream_.next_out = out;
+    stream_.avail_out = static_cast<uInt>(out_size);
+    int ret = inflate(&stream_, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      member_finished_ = true;
+    } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      return arrow::Status::Invalid("gzip decompression failed: ",
+                                    stream_.msg ? stream_.msg : "corrupt data");
+    }
+    *consumed = in_size - stream_.avail_in;
+    *produced = out_size - stream_.avail_out;
+    return arrow::Status::OK();
+  }
+
+  bool StreamFinished() const override {
+    return !stream_initialized_ || member_finished_;
+  }
+
+ private:
+  z_stream stream_;
+  bool stream_initialized_ = false;
+  bool member_finished_ = false;
+};
+
+// zstd frames (including skippable frames, e.g. seek tables)
+class ZstdCodec : public Codec {
+ public:
+  ~ZstdCodec() override {
+    if (stream_ != nullptr) {
+      ZSTD_freeDStream(stream_);
+    }
+  }
+
+  arrow::Status FrameSize(const uint8_t* data, int64_t size,
+                          int64_t* frame_size) const override {
+    // Walks the block headers only; fails until the frame is whole
+    size_t ret = ZSTD_findFrameCompressedSize(data, static_cast<size_t>(size));
+    if (!ZSTD_isError(ret)) {
+      *frame_size = static_cast<int64_t>(ret);
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status DecompressFrame(arrow::MemoryPool* pool, const uint8_t* data,
+                                int64_t size,
+                                std::shared_ptr<arrow::Buffer>* out) const override {
+    unsigned long long content_size =
+        ZSTD_getFrameContentSize(data, static_cast<size_t>(size));
+    if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+      return arrow::Status::Invalid("Corrupt zstd frame");
+    }
+    if (content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+      return DecompressUnsizedFrame(pool, data, size, out);
+    }
+    std::shared_ptr<arrow::Buffer> buffer;
+    RETURN_NOT_OK(
+        arrow::AllocateBuffer(pool, static_cast<int64_t>(content_size), &buffer));
+    size_t ret = ZSTD_decompress(buffer->mutable_data(), content_size, data,
+                                 static_cast<size_t>(size));
+    if (ZSTD_isError(ret)) {
+      return arrow::Status::Invalid("zstd decompression failed: ",
+                                    ZSTD_getErrorName(ret));
+    }
+    if (ret != content_size) {
+      return arrow::Status::Invalid("Corrupt zstd frame");
+    }
+    *out = buffer;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Stream(const uint8_t* in, int64_t in_size, int64_t* consumed,
+                       uint8_t* out, int64_t out_size, int64_t* produced) override {
+    if (stream_ == nullptr) {
+      stream_ = ZSTD_createDStream();
+      if (stream_ == nullptr) {
+        return arrow::Status::OutOfMemory("Could not initialize zstd decompression");
+      }
+      ZSTD_initDStream(stream_);
+    }
+    ZSTD_inBuffer input = {in, static_cast<size_t>(in_size), 0};
+    ZSTD_outBuffer output = {out, static_cast<size_t>(out_size), 0};
+    size_t ret = ZSTD_decompressStream(stream_, &output, &input);
+    if (ZSTD_isError(ret)) {
+      return arrow::Status::Invalid("zstd decompression failed: ",
+                                    ZSTD_getErrorName(ret));
+    }
+    // 0 once a frame is done and flushed
+    frame_finished_ = (ret == 0);
+    *consumed = static_cast<int64_t>(input.pos);
+    *produced = static_cast<int64_t>(output.pos);
+    return arrow::Status::OK();
+  }
+
+  bool StreamFinished() const override { return frame_finished_; }
+
+ private:
+  // Frames written by streaming compressors may not record their size
+  arrow::Status DecompressUnsizedFrame(arrow::MemoryPool* pool, const uint8_t* data,
+                                       int64_t size,
+                                       std::shared_ptr<arrow::Buffer>* out) const {
+    std::shared_ptr<arrow::ResizableBuffer> buffer;
+    RETURN_NOT_OK(arrow::AllocateResizableBuffer(pool, 4 * size, &buffer));
+    std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(
+        ZSTD_createDStream(), ZSTD_freeDStream);
+    if (stream == nullptr) {
+      return arrow::Status::OutOfMemory("Could not initialize zstd decompression");
+    }
+    ZSTD_initDStream(stream.get());
+
+    ZSTD_inBuffer input = {data, static_cast<size_t>(size), 0};
+    int64_t out_size = 0;
+    while (true) {
+      if (out_size == buffer->size()) {
+        RETURN_NOT_OK(buffer->Resize(2 * buffer->size()));
+      }
+      ZSTD_outBuffer output = {buffer->mutable_data() + out_size,
+                               static_cast<size_t>(buffer->size() - out_size), 0};
+      size_t ret = ZSTD_decompressStream(stream.get(), &output, &input);
+      if (ZSTD_isError(ret)) {
+        return arrow::Status::Invalid("zstd decompression failed: ",
+                                      ZSTD_getErrorName(ret));
+      }
+      out_size += static_cast<int64_t>(output.pos);
+      if (ret == 0) {
+        break;
+      }
+      if (input.pos == input.size && output.pos < output.size) {
+        return arrow::Status::Invalid("Truncated zstd frame");
+      }
+    }
+    RETURN_NOT_OK(buffer->Resize(out_size));
+    *out = buffer;
+    return arrow::Status::OK();
+  }
+
+  ZSTD_DStream* stream_ = nullptr;
+  bool frame_finished_ = true;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// Decompressing stream
+
+class DecompressingStream : public arrow::io::InputStream {
+ public:
+  // codec is null for uncompressed data; head holds the bytes already read
+  // from the input stream
+  DecompressingStream(arrow::MemoryPool* pool, arrow::internal::ThreadPool* thread_pool,
+                      int32_t max_parallelism,
+                      std::shared_ptr<arrow::io::InputStream> input,
+                      std::unique_ptr<Codec> codec, std::string head)
+      : pool_(pool),
+        thread_pool_(thread_pool),
+        input_(std::move(input)),
+        codec_(std::move(codec)),
+        pending_(std::move(head)) {
+    // Keep the workers busy while the reader consumes finished frames, or
+    // only run as many frames at once as allowed
+    const int32_t parallelism = GetParallelism(thread_pool_, max_parallelism);
+    if (thread_pool_ == nullptr) {
+      max_frames_ = 1;
+    } else if (parallelism < thread_pool_->GetCapacity()) {
+      max_frames_ = parallelism;
+    } else {
+      max_frames_ = 2 * parallelism;
+    }
+  }
+
+  ~DecompressingStream() override { ARROW_UNUSED(Close()); }
+
+  arrow::Status Close() override {
+    if (closed_) {
+      return arrow::Status::OK();
+    }
+    closed_ = true;
+    // Frame tasks hold on to the codec
+    for (auto& frame : frames_) {
+      frame.wait();
+    }
+    frames_.clear();
+    return input_->Close();
+  }
+
+  arrow::Status Tell(int64_t* position) const override {
+    *position = position_;
+    return arrow::Status::OK();
+  }
+
+  bool closed() const override { return closed_; }
+
+  // Whether the input is compressed
+  bool compressed() const { return codec_ != nullptr; }
+
+  arrow::Status Read(int64_t nbytes, int64_t* bytes_read, void* out) override {
+    if (closed_) {
+      return arrow::Status::Invalid("Operation on closed stream");
+    }
+    uint8_t* dest = static_cast<uint8_t*>(out);
+    int64_t total = 0;
+    if (codec_ == nullptr) {
+      RETURN_NOT_OK(ReadUncompressed(nbytes, dest, &total));
+    }
+    while (codec_ != nullptr && total < nbytes) {
+      // Frame decompressed already
+      if (current_ && current_pos_ < current_->size()) {
+        int64_t size = std::min(nbytes - total, current_->size() - current_pos_);
+        std::memcpy(dest + total, current_->data() + current_pos_, size);
+        current_pos_ += size;
+        total += size;
+        continue;
+      }
+      current_.reset();
+      // Next frame, keeping more in flight
+      if (!streaming_ || !frames_.empty()) {
+        RETURN_NOT_OK(SubmitFrames());
+        if (!frames_.empty()) {
+          FrameResult result = frames_.front().get();
+          frames_.pop_front();
+          RETURN_NOT_OK(result.first);
+          current_ = result.second;
+          current_pos_ = 0;
+          continue;
+        }
+        if (!streaming_) {
+          // End of data
+          break;
+        }
+      }
+      // Serial fallback, straight into the output
+      int64_t produced = 0;
+      RETURN_NOT_OK(ReadStreaming(nbytes - total, dest + total, &produced));
+      if (produced == 0) {
+        break;
+      }
+      total += produced;
+    }
+    position_ += total;
+    *bytes_read = total;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Read(int64_t nbytes, std::shared_ptr<arrow::Buffer>* out) override {
+    std::shared_ptr<arrow::ResizableBuffer> buffer;
+    RETURN_NOT_OK(arrow::AllocateResizableBuffer(pool_, nbytes, &buffer));
+    int64_t bytes_read = 0;
+    RETURN_NOT_OK(Read(nbytes, &bytes_read, buffer->mutable_data()));
+    if (bytes_read < nbytes) {
+      RETURN_NOT_OK(buffer->Resize(bytes_read));
+    }
+    *out = buffer;
+    return arrow::Status::OK();
+  }
+
+ private:
+  using FrameResult = std::pair<arrow::Status, std::shared_ptr<arrow::Buffer>>;
+
+  arrow::Status ReadUncompressed(int64_t nbytes, uint8_t* dest, int64_t* total) {
+    int64_t size = std::min<int64_t>(nbytes, pending_.size() - pending_pos_);
+    std::memcpy(dest, pending_.data() + pending_pos_, size);
+    pending_pos_ += size;
+    int64_t bytes_read = 0;
+    if (size < nbytes) {
+      RETURN_NOT_OK(input_->Read(nbytes - size, &bytes_read, dest + size));
+    }
+    *total = size + bytes_read;
+    return arrow::Status::OK();
+  }
+
+  // Append the next chunk of compressed data to the pending data
+  arrow::Status ReadInput() {
+    pending_.erase(0, pending_pos_);
+    pending_pos_ = 0;
+    std::shared_ptr<arrow::Buffer> chunk;
+    RETURN_NOT_OK(input_->Read(kInputChunkSize, &chunk));
+    if (chunk->size() == 0) {
+      input_eof_ = true;
+    } else {
+      pending_.append(reinterpret_cast<const char*>(chunk->data()), chunk->size());
+    }
+    return arrow::Status::OK();
+  }
+
+  // Start decompressing the next frames, until enough are in flight.  Sets
+  // streaming_ when the rest of the data must be decompressed serially.
+  arrow::Status SubmitFrames() {
+    while (!streaming_ && static_cast<int32_t>(frames_.size()) < max_frames_) {
+      const int64_t available = pending_.size() - pending_pos_;
+      if (available == 0) {
+        if (input_eof_) {
+          break;
+        }
+        RETURN_NOT_OK(ReadInput());
+        continue;
+      }
+      int64_t frame_size = 0;
+      RETURN_NOT_OK(codec_->FrameSize(
+          reinterpret_cast<const uint8_t*>(pending_.data()) + pending_pos_, available,
+          &frame_size));
+      if (frame_size > 0 && frame_size <= available) {
+        SubmitFrame(frame_size);
+        continue;
+      }
+      if (frame_size >= 0 && !input_eof_ && available < kMaxFrameSize) {
+        RETURN_NOT_OK(ReadInput());
+        continue;
+      }
+      // Not split into frames, or too large or truncated frame: streaming
+      // reports errors, if any
+      streaming_ = true;
+    }
+    return arrow::Status::OK();
+  }
+
+  void SubmitFrame(int64_t frame_size) {
+    auto frame = std::make_shared<std::string>(pending_, pending_pos_, frame_size);
+    pending_pos_ += frame_size;
+    const Codec* codec = codec_.get();
+    arrow::MemoryPool* pool = pool_;
+    auto task = [codec, pool, frame]() -> FrameResult {
+      std::shared_ptr<arrow::Buffer> out;
+      arrow::Status status = codec->DecompressFrame(
+          pool, reinterpret_cast<const uint8_t*>(frame->data()), frame->size(), &out);
+      return FrameResult(status, out);
+    };
+    if (thread_pool_ != nullptr) {
+      frames_.push_back(thread_pool_->Submit(task));
+    } else {
+      std::promise<FrameResult> result;
+      result.set_value(task());
+      frames_.push_back(result.get_future());
+    }
+  }
+
+  arrow::Status ReadStreaming(int64_t nbytes, uint8_t* dest, int64_t* produced) {
+    *produced = 0;
+    while (true) {
+      const int64_t available = pending_.size() - pending_pos_;
+      if (available > 0 || !codec_->StreamFinished()) {
+        // Also flushes output held back by the decompressor
+        int64_t consumed = 0;
+        RETURN_NOT_OK(codec_->Stream(
+            reinterpret_cast<const uint8_t*>(pending_.data()) + pending_pos_, available,
+            &consumed, dest, nbytes, produced));
+        pending_pos_ += consumed;
+        if (*produced > 0) {
+          return arrow::Status::OK();
+        }
+        if (available > 0 && consumed == 0) {
+          return arrow::Status::Invalid("Compressed data could not be decoded");
+        }
+      }
+      if (pending_pos_ < static_cast<int64_t>(pending_.size())) {
+        continue;
+      }
+      if (input_eof_) {
+        if (!codec_->StreamFinished()) {
+          return arrow::Status::Invalid("Truncated compressed data");
+        }
+        return arrow::Status::OK();
+      }
+      RETURN_NOT_OK(ReadInput());
+    }
+  }
+
+  arrow::MemoryPool* pool_;
+  arrow::internal::ThreadPool* thread_pool_;
+  std::shared_ptr<arrow::io::InputStream> input_;
+  std::unique_ptr<Codec> codec_;
+  bool closed_ = false;
+  // Decompressed bytes read
+  int64_t position_ = 0;
+
+  // Compressed data read from the input stream, but not consumed yet
+  std::string pending_;
+  int64_t pending_pos_ = 0;
+  bool input_eof_ = false;
+
+  // Frames in flight, in order, and the frame being read
+  int32_t max_frames_;
+  std::deque<std::future<FrameResult>> frames_;
+  std::shared_ptr<arrow::Buffer> current_;
+  int64_t current_pos_ = 0;
+
+  // Whether the rest of the data is decompressed serially
+  bool streaming_ = false;
+};
+
+arrow::Status MakeDecompressingStream(arrow::MemoryPool* pool,
+                                      arrow::internal::ThreadPool* thread_pool,
+                                      int32_t max_parallelism,
+                                      std::shared_ptr<arrow::io::InputStream> input,
+                                      std::shared_ptr<arrow::io::InputStream>* out) {
+  // Sniff the magic bytes, without consuming them if the stream can peek or
+  // read at its position
+  static constexpr int64_t kMagicSize = 4;
+  std::string head;
+  bool consumed = false;
+  arrow::util::string_view peeked;
+  auto file = std::dynamic_pointer_cast<arrow::io::RandomAccessFile>(input);
+  int64_t position;
+  if (input->Peek(kMagicSize, &peeked).ok()) {
+    head.assign(peeked.data(), peeked.size());
+  } else if (file && file->Tell(&position).ok()) {
+    std::shared_ptr<arrow::Buffer> buffer;
+    RETURN_NOT_OK(file->ReadAt(position, kMagicSize, &buffer));
+    // ReadAt may move the position
+    RETURN_NOT_OK(file->Seek(position));
+    head.assign(reinterpret_cast<const char*>(buffer->data()), buffer->size());
+  } else {
+    consumed = true;
+    while (static_cast<int64_t>(head.size()) < kMagicSize) {
+      std::shared_ptr<arrow::Buffer> buffer;
+      RETURN_NOT_OK(input->Read(kMagicSize - head.size(), &buffer));
+      if (buffer->size() == 0) {
+        break;
+      }
+      head.append(reinterpret_cast<const char*>(buffer->data()), buffer->size());
+    }
+  }
+
+  std::unique_ptr<Codec> codec;
+  const uint8_t* magic = reinterpret_cast<const uint8_t*>(head.data());
+  if (head.size() >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) {
+    codec.reset(new GzipCodec());
+  } else if (head.size() == kMagicSize &&
+             LoadLittleEndian32(magic) == ZSTD_MAGICNUMBER) {
+    codec.reset(new ZstdCodec());
+  } else if (head.size() == kMagicSize &&
+             (LoadLittleEndian32(magic) & 0xFFFFFFF0) ==
+                 ZSTD_MAGIC_SKIPPABLE_START) {
+    // Seekable zstd files may start with a skippable frame
+    codec.reset(new ZstdCodec());
+  }
+  if (!consumed) {
+    if (!codec) {
+      // Plain data is read from the stream itself
+      *out = std::move(input);
+      return arrow::Status::OK();
+    }
+    head.clear();
+  }
+  *out = std::make_shared<DecompressingStream>(pool, thread_pool, max_parallelism,
+                                               std::move(input), std::move(codec),
+                                               std::move(head));
+  return arrow::Status::OK();
+}
+
+bool IsDecompressing(const arrow::io::InputStream& stream) {
+  auto decompressing = dynamic_cast<const DecompressingStream*>(&stream);
+  return decompressing != nullptr && decompressing->compressed();
+}
+
+}  // namespace fwfr
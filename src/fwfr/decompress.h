@@ -0,0 +1,59 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_DECOMPRESS_H
+#define FWFR_DECOMPRESS_H
+
+#include <cstdint>
+#include <memory>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    class MemoryPool;
+
+    namespace internal {
+        class ThreadPool;
+    }
+
+    namespace io {
+        class InputStream;
+    }
+}
+
+namespace fwfr {
+
+/// \brief Wrap a stream so as to read gzip or zstd data decompressed
+///
+/// The compression is detected from the magic bytes at the start of the
+/// data, and other data is read as is.  Data made of independent frames
+/// whose compressed size can be found without decompressing them (BGZF
+/// blocks, zstd frames) is decompressed in parallel on the thread pool, a
+/// few frames ahead of the reader, and read back in order.  Other data
+/// (plain and multi-member gzip, zstd frames too large to buffer) is
+/// decompressed serially by streaming.  If thread_pool is null, frames are
+/// decompressed by the reading thread; max_parallelism (if positive) caps
+/// the number of frames decompressed at once.  If no compression is found,
+/// out is input itself, unless it can neither peek nor read at its position
+/// (the sniffed bytes are then read back from the wrapping stream).
+ARROW_EXPORT arrow::Status MakeDecompressingStream(
+    arrow::MemoryPool* pool, arrow::internal::ThreadPool* thread_pool,
+    int32_t max_parallelism, std::shared_ptr<arrow::io::InputStream> input,
+    std::shared_ptr<arrow::io::InputStream>* out);
+
+/// \brief Return whether a stream made by MakeDecompressingStream found
+/// compressed data
+ARROW_EXPORT bool IsDecompressing(const arrow::io::InputStream& stream);
+
+}  // namespace fwfr
+
+#endif  // FWFR_DECOMPRESS_H
@@ -0,0 +1,52 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_FORWARDING_TASK_GROUP_H
+#define FWFR_FORWARDING_TASK_GROUP_H
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <arrow/status.h>
+#include <arrow/util/task-group.h>
+
+namespace fwfr {
+
+/// \class ForwardingTaskGroup
+/// \brief Task group appending its tasks, wrapped by Wrap(), to another one
+class ForwardingTaskGroup : public arrow::internal::TaskGroup {
+ public:
+  explicit ForwardingTaskGroup(std::shared_ptr<arrow::internal::TaskGroup> task_group)
+      : task_group_(std::move(task_group)) {}
+
+  arrow::Status current_status() override { return task_group_->current_status(); }
+
+  bool ok() override { return task_group_->ok(); }
+
+  arrow::Status Finish() override { return task_group_->Finish(); }
+
+  int parallelism() override { return task_group_->parallelism(); }
+
+ protected:
+  // Return the task run by the wrapped group in place of task
+  virtual std::function<arrow::Status()> Wrap(std::function<arrow::Status()> task) = 0;
+
+  void AppendReal(std::function<arrow::Status()> task) override {
+    task_group_->Append(Wrap(std::move(task)));
+  }
+
+  std::shared_ptr<arrow::internal::TaskGroup> task_group_;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_FORWARDING_TASK_GROUP_H
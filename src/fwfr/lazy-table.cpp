@@ -0,0 +1,208 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/lazy-table.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <fwfr/column-builder.h>
+#include <fwfr/parser.h>
+#include <fwfr/scheduler.h>
+
+#include <arrow/table.h>
+#include <arrow/type.h>
+#include <arrow/util/task-group.h>
+#include <arrow/util/thread-pool.h>
+
+namespace fwfr {
+
+LazyTable::LazyTable(std::shared_ptr<arrow::MemoryPool> pool,
+                     std::shared_ptr<arrow::MemoryPool> output_pool,
+                     arrow::internal::ThreadPool* thread_pool,
+                     int32_t max_parallelism,
+                     ReadOptions::Priority priority,
+                     int64_t output_chunk_rows,
+                     const std::vector<std::string>& column_names,
+                     const ConvertOptions& convert_options,
+                     std::vector<std::shared_ptr<BlockParser>> parsers)
+    : pool_(std::move(pool)),
+      output_pool_(std::move(output_pool)),
+      thread_pool_(thread_pool),
+      max_parallelism_(max_parallelism),
+      priority_(priority),
+      output_chunk_rows_(output_chunk_rows),
+      column_names_(column_names),
+      convert_options_(convert_options),
+      parsers_(std::move(parsers)),
+      columns_(column_names.size()),
+      converting_(column_names.size(), false) {
+  for (const auto& parser : parsers_) {
+    num_rows_ += parser->num_rows();
+  }
+}
+
+int32_t LazyTable::GetColumnIndex(const std::string& name) const {
+  auto it = std::find(column_names_.begin(), column_names_.end(), name);
+  if (it == column_names_.end()) {
+    return -1;
+  }
+  return static_cast<int32_t>(it - column_names_.begin());
+}
+
+std::shared_ptr<arrow::DataType> LazyTable::column_type(int32_t i) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (columns_[i]) {
+    return columns_[i]->type();
+  }
+  auto it = convert_options_.column_types.find(column_names_[i]);
+  if (it == convert_options_.column_types.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+arrow::Status LazyTable::Convert(const std::vector<int32_t>& indices) {
+  for (int32_t i : indices) {
+    if (i < 0 || i >= num_columns()) {
+      return arrow::Status::IndexError("Column index ", i, " out of bounds");
+    }
+  }
+
+  // Claim the columns to convert, and a reference to the parsed blocks,
+  // then convert them without holding the lock
+  std::vector<int32_t> pending;
+  std::vector<std::shared_ptr<BlockParser>> parsers;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Columns being converted by another call are waited for, not converted
+    // twice (and converted here if that call failed)
+    converted_.wait(lock, [&]() {
+      return std::none_of(indices.begin(), indices.end(),
+                          [&](int32_t i) { return converting_[i]; });
+    });
+    for (int32_t i : indices) {
+      if (!columns_[i] && !converting_[i]) {
+        converting_[i] = true;
+        pending.push_back(i);
+      }
+    }
+    if (pending.empty()) {
+      return arrow::Status::OK();
+    }
+    parsers = parsers_;
+  }
+
+  std::vector<std::shared_ptr<arrow::Column>> converted;
+  arrow::Status status = ConvertColumns(pending, parsers, &converted);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t k = 0; k < pending.size(); ++k) {
+    converting_[pending[k]] = false;
+    if (status.ok()) {
+      columns_[pending[k]] = converted[k];
+      ++num_converted_;
+    }
+  }
+  if (num_converted_ == num_columns()) {
+    // Every column is cached, the parsed data is no longer needed
+    parsers_.clear();
+  }
+  converted_.notify_all();
+  return status;
+}
+
+arrow::Status LazyTable::ConvertColumns(
+    const std::vector<int32_t>& indices,
+    const std::vector<std::shared_ptr<BlockParser>>& parsers,
+    std::vector<std::shared_ptr<arrow::Column>>* out) {
+  auto task_group = MakeTaskGroup(thread_pool_, max_parallelism_, priority_);
+  std::vector<std::shared_ptr<ColumnBuilder>> builders;
+  for (int32_t i : indices) {
+    std::shared_ptr<ColumnBuilder> builder;
+    const ConvertOptions column_options =
+        convert_options_.ForColumn(column_names_[i], i);
+    auto it = convert_options_.column_types.find(column_names_[i]);
+    if (it == convert_options_.column_types.end()) {
+      RETURN_NOT_OK(
+          ColumnBuilder::Make(i, column_options, pool_.get(), task_group, &builder));
+    } else {
+      RETURN_NOT_OK(ColumnBuilder::Make(it->second, i, column_options, pool_.get(),
+                                        task_group, &builder));
+    }
+    builders.push_back(builder);
+  }
+  for (size_t block_index = 0; block_index < parsers.size(); ++block_index) {
+    ColumnBuilder::InsertColumns(builders, static_cast<int64_t>(block_index),
+                                 parsers[block_index]);
+  }
+  RETURN_NOT_OK(task_group->Finish());
+
+  std::vector<std::shared_ptr<arrow::Column>> converted;
+  for (size_t k = 0; k < indices.size(); ++k) {
+    std::shared_ptr<arrow::ChunkedArray> array;
+    RETURN_NOT_OK(builders[k]->Finish(&array));
+    converted.push_back(std::make_shared<arrow::Column>(column_names_[indices[k]], array));
+  }
+  if (output_chunk_rows_ > 0) {
+    task_group = MakeTaskGroup(thread_pool_, max_parallelism_, priority_);
+    RETURN_NOT_OK(
+        CoalesceColumns(output_chunk_rows_, output_pool_.get(), task_group, &converted));
+  }
+  *out = std::move(converted);
+  return arrow::Status::OK();
+}
+
+arrow::Status LazyTable::MakeTable(const std::vector<int32_t>& indices,
+                                   std::shared_ptr<arrow::Table>* out) {
+  RETURN_NOT_OK(Convert(indices));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Column>> columns;
+  for (int32_t i : indices) {
+    columns.push_back(columns_[i]);
+    fields.push_back(columns_[i]->field());
+  }
+  *out = arrow::Table::Make(arrow::schema(fields), columns, num_rows_);
+  return arrow::Status::OK();
+}
+
+arrow::Status LazyTable::Column(int32_t i, std::shared_ptr<arrow::Column>* out) {
+  RETURN_NOT_OK(Convert({i}));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  *out = columns_[i];
+  return arrow::Status::OK();
+}
+
+arrow::Status LazyTable::Select(const std::vector<std::string>& names,
+                                std::shared_ptr<arrow::Table>* out) {
+  std::vector<int32_t> indices;
+  for (const auto& name : names) {
+    const int32_t i = GetColumnIndex(name);
+    if (i < 0) {
+      return arrow::Status::KeyError("Column '", name, "' not found");
+    }
+    indices.push_back(i);
+  }
+  return MakeTable(indices, out);
+}
+
+arrow::Status LazyTable::ToTable(std::shared_ptr<arrow::Table>* out) {
+  std::vector<int32_t> indices;
+  for (int32_t i = 0; i < num_columns(); ++i) {
+    indices.push_back(i);
+  }
+  return MakeTable(indices, out);
+}
+
+}  // namespace fwfr
@@ -0,0 +1,119 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_LAZY_TABLE_H
+#define FWFR_LAZY_TABLE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fwfr/options.h>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    class Column;
+    class DataType;
+    class MemoryPool;
+    class Table;
+
+    namespace internal {
+        class ThreadPool;
+    }
+}
+
+namespace fwfr {
+
+class BlockParser;
+
+/// \class LazyTable
+/// \brief A parsed FWF table whose columns are converted on first access
+///
+/// The parsed blocks are retained until every column has been converted.
+/// Requested columns are converted in parallel across blocks (and across
+/// columns when several are requested at once), then cached.
+class ARROW_EXPORT LazyTable {
+ public:
+  /// Columns are converted into arrays allocated from pool, then concatenated
+  /// from output_pool into chunks of at least output_chunk_rows rows if
+  /// positive (else one per block).  A null thread_pool converts serially,
+  /// and max_parallelism (if positive) caps the number of blocks converted
+  /// at once
+  LazyTable(std::shared_ptr<arrow::MemoryPool> pool,
+            std::shared_ptr<arrow::MemoryPool> output_pool,
+            arrow::internal::ThreadPool* thread_pool, int32_t max_parallelism,
+            ReadOptions::Priority priority, int64_t output_chunk_rows,
+            const std::vector<std::string>& column_names,
+            const ConvertOptions& convert_options,
+            std::vector<std::shared_ptr<BlockParser>> parsers);
+
+  int32_t num_columns() const { return static_cast<int32_t>(column_names_.size()); }
+  int64_t num_rows() const { return num_rows_; }
+  const std::vector<std::string>& column_names() const { return column_names_; }
+
+  /// \brief Return the index of the named column, or -1 if there is none
+  int32_t GetColumnIndex(const std::string& name) const;
+
+  /// \brief Return the column's type, or null if it is inferred and
+  /// not converted yet
+  std::shared_ptr<arrow::DataType> column_type(int32_t i);
+
+  /// \brief Return the given column, converting it if needed
+  arrow::Status Column(int32_t i, std::shared_ptr<arrow::Column>* out);
+
+  /// \brief Return a table of the named columns, converting them if needed
+  arrow::Status Select(const std::vector<std::string>& names,
+                       std::shared_ptr<arrow::Table>* out);
+
+  /// \brief Return a table of all columns, converting them if needed
+  arrow::Status ToTable(std::shared_ptr<arrow::Table>* out);
+
+ protected:
+  // Convert (and cache) the given columns, holding mutex_ only to claim
+  // them and to publish them
+  arrow::Status Convert(const std::vector<int32_t>& indices);
+  // Convert the given columns of the given blocks, without the lock
+  arrow::Status ConvertColumns(const std::vector<int32_t>& indices,
+                               const std::vector<std::shared_ptr<BlockParser>>& parsers,
+                               std::vector<std::shared_ptr<arrow::Column>>* out);
+  arrow::Status MakeTable(const std::vector<int32_t>& indices,
+                          std::shared_ptr<arrow::Table>* out);
+
+  std::mutex mutex_;
+  // Signalled once a call is done converting its columns
+  std::condition_variable converted_;
+
+  std::shared_ptr<arrow::MemoryPool> pool_;
+  std::shared_ptr<arrow::MemoryPool> output_pool_;
+  arrow::internal::ThreadPool* thread_pool_;
+  int32_t max_parallelism_;
+  ReadOptions::Priority priority_;
+  int64_t output_chunk_rows_;
+  std::vector<std::string> column_names_;
+  ConvertOptions convert_options_;
+  int64_t num_rows_ = 0;
+
+  // The parsers of each block, released once all columns are converted
+  std::vector<std::shared_ptr<BlockParser>> parsers_;
+  std::vector<std::shared_ptr<arrow::Column>> columns_;
+  // Whether each column is being converted by some call
+  std::vector<bool> converting_;
+  int32_t num_converted_ = 0;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_LAZY_TABLE_H
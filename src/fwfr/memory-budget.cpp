@@ -0,0 +1,79 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/memory-budget.h>
+
+#include <functional>
+#include <utility>
+
+#include <fwfr/forwarding-task-group.h>
+
+namespace fwfr {
+
+/////////////////////////////////////////////////////////////////////////
+// Task group counting its tasks in flight
+
+class BudgetTaskGroup : public ForwardingTaskGroup {
+ public:
+  BudgetTaskGroup(MemoryBudget* budget,
+                  std::shared_ptr<arrow::internal::TaskGroup> task_group)
+      : ForwardingTaskGroup(std::move(task_group)), budget_(budget) {}
+
+ protected:
+  // Done when the last copy of the task is destroyed, whether the task ran
+  // or was dropped after an error
+  struct InFlight {
+    explicit InFlight(MemoryBudget* budget) : budget(budget) { budget->TaskStarted(); }
+    ~InFlight() { budget->TaskDone(); }
+    MemoryBudget* budget;
+  };
+
+  std::function<arrow::Status()> Wrap(std::function<arrow::Status()> task) override {
+    auto in_flight = std::make_shared<InFlight>(budget_);
+    return [in_flight, task]() { return task(); };
+  }
+
+  MemoryBudget* budget_;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// MemoryBudget
+
+std::shared_ptr<MemoryBudget> MemoryBudget::Make(arrow::MemoryPool* pool,
+                                                 int64_t max_bytes) {
+  return Adopt(new MemoryBudget(pool, max_bytes));
+}
+
+std::shared_ptr<arrow::internal::TaskGroup> MemoryBudget::WrapTaskGroup(
+    const std::shared_ptr<arrow::internal::TaskGroup>& task_group) {
+  // The task group is used by the read, which holds the budget, and the
+  // budget outlives the tasks in flight
+  return std::make_shared<BudgetTaskGroup>(this, task_group);
+}
+
+void MemoryBudget::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return bytes_allocated_ <= max_bytes_ || num_tasks_ == 0; });
+}
+
+void MemoryBudget::TaskStarted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++num_tasks_;
+}
+
+void MemoryBudget::TaskDone() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  --num_tasks_;
+  cv_.notify_all();
+  MaybeDelete(&lock);
+}
+
+}  // namespace fwfr
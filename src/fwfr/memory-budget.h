@@ -0,0 +1,85 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_MEMORY_BUDGET_H
+#define FWFR_MEMORY_BUDGET_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+
+#include <arrow/memory_pool.h>
+#include <arrow/util/visibility.h>
+
+#include <fwfr/counting-pool.h>
+
+namespace arrow {
+    namespace internal {
+        class TaskGroup;
+    }
+}
+
+namespace fwfr {
+
+/// \class MemoryBudget
+/// \brief Memory pool capping the memory held by a read
+///
+/// Allocations are forwarded to the wrapped pool and never refused.
+/// Instead, the reading thread calls Wait() before it reads or submits
+/// another block, which blocks while the read holds more than max_bytes and
+/// some of its tasks are still queued or running, and so may release memory.
+/// With no task in flight, Wait() returns at once, so a read holding more
+/// than max_bytes for good (e.g. retained parsers) goes on one block at a
+/// time rather than stall.
+class ARROW_EXPORT MemoryBudget : public CountingPool {
+ public:
+  /// \brief Make a budget of max_bytes over pool
+  ///
+  /// Buffers allocated through the budget may outlive the returned pointer
+  /// (e.g. in the table read), so the budget itself is only destroyed once
+  /// that pointer is gone, all its allocations are freed and none of its
+  /// tasks is in flight.
+  static std::shared_ptr<MemoryBudget> Make(arrow::MemoryPool* pool, int64_t max_bytes);
+
+  int64_t max_bytes() const { return max_bytes_; }
+
+  /// \brief Wrap a task group so that its tasks count as in flight, from
+  /// their submission until they have run (or have been dropped).  Tasks
+  /// must not be appended once the pointer returned by Make() is gone.
+  std::shared_ptr<arrow::internal::TaskGroup> WrapTaskGroup(
+      const std::shared_ptr<arrow::internal::TaskGroup>& task_group);
+
+  /// \brief Wait until the read holds at most max_bytes, or has no task in
+  /// flight
+  void Wait();
+
+ protected:
+  friend class BudgetTaskGroup;
+
+  MemoryBudget(arrow::MemoryPool* pool, int64_t max_bytes)
+      : CountingPool(pool), max_bytes_(max_bytes) {}
+
+  void OnFreed() override { cv_.notify_all(); }
+  // Tasks in flight still use the budget
+  bool CanDelete() const override { return num_allocations_ == 0 && num_tasks_ == 0; }
+
+  void TaskStarted();
+  void TaskDone();
+
+  const int64_t max_bytes_;
+
+  std::condition_variable cv_;
+  int64_t num_tasks_ = 0;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_MEMORY_BUDGET_H
@@ -0,0 +1,397 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_NUMERIC_PARSING_H
+#define FWFR_NUMERIC_PARSING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include <arrow/type.h>
+#include <arrow/util/macros.h>
+#include <arrow/util/parsing.h>
+
+namespace fwfr {
+
+/////////////////////////////////////////////////////////////////////////
+// SWAR digit kernels
+//
+// Eight ASCII digits are loaded into a 64-bit word (first digit in the low
+// byte) and validated and decoded together with a few multiply-adds.
+
+inline uint64_t LoadEightBytes(const char* s) {
+  uint64_t word;
+  std::memcpy(&word, s, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+// Whether all eight bytes of the word are ASCII digits
+inline bool IsEightDigits(uint64_t word) {
+  return ((word & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// Decode eight ASCII digits, already validated by IsEightDigits()
+inline uint32_t DecodeEightDigits(uint64_t word) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 0x000F424000000064ULL;  // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001ULL;  // 1 + (10000 << 32)
+  word -= 0x3030303030303030ULL;
+  word = (word * 10) + (word >> 8);
+  word = (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+  return static_cast<uint32_t>(word);
+}
+
+// Any run of this many digits fits in a uint64_t
+constexpr size_t kMaxFastDigits = 19;
+
+// Parse a run of at most kMaxFastDigits ASCII digits, sixteen and eight at a time
+inline bool ParseDigits(const char* s, size_t n, uint64_t* out) {
+  uint64_t value = 0;
+  if (n >= 16) {
+    const uint64_t hi = LoadEightBytes(s);
+    const uint64_t lo = LoadEightBytes(s + 8);
+    if (ARROW_PREDICT_FALSE(!IsEightDigits(hi) || !IsEightDigits(lo))) {
+      return false;
+    }
+    value = DecodeEightDigits(hi) * 100000000ULL + DecodeEightDigits(lo);
+    s += 16;
+    n -= 16;
+  } else if (n >= 8) {
+    const uint64_t word = LoadEightBytes(s);
+    if (ARROW_PREDICT_FALSE(!IsEightDigits(word))) {
+      return false;
+    }
+    value = DecodeEightDigits(word);
+    s += 8;
+    n -= 8;
+  }
+  for (; n > 0; --n, ++s) {
+    const uint8_t digit = static_cast<uint8_t>(*s - '0');
+    if (ARROW_PREDICT_FALSE(digit > 9)) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  *out = value;
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Fixed-point kernel
+//
+// Clinger's fast path: a mantissa and a power of ten that are both exactly
+// representable give a correctly rounded result with a single division.
+
+template <typename Float>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double> {
+  static constexpr uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+  static constexpr int32_t kMaxExactPow10 = 22;
+  static double Pow10(int32_t exp) {
+    static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    return kPow10[exp];
+  }
+};
+
+template <>
+struct FloatTraits<float> {
+  static constexpr uint64_t kMaxExactMantissa = uint64_t(1) << 24;
+  static constexpr int32_t kMaxExactPow10 = 10;
+  static float Pow10(int32_t exp) {
+    static const float kPow10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                   1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    return kPow10[exp];
+  }
+};
+
+inline uint64_t IntegerPow10(size_t exp) {
+  static const uint64_t kPow10[] = {1ULL,
+                                    10ULL,
+                                    100ULL,
+                                    1000ULL,
+                                    10000ULL,
+                                    100000ULL,
+                                    1000000ULL,
+                                    10000000ULL,
+                                    100000000ULL,
+                                    1000000000ULL,
+                                    10000000000ULL,
+                                    100000000000ULL,
+                                    1000000000000ULL,
+                                    10000000000000ULL,
+                                    100000000000000ULL,
+                                    1000000000000000ULL,
+                                    10000000000000000ULL,
+                                    100000000000000000ULL,
+                                    1000000000000000000ULL,
+                                    10000000000000000000ULL};
+  return kPow10[exp];
+}
+
+// Parse "[+-]digits[.digits]", with implied_decimals applying when there is
+// no decimal point.  Return false for anything else (exponents, NaN,
+// too many digits, inexact values).
+template <typename Float>
+inline bool ParseFixedPoint(const char* s, size_t n, int32_t implied_decimals,
+                            Float* out) {
+  bool negative = false;
+  if (n > 0 && (*s == '-' || *s == '+')) {
+    negative = (*s == '-');
+    ++s;
+    --n;
+  }
+  const char* dot = static_cast<const char*>(std::memchr(s, '.', n));
+  const size_t int_len = dot ? static_cast<size_t>(dot - s) : n;
+  const size_t frac_len = dot ? n - int_len - 1 : 0;
+  if (ARROW_PREDICT_FALSE(int_len + frac_len == 0 || int_len + frac_len > kMaxFastDigits)) {
+    return false;
+  }
+  uint64_t int_part = 0;
+  uint64_t frac_part = 0;
+  if (ARROW_PREDICT_FALSE(int_len > 0 && !ParseDigits(s, int_len, &int_part)) ||
+      ARROW_PREDICT_FALSE(frac_len > 0 && !ParseDigits(dot + 1, frac_len, &frac_part))) {
+    return false;
+  }
+  const uint64_t mantissa = int_part * IntegerPow10(frac_len) + frac_part;
+  const int32_t scale = dot ? static_cast<int32_t>(frac_len) : implied_decimals;
+  if (ARROW_PREDICT_FALSE(mantissa > FloatTraits<Float>::kMaxExactMantissa ||
+                          scale > FloatTraits<Float>::kMaxExactPow10)) {
+    return false;
+  }
+  Float value = static_cast<Float>(mantissa);
+  if (scale > 0) {
+    value /= FloatTraits<Float>::Pow10(scale);
+  }
+  *out = negative ? -value : value;
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+// COBOL binary kernels
+//
+// These decode a raw field into an integer mantissa, leaving any implied
+// decimals to the caller.
+
+// Big-endian two's complement (USAGE COMP / BINARY), 1 to 8 bytes
+inline bool DecodeBinary(const uint8_t* data, uint32_t size, bool is_signed,
+                         int64_t* out) {
+  if (ARROW_PREDICT_FALSE(size == 0 || size > 8)) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < size; ++i) {
+    value = (value << 8) | data[i];
+  }
+  if (is_signed && size < 8 && (data[0] & 0x80) != 0) {
+    // Sign extend
+    value |= ~uint64_t(0) << (size * 8);
+  } else if (!is_signed && ARROW_PREDICT_FALSE(
+                               value > static_cast<uint64_t>(
+                                           std::numeric_limits<int64_t>::max()))) {
+    return false;
+  }
+  *out = static_cast<int64_t>(value);
+  return true;
+}
+
+// Packed decimal (USAGE COMP-3): two digits per byte, and a last byte
+// holding a digit and the sign nibble (0xD or 0xB for negative values)
+inline bool DecodePacked(const uint8_t* data, uint32_t size, int64_t* out) {
+  // Up to 19 digits, which fit in a uint64_t
+  if (ARROW_PREDICT_FALSE(size == 0 || size > 10)) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (uint32_t i = 0; i + 1 < size; ++i) {
+    const uint8_t hi = data[i] >> 4;
+    const uint8_t lo = data[i] & 0x0F;
+    if (ARROW_PREDICT_FALSE(hi > 9 || lo > 9)) {
+      return false;
+    }
+    value = value * 100 + hi * 10 + lo;
+  }
+  const uint8_t last = data[size - 1] >> 4;
+  const uint8_t sign = data[size - 1] & 0x0F;
+  if (ARROW_PREDICT_FALSE(last > 9 || sign < 0x0A)) {
+    return false;
+  }
+  value = value * 10 + last;
+  if (ARROW_PREDICT_FALSE(value >
+                          static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))) {
+    return false;
+  }
+  const bool negative = (sign == 0x0D || sign == 0x0B);
+  *out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+  return true;
+}
+
+// Scale a decoded mantissa by implied decimals into a column value
+// (as with text values, integer columns have no implied decimals)
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type ScaleMantissa(
+    int64_t mantissa, int32_t implied_decimals, T* out) {
+  if (std::is_signed<T>::value) {
+    if (ARROW_PREDICT_FALSE(mantissa < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                            mantissa > static_cast<int64_t>(std::numeric_limits<T>::max()))) {
+      return false;
+    }
+  } else if (ARROW_PREDICT_FALSE(
+                 mantissa < 0 ||
+                 static_cast<uint64_t>(mantissa) >
+                     static_cast<uint64_t>(std::numeric_limits<T>::max()))) {
+    return false;
+  }
+  *out = static_cast<T>(mantissa);
+  return true;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+ScaleMantissa(int64_t mantissa, int32_t implied_decimals, T* out) {
+  if (ARROW_PREDICT_FALSE(implied_decimals < 0 ||
+                          implied_decimals > FloatTraits<double>::kMaxExactPow10)) {
+    return false;
+  }
+  // Exact for mantissas below 2**53, as in ParseFixedPoint()
+  *out = static_cast<T>(static_cast<double>(mantissa) /
+                        FloatTraits<double>::Pow10(implied_decimals));
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Fixed-width value parsers
+//
+// A FixedWidthParser<T> is set up once per column and block, and converts
+// trimmed field values using the fastest applicable kernel.  Values the
+// kernels don't handle go through Arrow's generic StringConverter<T>, so
+// the accepted syntax is the same either way.
+
+template <typename T, typename Enable = void>
+class FixedWidthParser {
+ public:
+  using value_type = typename T::c_type;
+
+  FixedWidthParser(uint32_t width, int32_t implied_decimals) {}
+
+  bool operator()(const char* s, size_t n, value_type* out) {
+    return converter_(s, n, out);
+  }
+
+ protected:
+  arrow::internal::StringConverter<T> converter_;
+};
+
+template <typename T>
+class FixedWidthParser<
+    T, typename std::enable_if<std::is_integral<typename T::c_type>::value>::type> {
+ public:
+  using value_type = typename T::c_type;
+
+  // Allow for a sign in front of the digits
+  FixedWidthParser(uint32_t width, int32_t implied_decimals)
+      : use_kernel_(width <= kMaxFastDigits + 1) {}
+
+  bool operator()(const char* s, size_t n, value_type* out) {
+    return (use_kernel_ && ParseInteger(s, n, out)) || converter_(s, n, out);
+  }
+
+ protected:
+  static bool ParseInteger(const char* s, size_t n, value_type* out) {
+    bool negative = false;
+    if (std::is_signed<value_type>::value && n > 0 && *s == '-') {
+      negative = true;
+      ++s;
+      --n;
+    }
+    uint64_t magnitude;
+    if (ARROW_PREDICT_FALSE(n == 0 || n > kMaxFastDigits) ||
+        ARROW_PREDICT_FALSE(!ParseDigits(s, n, &magnitude))) {
+      return false;
+    }
+    const uint64_t max_magnitude =
+        static_cast<uint64_t>(std::numeric_limits<value_type>::max()) + (negative ? 1 : 0);
+    if (ARROW_PREDICT_FALSE(magnitude > max_magnitude)) {
+      return false;
+    }
+    // Two's complement negation keeps the minimum value in range
+    *out = static_cast<value_type>(negative ? (~magnitude + 1) : magnitude);
+    return true;
+  }
+
+  const bool use_kernel_;
+  arrow::internal::StringConverter<T> converter_;
+};
+
+template <typename T>
+class FixedWidthParser<
+    T, typename std::enable_if<std::is_floating_point<typename T::c_type>::value>::type> {
+ public:
+  using value_type = typename T::c_type;
+
+  FixedWidthParser(uint32_t width, int32_t implied_decimals)
+      : implied_decimals_(implied_decimals) {}
+
+  bool operator()(const char* s, size_t n, value_type* out) {
+    if (ARROW_PREDICT_TRUE(ParseFixedPoint(s, n, implied_decimals_, out))) {
+      return true;
+    }
+    if (implied_decimals_ > 0 && n > 0 && std::memchr(s, '.', n) == nullptr) {
+      return ConvertImplied(s, n, out);
+    }
+    return converter_(s, n, out);
+  }
+
+ protected:
+  // Slow path for implied decimals: spell out the decimal point and let
+  // the generic converter round the result
+  bool ConvertImplied(const char* s, size_t n, value_type* out) {
+    const size_t sign_len = (*s == '-' || *s == '+') ? 1 : 0;
+    const size_t digits = n - sign_len;
+    for (size_t i = sign_len; i < n; ++i) {
+      if (s[i] < '0' || s[i] > '9') {
+        // Not a plain number (e.g. an exponent or NaN), leave it as is
+        return converter_(s, n, out);
+      }
+    }
+    std::string spelled;
+    spelled.append(s, sign_len);
+    if (digits <= static_cast<size_t>(implied_decimals_)) {
+      spelled.append("0.");
+      spelled.append(implied_decimals_ - digits, '0');
+      spelled.append(s + sign_len, digits);
+    } else {
+      spelled.append(s + sign_len, digits - implied_decimals_);
+      spelled.push_back('.');
+      spelled.append(s + n - implied_decimals_, implied_decimals_);
+    }
+    return converter_(spelled.data(), spelled.size(), out);
+  }
+
+  const int32_t implied_decimals_;
+  arrow::internal::StringConverter<T> converter_;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_NUMERIC_PARSING_H
@@ -39,6 +39,41 @@ ConvertOptions ConvertOptions::Defaults() {
   return options;
 }
 
+ConvertOptions ConvertOptions::ForColumn(const std::string& name, int32_t index) const {
+  ConvertOptions options = *this;
+  options.column_options.clear();
+  options.column_index_options.clear();
+
+  const ColumnConvertOptions* column = nullptr;
+  auto it = column_options.find(name);
+  if (it != column_options.end()) {
+    column = &it->second;
+  } else {
+    auto index_it = column_index_options.find(index);
+    if (index_it != column_index_options.end()) {
+      column = &index_it->second;
+    }
+  }
+  if (column != nullptr) {
+    options.is_cobol = column->is_cobol;
+    options.null_values = column->null_values;
+    options.true_values = column->true_values;
+    options.false_values = column->false_values;
+    options.implied_decimals = column->implied_decimals;
+    options.strings_can_be_null = column->strings_can_be_null;
+    options.numeric_format = column->numeric_format;
+  }
+  return options;
+}
+
+ColumnConvertOptions ColumnConvertOptions::Defaults() {
+  auto options = ColumnConvertOptions();
+  // No null spellings: the column is assumed to hold valid values only
+  options.true_values = {"1", "True", "TRUE", "true"};
+  options.false_values = {"0", "False", "FALSE", "false"};
+  return options;
+}
+
 ReadOptions ReadOptions::Defaults() { return ReadOptions(); }
 
 }  // namespace fwfr
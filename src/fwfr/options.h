@@ -26,6 +26,7 @@
 #define FWFR_OPTIONS_H
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -35,10 +36,27 @@
 
 namespace arrow {
     class DataType;
+
+    namespace internal {
+        class ThreadPool;
+    }
 }
 
 namespace fwfr {
 
+struct ARROW_EXPORT RecordLayout {
+  // The layout of one record type, in files mixing several
+
+  // Record type code selecting this layout -- REQUIRED
+  std::string type_code;
+  // Field widths by bytes -- REQUIRED
+  std::vector<uint32_t> field_widths;
+  // Optional column positions for columns to skip. Default read all.
+  std::vector<uint32_t> skip_columns {};
+  // Names of the columns read (not skipped) -- REQUIRED
+  std::vector<std::string> column_names;
+};
+
 struct ARROW_EXPORT ParseOptions {
   // Parsing options  
 
@@ -52,13 +70,92 @@ struct ARROW_EXPORT ParseOptions {
   // Optional column positions for columns to skip. Default read all.
   std::vector<uint32_t> skip_columns {};
 
+  // How records are delimited
+  enum RecordFormat {
+    // Records end with a line separator
+    LINES,
+    // Each record starts with a 4-byte record descriptor word (RECFM=V)
+    RDW,
+    // Blocks of RDW records, each starting with a 4-byte block descriptor
+    // word (RECFM=VB)
+    BDW
+  };
+  // Records with descriptor words hold their data without line separators.
+  // Records shorter than the field widths are padded with spaces.  There is
+  // no header row, so ReadOptions::column_names must be set.
+  RecordFormat record_format = LINES;
+
+  // Optional layouts for files mixing record types, each read into its own
+  // table by TableReader::ReadLayouts (which ignores field_widths and
+  // skip_columns above).  Records must be separated by newlines.
+  std::vector<RecordLayout> layouts;
+  // Byte offset of the record type code within each record
+  uint32_t type_code_offset = 0;
+
   static ParseOptions Defaults();
 };
 
+struct ARROW_EXPORT NumericFormat {
+  // How numeric values are encoded in their fields, as declared by COBOL
+  // USAGE and SIGN clauses.  Values other than TEXT are decoded straight
+  // from their raw bytes, then scaled by implied_decimals.
+
+  enum Encoding {
+    // Text, parsed like any other FWF value
+    TEXT,
+    // Zoned decimal digits (USAGE DISPLAY)
+    ZONED,
+    // Big-endian two's complement binary (USAGE COMP / BINARY)
+    BINARY,
+    // Packed decimal, two digits per byte then a sign nibble (USAGE COMP-3)
+    PACKED
+  };
+
+  enum Sign {
+    // Unsigned (ZONED and BINARY)
+    UNSIGNED,
+    // Sign overpunched on the last digit (ZONED), or signed (BINARY)
+    TRAILING,
+    // Sign overpunched on the first digit (ZONED)
+    LEADING,
+    // Separate '+' or '-' after the digits (ZONED)
+    TRAILING_SEPARATE,
+    // Separate '+' or '-' before the digits (ZONED)
+    LEADING_SEPARATE
+  };
+
+  Encoding encoding = TEXT;
+  Sign sign = TRAILING;
+};
+
+struct ARROW_EXPORT ColumnConvertOptions {
+  // Per-column conversion options, replacing the corresponding ConvertOptions
+  // fields for one column.  Converters only run the checks enabled here, so
+  // e.g. a column without null spellings skips null detection entirely.
+
+  // Whether to treat as COBOL data
+  bool is_cobol = false;
+  // Recognized spellings for null values
+  std::vector<std::string> null_values;
+  // Recognized spellings for boolean values
+  std::vector<std::string> true_values;
+  std::vector<std::string> false_values;
+  // Number of implied decimal places in float / double values
+  int32_t implied_decimals = 0;
+  // Whether string / binary columns can have null values
+  bool strings_can_be_null = false;
+  // Encoding of numeric values
+  NumericFormat numeric_format;
+
+  static ColumnConvertOptions Defaults();
+};
+
 struct ARROW_EXPORT ConvertOptions {
   // Conversion options
 
-  // Optional per-column types (disabling type inference on those columns)
+  // Optional per-column types (disabling type inference on those columns).
+  // A fixed_size_list type splits each field into list_size values of equal
+  // width, decoded in a single strided pass (e.g. COBOL OCCURS fields).
   std::unordered_map<std::string, std::shared_ptr<arrow::DataType>> column_types;
   // Whether to treat as COBOL data
   bool is_cobol = false;
@@ -77,12 +174,65 @@ struct ARROW_EXPORT ConvertOptions {
   // Recognized spellings for boolean values
   std::vector<std::string> true_values;
   std::vector<std::string> false_values;
+  // Number of implied decimal places in float / double values written
+  // without a decimal point (e.g. COBOL 'V' pictures: "12345" is 123.45
+  // with 2 implied decimals).  Values with a decimal point are read as is.
+  int32_t implied_decimals = 0;
   // Whether string / binary columns can have null values.
   // If true, then strings in "null_values" are considered null for string columns.
   // If false, then all strings are valid string values.
   bool strings_can_be_null = false;
+  // Encoding of numeric values.  BINARY and PACKED values cannot be read
+  // with an input encoding, which would mangle their bytes.
+  NumericFormat numeric_format;
+  // Type inference keeps the parsed blocks of a column in case its type must
+  // loosen and they must be reconverted.  Once a column's inferred type has
+  // held for this many blocks, it is locked instead: its blocks are released,
+  // and values not fitting the type are errors (0 to never lock it early).
+  // Text columns are always locked, as any value fits them.
+  int32_t inference_blocks = 0;
+  // Optional directory where the parsed blocks kept for type inference are
+  // spilled, to be read back only when they are reconverted
+  std::string inference_spill_directory;
+  // Whether inferred string / binary columns are large_utf8 / large_binary,
+  // with 64-bit offsets, so that a chunk can hold more than 2 GiB of values
+  // (requires Arrow 0.15 or later).  Declared column types are kept as is.
+  bool large_strings = false;
+  // Optional per-column options, by column name, overriding the fields above
+  std::unordered_map<std::string, ColumnConvertOptions> column_options;
+  // Optional per-column options, by index among the columns read (skipped
+  // columns are not counted).  Entries by name take precedence.
+  std::unordered_map<int32_t, ColumnConvertOptions> column_index_options;
 
   static ConvertOptions Defaults();
+
+  /// Return the options to convert the given column with
+  ConvertOptions ForColumn(const std::string& name, int32_t index) const;
+};
+
+struct ARROW_EXPORT Predicate {
+  // A row filter evaluated on a column's raw field bytes, after whitespace
+  // trimming, before any conversion.  Rows failing it are never converted.
+
+  enum Kind {
+    // Field equals values[0]
+    EQUAL,
+    // Field equals one of values
+    IN,
+    // Field is a number within [min, max]
+    RANGE,
+    // Field starts with values[0]
+    PREFIX
+  };
+
+  // Name of the column to test
+  std::string column;
+  Kind kind = EQUAL;
+  // Spellings to compare against (EQUAL, IN and PREFIX)
+  std::vector<std::string> values;
+  // Inclusive bounds (RANGE)
+  double min = -std::numeric_limits<double>::infinity();
+  double max = std::numeric_limits<double>::infinity();
 };
 
 struct ARROW_EXPORT ReadOptions {
@@ -92,15 +242,65 @@ struct ARROW_EXPORT ReadOptions {
   std::string encoding = "";
   // Whether to use the global CPU thread pool
   bool use_threads = true;
+  // Optional thread pool to use instead of the global one if use_threads
+  // (not owned, must outlive the read)
+  arrow::internal::ThreadPool* thread_pool = nullptr;
+  // Maximum number of blocks read ahead, parsed or converted at once if
+  // use_threads (0 for the thread pool's capacity), to share the pool's
+  // threads between concurrent reads
+  int32_t max_parallelism = 0;
+
+  // Scheduling class of the read's tasks on the thread pool
+  enum Priority {
+    // Run before any other read's tasks (e.g. interactive reads)
+    HIGH,
+    NORMAL,
+    // Only run when no other read has tasks waiting (e.g. batch jobs)
+    LOW
+  };
+  // Reads of the same priority take turns running their tasks
+  Priority priority = NORMAL;
+  // Soft cap on the memory held by a threaded read's blocks and parsers, in
+  // bytes (0 for no cap): once reached, no more blocks are read ahead or
+  // submitted until the read's tasks in flight release some
+  int64_t max_memory_bytes = 0;
+  // Maximum bytes of freed block, readahead and parser buffers kept for
+  // reuse by later blocks of the read (0 to free them at once)
+  int64_t max_recycled_bytes = 64 << 20;  // 64 MB
+
   // Block size we request from the IO layer; also determines the size of
-  // chunks when use_threads is true
-  int32_t block_size = 1 << 20;  // 1 MB
+  // chunks when use_threads is true.  Blocks decoded from an encoding must
+  // be under 2 GiB.
+  int64_t block_size = 1 << 20;  // 1 MB
+  // Whether a threaded read cuts its blocks into chunks sized from the
+  // measured time of its stages, between min_block_size and block_size,
+  // rather than parsing and converting each block whole
+  bool adaptive_block_size = false;
+  // Smallest chunk of an adaptive read, unless the input is smaller than
+  // one such chunk per worker
+  int64_t min_block_size = 64 << 10;  // 64 KB
+  // Minimum number of rows per chunk of the table read, concatenating the
+  // chunks of consecutive blocks once read (0 for one chunk per block)
+  int64_t output_chunk_rows = 0;
+  // Whether to detect and decompress gzip (including BGZF) and zstd input;
+  // BGZF blocks and zstd frames are decompressed in parallel if use_threads
+  bool decompress = true;
 
   // Number of header rows to skip (not including the row of column names, if any)
   int32_t skip_rows = 0;
   // Column names (if empty, will be read from first row after 'skip_rows')
   std::vector<std::string> column_names;
 
+  // Whether to emit each record whole, as a single fixed_size_binary "record"
+  // column sliced from the input blocks without copying, instead of parsing
+  // and converting fields.  Requires fixed-length records.
+  bool raw_records = false;
+  // Optional columns to also parse and convert in raw record mode
+  std::vector<std::string> raw_key_columns;
+
+  // Optional predicates a row must all pass to be read
+  std::vector<Predicate> predicates;
+
   static ReadOptions Defaults();
 };
 
@@ -24,8 +24,15 @@
 
 #include <fwfr/parser.h>
 
+#include <cstring>
+#include <string>
+
+#include <arrow/io/interfaces.h>
+
 namespace fwfr {
 
+constexpr int64_t BlockParser::kMaxValuesBufferBytes;
+
 static arrow::Status ParseError(const char* message) {
   return arrow::Status::Invalid("FWF parse error: ", message);
 }
@@ -38,7 +45,7 @@ static arrow::Status MismatchingColumns(int32_t expected, int32_t actual) {
 
 static inline bool IsControlChar(uint8_t c) { return c < ' '; }
 
-int32_t SkipRows(const uint8_t* data, uint32_t size, int32_t num_rows,
+int32_t SkipRows(const uint8_t* data, int64_t size, int32_t num_rows,
                  const uint8_t** out_data) {
   const auto end = data + size;
   int32_t skipped_rows = 0;
@@ -67,7 +74,7 @@ int32_t SkipRows(const uint8_t* data, uint32_t size, int32_t num_rows,
 // without any further resizes, except at the end.
 class BlockParser::PresizedParsedWriter {
  public:
-  PresizedParsedWriter(arrow::MemoryPool* pool, uint32_t size)
+  PresizedParsedWriter(arrow::MemoryPool* pool, int64_t size)
       : parsed_size_(0), parsed_capacity_(size) {
     ARROW_CHECK_OK(AllocateResizableBuffer(pool, parsed_capacity_, &parsed_buffer_));
     parsed_ = parsed_buffer_->mutable_data();
@@ -113,9 +120,12 @@ class BlockParser::ResizableValuesWriter {
 
   template <typename ParsedWriter>
   void Start(ParsedWriter& parsed_writer) {
-    PushValue({static_cast<uint32_t>(parsed_writer.size()) & 0x7fffffffU});
+    base_ = parsed_writer.size();
+    PushValue({0});
   }
 
+  int64_t base() const { return base_; }
+
   void Finish(std::shared_ptr<arrow::Buffer>* out_values) {
     ARROW_CHECK_OK(values_buffer_->Resize(values_size_ * sizeof(*values_)));
     *out_values = values_buffer_;
@@ -127,7 +137,7 @@ class BlockParser::ResizableValuesWriter {
 
   template <typename ParsedWriter>
   void FinishField(ParsedWriter* parsed_writer) {
-    PushValue({static_cast<uint32_t>(parsed_writer->size()) & 0x7fffffffU});
+    PushValue({static_cast<uint32_t>(parsed_writer->size() - base_)});
   }
 
   // Rollback the state that was saved in BeginLine()
@@ -145,6 +155,8 @@ class BlockParser::ResizableValuesWriter {
 
   std::shared_ptr<arrow::ResizableBuffer> values_buffer_;
   ValueDesc* values_;
+  // Offset in the parsed data of the first value
+  int64_t base_ = 0;
   int64_t values_size_;
   int64_t values_capacity_;
   // Checkpointing, for when an incomplete line is encountered at end of block
@@ -158,7 +170,7 @@ class BlockParser::ResizableValuesWriter {
 class BlockParser::PresizedValuesWriter {
  public:
   PresizedValuesWriter(arrow::MemoryPool* pool, int32_t num_rows, int32_t num_cols)
-      : values_size_(0), values_capacity_(1 + num_rows * num_cols) {
+      : values_size_(0), values_capacity_(1 + static_cast<int64_t>(num_rows) * num_cols) {
     ARROW_CHECK_OK(AllocateResizableBuffer(pool, values_capacity_ * sizeof(*values_),
                                            &values_buffer_));
     values_ = reinterpret_cast<ValueDesc*>(values_buffer_->mutable_data());
@@ -166,9 +178,12 @@ class BlockParser::PresizedValuesWriter {
 
   template <typename ParsedWriter>
   void Start(ParsedWriter& parsed_writer) {
-    PushValue({static_cast<uint32_t>(parsed_writer.size()) & 0x7fffffffU});
+    base_ = parsed_writer.size();
+    PushValue({0});
   }
 
+  int64_t base() const { return base_; }
+
   void Finish(std::shared_ptr<arrow::Buffer>* out_values) {
     ARROW_CHECK_OK(values_buffer_->Resize(values_size_ * sizeof(*values_)));
     *out_values = values_buffer_;
@@ -180,7 +195,7 @@ class BlockParser::PresizedValuesWriter {
 
   template <typename ParsedWriter>
   void FinishField(ParsedWriter* parsed_writer) {
-    PushValue({static_cast<uint32_t>(parsed_writer->size()) & 0x7fffffffU});
+    PushValue({static_cast<uint32_t>(parsed_writer->size() - base_)});
   }
 
   // Rollback the state that was saved in BeginLine()
@@ -194,6 +209,8 @@ class BlockParser::PresizedValuesWriter {
 
   std::shared_ptr<arrow::ResizableBuffer> values_buffer_;
   ValueDesc* values_;
+  // Offset in the parsed data of the first value
+  int64_t base_ = 0;
   int64_t values_size_;
   const int64_t values_capacity_;
   // Checkpointing, for when an incomplete line is encountered at end of block
@@ -363,19 +380,23 @@ arrow::Status BlockParser::ParseChunk(ValuesWriter* values_writer,
   std::shared_ptr<arrow::Buffer> values_buffer;
   values_writer->Finish(&values_buffer);
   if (values_buffer->size() > 0) {
-    values_size_ += static_cast<int32_t>(values_buffer->size() / sizeof(ValueDesc) - 1);
+    values_size_ += static_cast<int64_t>(values_buffer->size() / sizeof(ValueDesc) - 1);
     values_buffers_.push_back(std::move(values_buffer));
+    values_bases_.push_back(values_writer->base());
   }
   *out_data = data;
   return arrow::Status::OK();
 }
 
-arrow::Status BlockParser::DoParse(const char* start, uint32_t size, bool is_final,
-                            uint32_t* out_size) {
+arrow::Status BlockParser::DoParse(const char* start, int64_t size, bool is_final,
+                            int64_t* out_size) {
   num_rows_ = 0;
   values_size_ = 0;
   parsed_size_ = 0;
+  has_selection_ = false;
+  selection_.clear();
   values_buffers_.clear();
+  values_bases_.clear();
   parsed_buffer_.reset();
   parsed_ = nullptr;
 
@@ -383,6 +404,11 @@ arrow::Status BlockParser::DoParse(const char* start, uint32_t size, bool is_fin
   const char* data_end = start + size;
   bool finished_parsing = false;
 
+  if (ARROW_PREDICT_FALSE(row_width_ > kMaxValuesBufferBytes)) {
+    return arrow::Status::Invalid("Rows of ", row_width_, " bytes exceed the maximum of ",
+                                  kMaxValuesBufferBytes);
+  }
+
   PresizedParsedWriter parsed_writer(pool_, size);
 
   if (num_cols_ == -1) {
@@ -404,12 +430,17 @@ arrow::Status BlockParser::DoParse(const char* start, uint32_t size, bool is_fin
     // a given number of rows
     DCHECK_GE(num_cols_, 0);
 
-    int32_t rows_in_chunk;
-    if (num_cols_ > 0) {
-      rows_in_chunk = std::min(32768 / num_cols_, max_num_rows_ - num_rows_);
-    } else {
-      rows_in_chunk = std::min(32768, max_num_rows_ - num_rows_);
+    // Size the values for the rows left in the block, as rows take about
+    // the record width: a cap on the number of values would cut the block
+    // of a wide file into many chunks of a few rows.  A short estimate (e.g.
+    // rows missing trailing fields) just takes another chunk.
+    int64_t rows_left = (data_end - data) / std::max<int64_t>(record_width_, 1) + 1;
+    rows_left = std::min<int64_t>(rows_left, max_num_rows_ - num_rows_);
+    // Keep the chunk's parsed data within reach of its value offsets
+    if (row_width_ > 0) {
+      rows_left = std::min(rows_left, kMaxValuesBufferBytes / row_width_);
     }
+    const int32_t rows_in_chunk = static_cast<int32_t>(rows_left);
 
     PresizedValuesWriter values_writer(pool_, rows_in_chunk, num_cols_);
     values_writer.Start(parsed_writer);
@@ -420,7 +451,7 @@ arrow::Status BlockParser::DoParse(const char* start, uint32_t size, bool is_fin
   }
 
   parsed_writer.Finish(&parsed_buffer_);
-  parsed_size_ = static_cast<int32_t>(parsed_buffer_->size());
+  parsed_size_ = parsed_buffer_->size();
   parsed_ = parsed_buffer_->data();
 
   DCHECK_EQ(values_size_, num_rows_ * num_cols_);
@@ -434,30 +465,144 @@ arrow::Status BlockParser::DoParse(const char* start, uint32_t size, bool is_fin
     auto last_values = reinterpret_cast<const ValueDesc*>(last_values_buffer->data());
     auto last_values_size = last_values_buffer->size() / sizeof(ValueDesc);
     auto check_parsed_size =
-        static_cast<int32_t>(last_values[last_values_size - 1].offset);
+        values_bases_.back() + last_values[last_values_size - 1].offset;
     DCHECK_EQ(parsed_size_, check_parsed_size);
   } else {
     DCHECK_EQ(parsed_size_, 0);
   }
 #endif
-  *out_size = static_cast<uint32_t>(data - start);
+  *out_size = static_cast<int64_t>(data - start);
   return arrow::Status::OK();
 }
 
-arrow::Status BlockParser::Parse(const char* data, uint32_t size, uint32_t* out_size) {
+arrow::Status BlockParser::Parse(const char* data, int64_t size, int64_t* out_size) {
   return DoParse(data, size, false /* is_final */, out_size);
 }
 
-arrow::Status BlockParser::ParseFinal(const char* data, uint32_t size, 
-                                      uint32_t* out_size) {
+arrow::Status BlockParser::ParseFinal(const char* data, int64_t size, 
+                                      int64_t* out_size) {
   return DoParse(data, size, true /* is_final */, out_size);
 }
 
+void BlockParser::SelectRows(const std::vector<uint8_t>& keep) {
+  DCHECK_EQ(static_cast<int32_t>(keep.size()), num_rows());
+  std::vector<int32_t> selection;
+  for (size_t i = 0; i < keep.size(); ++i) {
+    if (keep[i]) {
+      selection.push_back(has_selection_ ? selection_[i] : static_cast<int32_t>(i));
+    }
+  }
+  selection_ = std::move(selection);
+  has_selection_ = true;
+}
+
 BlockParser::BlockParser(arrow::MemoryPool* pool, ParseOptions options, int32_t num_cols,
                          int32_t max_num_rows)
-    : pool_(pool), options_(options), num_cols_(num_cols), max_num_rows_(max_num_rows) {}
+    : pool_(pool), options_(options), num_cols_(num_cols), max_num_rows_(max_num_rows) {
+  for (uint32_t i = 0; i < options_.field_widths.size(); ++i) {
+    if (std::find(options_.skip_columns.begin(), options_.skip_columns.end(), i) ==
+        options_.skip_columns.end()) {
+      column_widths_.push_back(options_.field_widths[i]);
+      row_width_ += options_.field_widths[i];
+    }
+    record_width_ += options_.field_widths[i];
+  }
+}
 
 BlockParser::BlockParser(ParseOptions options, int32_t num_cols, int32_t max_num_rows)
     : BlockParser(arrow::default_memory_pool(), options, num_cols, max_num_rows) {}
 
+arrow::Status BlockParser::WriteColumn(int32_t col_index, arrow::io::OutputStream* out,
+                                       int64_t* out_size) const {
+  // The number of segments and the number of values of each, their
+  // offsets, then their bytes.  Like a values buffer, a segment holds at
+  // most kMaxValuesBufferBytes of bytes, its offsets being relative to them.
+  std::vector<int32_t> segment_sizes;
+  std::vector<ValueDesc> values;
+  std::string parsed;
+  int64_t segment_base = 0;
+  auto start_segment = [&]() {
+    segment_base = static_cast<int64_t>(parsed.size());
+    segment_sizes.push_back(0);
+    values.push_back({0});
+  };
+  start_segment();
+  RETURN_NOT_OK(VisitColumn(col_index, [&](const uint8_t* data, uint32_t size) {
+    if (static_cast<int64_t>(parsed.size()) + size - segment_base >
+        kMaxValuesBufferBytes) {
+      start_segment();
+    }
+    parsed.append(reinterpret_cast<const char*>(data), size);
+    values.push_back({static_cast<uint32_t>(parsed.size() - segment_base)});
+    ++segment_sizes.back();
+    return arrow::Status::OK();
+  }));
+  const int32_t num_segments = static_cast<int32_t>(segment_sizes.size());
+  RETURN_NOT_OK(out->Write(&num_segments, sizeof(num_segments)));
+  RETURN_NOT_OK(out->Write(segment_sizes.data(), num_segments * sizeof(int32_t)));
+  RETURN_NOT_OK(out->Write(values.data(), values.size() * sizeof(ValueDesc)));
+  RETURN_NOT_OK(out->Write(parsed.data(), parsed.size()));
+  *out_size = sizeof(num_segments) + num_segments * sizeof(int32_t) +
+              values.size() * sizeof(ValueDesc) + parsed.size();
+  return arrow::Status::OK();
+}
+
+arrow::Status BlockParser::ReadColumn(arrow::MemoryPool* pool, uint32_t column_width,
+                                      arrow::io::RandomAccessFile* file,
+                                      int64_t position, int64_t size,
+                                      std::shared_ptr<BlockParser>* out) {
+  auto Truncated = [position]() {
+    return arrow::Status::IOError("Truncated parsed column at position ", position);
+  };
+  std::shared_ptr<arrow::Buffer> buffer;
+  RETURN_NOT_OK(file->ReadAt(position, size, &buffer));
+  int32_t num_segments = 0;
+  if (buffer->size() != size || size < static_cast<int64_t>(sizeof(num_segments))) {
+    return Truncated();
+  }
+  std::memcpy(&num_segments, buffer->data(), sizeof(num_segments));
+  int64_t header_size = sizeof(num_segments) +
+                        static_cast<int64_t>(num_segments) * sizeof(int32_t);
+  if (num_segments < 0 || size < header_size) {
+    return Truncated();
+  }
+  std::vector<int32_t> segment_sizes(num_segments);
+  std::memcpy(segment_sizes.data(), buffer->data() + sizeof(num_segments),
+              num_segments * sizeof(int32_t));
+
+  ParseOptions options = ParseOptions::Defaults();
+  options.field_widths = {column_width};
+  int64_t num_values = 0;
+  for (int32_t segment_size : segment_sizes) {
+    num_values += segment_size;
+  }
+  auto parser = std::make_shared<BlockParser>(pool, options, 1,
+                                              static_cast<int32_t>(num_values));
+  // Slice the offsets of each segment, adding up their bytes
+  int64_t offset = header_size;
+  int64_t base = 0;
+  for (int32_t segment_size : segment_sizes) {
+    const int64_t values_size =
+        (static_cast<int64_t>(segment_size) + 1) * sizeof(ValueDesc);
+    if (segment_size < 0 || size < offset + values_size) {
+      return Truncated();
+    }
+    auto values_buffer = arrow::SliceBuffer(buffer, offset, values_size);
+    parser->values_bases_.push_back(base);
+    base += reinterpret_cast<const ValueDesc*>(values_buffer->data())[segment_size].offset;
+    parser->values_buffers_.push_back(std::move(values_buffer));
+    offset += values_size;
+  }
+  if (size - offset != base) {
+    return Truncated();
+  }
+  parser->parsed_buffer_ = arrow::SliceBuffer(buffer, offset, size - offset);
+  parser->parsed_ = parser->parsed_buffer_->data();
+  parser->num_rows_ = static_cast<int32_t>(num_values);
+  parser->values_size_ = num_values;
+  parser->parsed_size_ = parser->parsed_buffer_->size();
+  *out = parser;
+  return arrow::Status::OK();
+}
+
 }  // namespace fwfr
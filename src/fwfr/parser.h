@@ -44,6 +44,11 @@
 
 namespace arrow {
     class MemoryPool;
+
+    namespace io {
+        class OutputStream;
+        class RandomAccessFile;
+    }
 }
 
 namespace fwfr {
@@ -53,7 +58,7 @@ constexpr int32_t kMaxParserNumRows = 100000;
 /// Skip at most num_rows from the given input. The input pointer is updated
 /// and the number of actually skipped rows is returned (may be less than
 /// requested if the input is too short).
-ARROW_EXPORT int32_t SkipRows(const uint8_t* data, uint32_t size, int32_t num_rows,
+ARROW_EXPORT int32_t SkipRows(const uint8_t* data, int64_t size, int32_t num_rows,
                               const uint8_t** out_data);
 
 /// \class BlockParser
@@ -80,20 +85,44 @@ class ARROW_EXPORT BlockParser {
   ///
   /// Parse a block of FWF data, ingesting up to max_num_rows rows.
   /// The number of bytes actually parsed is returned in out_size.
-  arrow::Status Parse(const char* data, uint32_t size, uint32_t* out_size);
+  arrow::Status Parse(const char* data, int64_t size, int64_t* out_size);
 
   /// \brief Parse the final block of data
   ///
   /// Like Parse(), but called with the final block in a file.
   /// The last row may lack a trailing line separator.
-  arrow::Status ParseFinal(const char* data, uint32_t size, uint32_t* out_size);
+  arrow::Status ParseFinal(const char* data, int64_t size, int64_t* out_size);
 
-  /// \brief Return the number of parsed rows
-  int32_t num_rows() const { return num_rows_; }
+  /// \brief Return the number of parsed (and selected) rows
+  int32_t num_rows() const {
+    return has_selection_ ? static_cast<int32_t>(selection_.size()) : num_rows_;
+  }
   /// \brief Return the number of parsed columns
   int32_t num_cols() const { return num_cols_; }
   /// \brief Return the total size in bytes of parsed data
-  uint32_t num_bytes() const { return parsed_size_; }
+  int64_t num_bytes() const { return parsed_size_; }
+  /// \brief Return the width in bytes of a parsed column's values
+  uint32_t column_width(int32_t col_index) const { return column_widths_[col_index]; }
+
+  /// \brief Write the parsed (and selected) values of a column to a stream
+  ///
+  /// The values are laid out as the parser holds them, so ReadColumn() can
+  /// read them back as is.  The number of bytes written is returned in
+  /// out_size.
+  arrow::Status WriteColumn(int32_t col_index, arrow::io::OutputStream* out,
+                            int64_t* out_size) const;
+
+  /// \brief Read back the values written by WriteColumn() at a position
+  /// of a file, as the only column of a new parser
+  static arrow::Status ReadColumn(arrow::MemoryPool* pool, uint32_t column_width,
+                                  arrow::io::RandomAccessFile* file, int64_t position,
+                                  int64_t size, std::shared_ptr<BlockParser>* out);
+
+  /// \brief Narrow the selected rows to those whose flag is set
+  ///
+  /// keep holds one flag per currently selected row.  Afterwards
+  /// num_rows() and VisitColumn() only account for the selected rows.
+  void SelectRows(const std::vector<uint8_t>& keep);
 
   /// \brief Visit parsed values in a column
   ///
@@ -101,15 +130,19 @@ class ARROW_EXPORT BlockParser {
   /// Status(const uint8_t* data, uint32_t size)
   template <typename Visitor>
   arrow::Status VisitColumn(int32_t col_index, Visitor&& visit) const {
+    if (ARROW_PREDICT_FALSE(has_selection_)) {
+      return VisitSelectedRows(col_index, std::forward<Visitor>(visit));
+    }
     for (size_t buf_index = 0; buf_index < values_buffers_.size(); ++buf_index) {
       const auto& values_buffer = values_buffers_[buf_index];
       const auto values = reinterpret_cast<const ValueDesc*>(values_buffer->data());
+      const uint8_t* parsed = parsed_ + values_bases_[buf_index];
       const auto max_pos =
           static_cast<int32_t>(values_buffer->size() / sizeof(ValueDesc)) - 1;
       for (int32_t pos = col_index; pos < max_pos; pos += num_cols_) {
         auto start = values[pos].offset;
         auto stop = values[pos + 1].offset;
-        ARROW_RETURN_NOT_OK(visit(parsed_ + start, stop - start));
+        ARROW_RETURN_NOT_OK(visit(parsed + start, stop - start));
       }
     }
     return arrow::Status::OK();
@@ -119,12 +152,13 @@ class ARROW_EXPORT BlockParser {
   arrow::Status VisitLastRow(Visitor&& visit) const {
     const auto& values_buffer = values_buffers_.back();
     const auto values = reinterpret_cast<const ValueDesc*>(values_buffer->data());
+    const uint8_t* parsed = parsed_ + values_bases_.back();
     const auto start_pos = 
         static_cast<int32_t>(values_buffer->size() / sizeof(ValueDesc)) - num_cols_ - 1;
     for (int32_t col_index = 0; col_index < num_cols_; ++col_index) {
       auto start = values[start_pos + col_index].offset;
       auto stop = values[start_pos + col_index + 1].offset;
-      ARROW_RETURN_NOT_OK(visit(parsed_ + start, stop - start));
+      ARROW_RETURN_NOT_OK(visit(parsed + start, stop - start));
     }
     return arrow::Status::OK();
   }
@@ -132,8 +166,33 @@ class ARROW_EXPORT BlockParser {
  protected:
   ARROW_DISALLOW_COPY_AND_ASSIGN(BlockParser);
 
-  arrow::Status DoParse(const char* data, uint32_t size, 
-                        bool is_final, uint32_t* out_size);
+  template <typename Visitor>
+  arrow::Status VisitSelectedRows(int32_t col_index, Visitor&& visit) const {
+    // Rows are sorted, so walk the values buffers alongside them
+    size_t buf_index = 0;
+    int32_t buf_first_row = 0;
+    int32_t buf_num_rows = 0;
+    const ValueDesc* values = nullptr;
+    const uint8_t* parsed = nullptr;
+    for (int32_t row : selection_) {
+      while (row >= buf_first_row + buf_num_rows) {
+        parsed = parsed_ + values_bases_[buf_index];
+        const auto& values_buffer = values_buffers_[buf_index++];
+        values = reinterpret_cast<const ValueDesc*>(values_buffer->data());
+        buf_first_row += buf_num_rows;
+        buf_num_rows = static_cast<int32_t>(
+            (values_buffer->size() / sizeof(ValueDesc) - 1) / num_cols_);
+      }
+      const int32_t pos = (row - buf_first_row) * num_cols_ + col_index;
+      auto start = values[pos].offset;
+      auto stop = values[pos + 1].offset;
+      ARROW_RETURN_NOT_OK(visit(parsed + start, stop - start));
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status DoParse(const char* data, int64_t size, 
+                        bool is_final, int64_t* out_size);
   
   template <typename ValuesWriter, typename ParsedWriter>
   arrow::Status ParseChunk(ValuesWriter* values_writer, ParsedWriter* parsed_writer,
@@ -155,17 +214,31 @@ class ARROW_EXPORT BlockParser {
   int32_t num_cols_;
   // The maximum number of rows to parse from this block
   int32_t max_num_rows_;
-
-  // Linear scratchpad for parsed values
+  // Field widths of the parsed (not skipped) columns
+  std::vector<uint32_t> column_widths_;
+  // The most parsed bytes a row can hold, i.e. the sum of column_widths_
+  int64_t row_width_ = 0;
+  // The bytes of a row in the input, skipped columns included
+  int64_t record_width_ = 0;
+  // Indices of the selected rows, if narrowed by SelectRows()
+  bool has_selection_ = false;
+  std::vector<int32_t> selection_;
+
+  // Linear scratchpad for parsed values.  Value offsets are relative to
+  // the parsed data of their values buffer, which starts at its entry of
+  // values_bases_: the parsed data of a block may exceed 4 GiB, as long as
+  // each values buffer covers at most kMaxValuesBufferBytes of it.
   struct ValueDesc {
-    uint32_t offset : 31;
+    uint32_t offset;
   };
+  static constexpr int64_t kMaxValuesBufferBytes = UINT32_MAX;
 
   std::vector<std::shared_ptr<arrow::Buffer>> values_buffers_;
+  std::vector<int64_t> values_bases_;
   std::shared_ptr<arrow::Buffer> parsed_buffer_;
   const uint8_t* parsed_;
-  int32_t values_size_;
-  int32_t parsed_size_;
+  int64_t values_size_;
+  int64_t parsed_size_;
 
   class ResizableValuesWriter;
   class PresizedValuesWriter;
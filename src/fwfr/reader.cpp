@@ -24,6 +24,8 @@
 
 #include <fwfr/reader.h>
 
+#include <fwfr/whitespace.h>
+
 namespace arrow {
     class MemoryPool;
 
@@ -42,13 +44,6 @@ using arrow::io::internal::ReadaheadSpooler;
 static constexpr int64_t kDefaultLeftPadding = 2048;  // 2 kB
 static constexpr int64_t kDefaultRightPadding = 16;
 
-inline bool IsWhitespace(uint8_t c) {
-  if (ARROW_PREDICT_TRUE(c > ' ')) {
-    return false;
-  }
-  return c == ' ' || c == '\t';
-}
-
 arrow::Status SkipUTF8BOM(const uint8_t* data, int64_t size, const uint8_t** out) {
     int64_t i;
     const uint8_t kBOM[] = { 0xEF, 0xBB, 0xBF };
@@ -75,21 +70,260 @@ arrow::Status SkipUTF8BOM(const uint8_t* data, int64_t size, const uint8_t** out
     return arrow::Status::OK();
 }
 
+/////////////////////////////////////////////////////////////////////////
+// Record batches of a streaming read
+class BatchStream : public arrow::RecordBatchReader {
+ public:
+  using NextBatch = std::function<arrow::Status(std::shared_ptr<arrow::RecordBatch>*)>;
+
+  BatchStream(std::shared_ptr<arrow::Schema> schema, NextBatch next_batch)
+      : schema_(std::move(schema)), next_batch_(std::move(next_batch)) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* out) override {
+    return next_batch_(out);
+  }
+
+ private:
+  std::shared_ptr<arrow::Schema> schema_;
+  NextBatch next_batch_;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// The pools of a read: a buffer pool unless max_recycled_bytes is 0, a
+// memory budget over it for threaded reads with max_memory_bytes, and a
+// pool counting the memory of each stage.  The input blocks and parsers go
+// through the budget, the converted arrays and other buffers of the table
+// straight to the caller's pool, as they outlive the read.
+struct ReadPools {
+  std::shared_ptr<BufferPool> buffer_pool;
+  std::shared_ptr<MemoryBudget> budget;
+  std::shared_ptr<StagePool> readahead;
+  std::shared_ptr<StagePool> parse;
+  std::shared_ptr<StagePool> convert;
+  std::shared_ptr<StagePool> output;
+};
+
+static ReadMemoryStats GetMemoryStats(const ReadPools& pools) {
+  auto stage_stats = [](const CountingPool* pool) {
+    StageMemoryStats stats;
+    if (pool) {
+      stats.bytes_allocated = pool->bytes_allocated();
+      stats.max_memory = pool->max_memory();
+    }
+    return stats;
+  };
+  ReadMemoryStats stats;
+  stats.readahead = stage_stats(pools.readahead.get());
+  stats.parse = stage_stats(pools.parse.get());
+  stats.convert = stage_stats(pools.convert.get());
+  stats.output = stage_stats(pools.output.get());
+  stats.budget = stage_stats(pools.budget.get());
+  if (pools.buffer_pool) {
+    stats.recycled.bytes_allocated = pools.buffer_pool->pooled_bytes();
+    stats.recycled.max_memory = pools.buffer_pool->peak_pooled_bytes();
+    stats.reused_bytes = pools.buffer_pool->reused_bytes();
+  }
+  return stats;
+}
+
 /////////////////////////////////////////////////////////////////////////
 // Base class for common functionality
-class BaseTableReader : public fwfr::TableReader {
+class BaseTableReader : public fwfr::TableReader,
+                        public std::enable_shared_from_this<BaseTableReader> {
  public:
-  BaseTableReader(arrow::MemoryPool* pool, const ReadOptions& read_options,
+  BaseTableReader(const ReadPools& pools,
+                  const ReadOptions& read_options,
                   const ParseOptions& parse_options,
                   const ConvertOptions& convert_options)
-      : pool_(pool),
+      : pools_(pools),
+        readahead_pool_(pools.readahead.get()),
+        parse_pool_(pools.parse.get()),
+        convert_pool_(pools.convert.get()),
+        output_pool_(pools.output.get()),
+        budget_(pools.budget),
         read_options_(read_options),
         parse_options_(parse_options),
         convert_options_(convert_options) {}
 
+  ~BaseTableReader() {
+    // Streamed blocks being converted use the reader's members
+    for (auto& batch : stream_batches_) {
+      batch.wait();
+    }
+  }
+
+  arrow::Status Read(std::shared_ptr<arrow::Table>* out) override {
+    RETURN_NOT_OK(ReadHeader());
+    if (read_options_.raw_records) {
+      return ReadRaw(out);
+    }
+    RETURN_NOT_OK(IsFramed() ? ReadRecords() : ReadBlocks());
+    return MakeTable(out);
+  }
+
+  arrow::Status ReadLazy(std::shared_ptr<LazyTable>* out) override {
+    if (read_options_.raw_records) {
+      return arrow::Status::NotImplemented("Lazy reads of raw records");
+    }
+    lazy_ = true;
+    RETURN_NOT_OK(ReadHeader());
+    RETURN_NOT_OK(IsFramed() ? ReadRecords() : ReadBlocks());
+    *out = std::make_shared<LazyTable>(pools_.convert, pools_.output, thread_pool_,
+                                       parallelism_, read_options_.priority,
+                                       read_options_.output_chunk_rows, column_names_,
+                                       convert_options_, std::move(lazy_parsers_));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ReadStream(std::shared_ptr<arrow::RecordBatchReader>* out) override {
+    if (read_options_.raw_records || IsFramed()) {
+      return arrow::Status::NotImplemented(
+          "Streaming raw records or records with descriptor words");
+    }
+    streaming_ = true;
+    RETURN_NOT_OK(ReadHeader());
+    RETURN_NOT_OK(MakeStreamConverters());
+    // Keep every worker allowed busy, and no more
+    stream_max_batches_ = parallelism_;
+    stream_chunker_ = std::make_shared<Chunker>(parse_options_);
+
+    auto self = shared_from_this();
+    *out = std::make_shared<BatchStream>(
+        stream_schema_, [self](std::shared_ptr<arrow::RecordBatch>* batch) {
+          return self->ReadNextBatch(batch);
+        });
+    return arrow::Status::OK();
+  }
+
+  ReadMemoryStats memory_stats() const override { return GetMemoryStats(pools_); }
+
+  arrow::Status ReadLayouts(
+      std::unordered_map<std::string, std::shared_ptr<arrow::Table>>* out) override {
+    if (parse_options_.layouts.empty()) {
+      return arrow::Status::Invalid("No record layouts in parse options");
+    }
+    if (parse_options_.newlines_in_values || read_options_.raw_records ||
+        !read_options_.predicates.empty() || IsFramed()) {
+      return arrow::Status::NotImplemented(
+          "Record layouts with newlines in values, raw records, predicates or "
+          "descriptor words");
+    }
+    RETURN_NOT_OK(StartRead());
+    RETURN_NOT_OK(ProcessSkipRows());
+    RETURN_NOT_OK(MakeLayoutBuilders());
+
+    // Chunk on line boundaries as usual, each chunk task dispatches its lines
+    Chunker chunker(parse_options_);
+    while (task_group_->ok()) {
+      int64_t chunk_size = 0;
+      if (!eof_) {
+        RETURN_NOT_OK(chunker.Process(reinterpret_cast<const char*>(cur_data_),
+                                      cur_size_, &chunk_size));
+      } else {
+        // Remaining data, the last line may lack a line separator
+        chunk_size = cur_size_;
+      }
+      if (chunk_size > 0) {
+        const uint8_t* chunk_data = cur_data_;
+        std::shared_ptr<arrow::Buffer> chunk_buffer = cur_block_;
+        int64_t chunk_index = cur_block_index_++;
+
+        WaitForMemory();
+        // "mutable" allows to modify captured by-copy chunk_buffer
+        task_group_->Append([=]() mutable -> arrow::Status {
+          RETURN_NOT_OK(ProcessLayoutChunk(reinterpret_cast<const char*>(chunk_data),
+                                           chunk_size, chunk_index));
+          // Keep chunk buffer alive within closure and release it at the end
+          chunk_buffer.reset();
+          return arrow::Status::OK();
+        });
+        cur_data_ += chunk_size;
+        cur_size_ -= chunk_size;
+      } else if (!eof_) {
+        // Need to fetch more data to get at least one line
+        RETURN_NOT_OK(ReadNextBlock());
+      } else {
+        break;
+      }
+    }
+    RETURN_NOT_OK(task_group_->Finish());
+
+    // Clean up ICU
+    ucnv_close(ucnv_);
+    u_cleanup();
+
+    return MakeLayoutTables(out);
+  }
+
+  // Read the input as one file of a dataset.  Its blocks are converted by
+  // the dataset's task group and column builders (made by the first file),
+  // from block index *block_index on, and the task group is left running so
+  // that the next file is chunked while this one's last blocks convert.
+  arrow::Status ReadDatasetFile(
+      const std::shared_ptr<arrow::internal::TaskGroup>& task_group,
+      std::vector<std::string>* column_names,
+      std::vector<std::shared_ptr<ColumnBuilder>>* column_builders,
+      int64_t* block_index) {
+    if (read_options_.raw_records || IsFramed()) {
+      return arrow::Status::NotImplemented(
+          "Datasets of raw records or records with descriptor words");
+    }
+    dataset_ = true;
+    // The shared task group is not timed: read whole blocks
+    block_sizer_.reset();
+    task_group_ = task_group;
+    column_builders_ = *column_builders;
+    cur_block_index_ = *block_index;
+    RETURN_NOT_OK(ReadHeader());
+    if (column_names->empty()) {
+      *column_names = column_names_;
+      *column_builders = column_builders_;
+    } else if (column_names_ != *column_names) {
+      return arrow::Status::Invalid("Column names differ from the first file's");
+    }
+    RETURN_NOT_OK(ReadBlocks());
+    *block_index = cur_block_index_;
+    return arrow::Status::OK();
+  }
+
  protected:
+  // Parse and convert (or retain, if lazy) all blocks after the header
+  virtual arrow::Status ReadBlocks() = 0;
+
+  // Create the task group and read the first block
+  arrow::Status StartRead() {
+    if (dataset_) {
+      // The dataset's task group is shared by all its files
+    } else {
+      task_group_ = MakeTaskGroup(thread_pool_, parallelism_, read_options_.priority);
+      if (budget_) {
+        task_group_ = budget_->WrapTaskGroup(task_group_);
+      }
+      if (block_sizer_) {
+        task_group_ = block_sizer_->WrapTaskGroup(task_group_);
+      }
+    }
+    RETURN_NOT_OK(ReadFirstBlock());
+    if (eof_) {
+      return arrow::Status::Invalid("Empty FWF file");
+    }
+    return arrow::Status::OK();
+  }
+
+  // Read the first block and process the header
+  arrow::Status ReadHeader() {
+    RETURN_NOT_OK(StartRead());
+    return ProcessHeader();
+  }
+
   arrow::Status ReadFirstBlock() {
     RETURN_NOT_OK(ReadNextBlock());
+    if (IsFramed()) {
+      // Binary descriptor words come first
+      return arrow::Status::OK();
+    }
     const uint8_t* data;
     
     RETURN_NOT_OK(SkipUTF8BOM(cur_data_, cur_size_, &data));
@@ -122,13 +356,23 @@ class BaseTableReader : public fwfr::TableReader {
     uint8_t* new_data = rh.buffer->mutable_data() + rh.left_padding;
     int64_t new_size = rh.buffer->size() - rh.left_padding - rh.right_padding;
     DCHECK_GT(new_size, 0);  // ensured by ReadaheadSpooler
+    input_read_ += new_size;
 
     // Convert input data's encoding to UTF8 if read_options_.encoding is set
     // Notes:
     //   * for accepted codesets: https://demo.icu-project.org/icu-bin/convexp
     //   * EBCDIC encodings need ",lfnl" appended to codeset name ("cp1047,lfnl")
     //     to properly handle newlines 
-    if (read_options_.encoding != "") {
+    //   * records with descriptor words are converted one by one, by
+    //     ProcessRecordChunk()
+    if (read_options_.encoding != "" && !IsFramed()) {
+      if (new_size > std::numeric_limits<int32_t>::max()) {
+        // ICU takes 32-bit lengths, and can't resume a multi-byte character
+        // cut between two calls
+        return arrow::Status::Invalid("Blocks of ", new_size, " bytes are too large ",
+                                      "to decode, block_size must be under 2 GiB ",
+                                      "with an encoding");
+      }
       int64_t encoded_size = new_size;
       new_size = ucnv_toAlgorithmic(UCNV_UTF8, ucnv_,
                                     reinterpret_cast<char*>(new_data), 
@@ -145,8 +389,12 @@ class BaseTableReader : public fwfr::TableReader {
       }
     }
 
-    if (trailing_cr_ && new_data[0] == '\n') {
+    if (trailing_cr_ && new_data[0] == '\n' && !read_options_.raw_records &&
+        !parse_options_.newlines_in_values && !IsFramed()) {
       // Skip '\r\n' line separator that started at the end of previous block
+      // (raw records keep their '\r' in the trailing data, and need the '\n',
+      // as do records read back to back by their width, whose bytes may be
+      // binary data)
       ++new_data;
       --new_size;
     }
@@ -162,7 +410,8 @@ class BaseTableReader : public fwfr::TableReader {
       } else {
         // Need to allocate bigger block and concatenate trailing + present data
         RETURN_NOT_OK(
-            AllocateBuffer(pool_, cur_size_ + new_size + rh.right_padding, &new_block));
+            AllocateBuffer(readahead_pool_, cur_size_ + new_size + rh.right_padding,
+                           &new_block));
         std::memcpy(new_block->mutable_data(), cur_data_, cur_size_);
         std::memcpy(new_block->mutable_data() + cur_size_, new_data, new_size);
         std::memset(new_block->mutable_data() + cur_size_ + new_size, 0,
@@ -177,14 +426,11 @@ class BaseTableReader : public fwfr::TableReader {
     return arrow::Status::OK();
   }
 
-  // Read header and column names from current block, create column builders
-  arrow::Status ProcessHeader() {
-    DCHECK_GT(cur_size_, 0);
-    
+  // Skip initial rows (potentially invalid FWF data)
+  arrow::Status ProcessSkipRows() {
     if (read_options_.skip_rows) {
-        // Skip initial rows (potentially invalid FWF data)
         auto data = cur_data_;
-        auto num_skipped_rows = SkipRows(cur_data_, static_cast<uint32_t>(cur_size_),
+        auto num_skipped_rows = SkipRows(cur_data_, cur_size_,
                                          read_options_.skip_rows, &data);
         cur_size_ -= data - cur_data_;
             cur_data_ = data;
@@ -195,13 +441,30 @@ class BaseTableReader : public fwfr::TableReader {
                         "either file is too short or header is larger than block size");
             }
     }
+    return arrow::Status::OK();
+  }
+
+  // Read header and column names from current block, create column builders
+  arrow::Status ProcessHeader() {
+    DCHECK_GT(cur_size_, 0);
+    if (IsFramed()) {
+      if (read_options_.column_names.empty()) {
+        return arrow::Status::Invalid("Records with descriptor words have no header "
+                                      "row, column names must be given");
+      }
+      if (read_options_.skip_rows > 0 || read_options_.raw_records) {
+        return arrow::Status::NotImplemented(
+            "Skipping rows or raw records with descriptor words");
+      }
+    }
+    RETURN_NOT_OK(ProcessSkipRows());
 
     if (read_options_.column_names.empty()) {
         // Read one row with column names
-        BlockParser parser(pool_, parse_options_, num_cols_, 1);
-        uint32_t parsed_size = 0;
+        BlockParser parser(parse_pool_, parse_options_, num_cols_, 1);
+        int64_t parsed_size = 0;
         RETURN_NOT_OK(parser.Parse(reinterpret_cast<const char*>(cur_data_),
-                      static_cast<uint32_t>(cur_size_), &parsed_size));
+                      cur_size_, &parsed_size));
         if (parser.num_cols() == 0) {
             return arrow::Status::Invalid("No columns in FWF");
         } 
@@ -245,32 +508,735 @@ class BaseTableReader : public fwfr::TableReader {
     num_cols_ = static_cast<int32_t>(column_names_.size());
     DCHECK_GT(num_cols_, 0);
 
+    // Bind predicates to their columns
+    for (const auto& predicate : read_options_.predicates) {
+      auto it = std::find(column_names_.begin(), column_names_.end(), predicate.column);
+      if (it == column_names_.end()) {
+        return arrow::Status::KeyError("Predicate column '", predicate.column,
+                                       "' not found");
+      }
+      row_filters_.emplace_back(predicate,
+                                static_cast<int32_t>(it - column_names_.begin()));
+    }
+    if (read_options_.raw_records && !row_filters_.empty()) {
+      return arrow::Status::NotImplemented("Predicates in raw record mode");
+    }
+    for (int32_t col_index = 0; col_index < num_cols_; ++col_index) {
+      RETURN_NOT_OK(CheckNumericFormat(column_names_[col_index], col_index));
+    }
+
+    if (read_options_.raw_records) {
+      // Only the key columns get builders
+      return MakeRawKeyBuilders();
+    }
+    if (lazy_ || streaming_) {
+      // Lazy columns get builders on first access, and streamed columns
+      // get converters once their types are known
+      return arrow::Status::OK();
+    }
+
+    if (!column_builders_.empty()) {
+      // Dataset files after the first share the first one's builders
+      return arrow::Status::OK();
+    }
+
     // Construct column builders
     for (int32_t col_index = 0; col_index < num_cols_; ++col_index) {
       std::shared_ptr<ColumnBuilder> builder;
-      // Does the named column have a fixed type?
-      auto it = convert_options_.column_types.find(column_names_[col_index]);
-      if (it == convert_options_.column_types.end()) {
-        RETURN_NOT_OK(
-            ColumnBuilder::Make(col_index, convert_options_, task_group_, &builder));
-      } else {
-        RETURN_NOT_OK(ColumnBuilder::Make(it->second, col_index, convert_options_,
-                                          task_group_, &builder));
-      }
+      RETURN_NOT_OK(MakeColumnBuilder(column_names_[col_index], col_index, col_index,
+                                      &builder));
       column_builders_.push_back(builder);
     }
     return arrow::Status::OK();
   }
 
-  // Trigger conversion of parsed block data
+  // Binary numeric values would be mangled by the input encoding conversion
+  arrow::Status CheckNumericFormat(const std::string& name, int32_t index) {
+    if (read_options_.encoding.empty()) {
+      return arrow::Status::OK();
+    }
+    const auto encoding = convert_options_.ForColumn(name, index).numeric_format.encoding;
+    if (encoding == NumericFormat::BINARY || encoding == NumericFormat::PACKED) {
+      return arrow::Status::Invalid("Column '", name, "' holds binary values, which ",
+                                    "cannot be read with an input encoding");
+    }
+    return arrow::Status::OK();
+  }
+
+  // Construct the builder for a column, converting the parser's col_index
+  arrow::Status MakeColumnBuilder(const std::string& name, int32_t index,
+                                  int32_t col_index,
+                                  std::shared_ptr<ColumnBuilder>* out) {
+    // Only pay for the conversion rules that apply to this column
+    const ConvertOptions column_options = convert_options_.ForColumn(name, index);
+    // Does the named column have a fixed type?
+    auto it = convert_options_.column_types.find(name);
+    if (it == convert_options_.column_types.end()) {
+      return ColumnBuilder::Make(col_index, column_options, convert_pool_, task_group_,
+                                 out);
+    }
+    return ColumnBuilder::Make(it->second, col_index, column_options, convert_pool_,
+                               task_group_, out);
+  }
+
+  // Trigger conversion of parsed block data (or retain it, if lazy)
   arrow::Status ProcessData(const std::shared_ptr<BlockParser>& parser,
                             int64_t block_index) {
-    for (auto& builder : column_builders_) {
-      builder->Insert(block_index, parser);
+    // Drop rejected rows before anything gets converted
+    for (const auto& row_filter : row_filters_) {
+      RETURN_NOT_OK(row_filter.Apply(parser.get()));
+    }
+    if (lazy_) {
+      std::lock_guard<std::mutex> lock(lazy_mutex_);
+      if (lazy_parsers_.size() <= static_cast<size_t>(block_index)) {
+        lazy_parsers_.resize(block_index + 1);
+      }
+      lazy_parsers_[block_index] = parser;
+      return arrow::Status::OK();
+    }
+    ColumnBuilder::InsertColumns(column_builders_, block_index, parser);
+    return arrow::Status::OK();
+  }
+
+  bool IsFramed() const { return parse_options_.record_format != ParseOptions::LINES; }
+
+  // Wait for tasks in flight to release memory, if over the memory budget
+  void WaitForMemory() {
+    if (budget_) {
+      budget_->Wait();
+    }
+  }
+
+  // Clean up ICU, and the input once read
+  void FinishInput() {
+    ucnv_close(ucnv_);
+    ucnv_ = nullptr;
+    if (dataset_) {
+      // Other files of the dataset still use ICU, and this reader stays
+      // alive until they are read, so release its blocks now
+      readahead_.reset();
+      cur_block_.reset();
+      return;
+    }
+    u_cleanup();
+  }
+
+  // Records with descriptor words: hop descriptors serially to cut chunks of
+  // whole records (or blocks), then index, parse and convert chunks in parallel
+  arrow::Status ReadRecords() {
+    record_framer_ = std::make_shared<RecordFramer>(parse_options_);
+    record_width_ = 0;
+    for (auto width : parse_options_.field_widths) {
+      record_width_ += width;
+    }
+    // Records are padded back to back, so line separators mean nothing
+    record_parse_options_ = parse_options_;
+    record_parse_options_.ignore_empty_lines = false;
+    record_parse_options_.newlines_in_values = true;
+
+    while (task_group_->ok()) {
+      int64_t chunk_size = 0;
+      RETURN_NOT_OK(record_framer_->Process(cur_data_, cur_size_,
+                                            &chunk_size));
+      if (chunk_size > 0) {
+        const uint8_t* chunk_data = cur_data_;
+        std::shared_ptr<arrow::Buffer> chunk_buffer = cur_block_;
+        int64_t chunk_index = cur_block_index_++;
+
+        WaitForMemory();
+        // "mutable" allows to modify captured by-copy chunk_buffer
+        task_group_->Append([=]() mutable -> arrow::Status {
+          RETURN_NOT_OK(ProcessRecordChunk(chunk_data, chunk_size, chunk_index));
+          // Keep chunk buffer alive within closure and release it at the end
+          chunk_buffer.reset();
+          return arrow::Status::OK();
+        });
+        cur_data_ += chunk_size;
+        cur_size_ -= chunk_size;
+      } else if (!eof_) {
+        // Need to fetch more data to get at least one record
+        RETURN_NOT_OK(ReadNextBlock());
+      } else {
+        break;
+      }
     }
+    RETURN_NOT_OK(task_group_->Finish());
+    if (cur_size_ > 0) {
+      return arrow::Status::Invalid("Truncated record at the end of FWF data");
+    }
+
+    // Clean up ICU
+    ucnv_close(ucnv_);
+    u_cleanup();
     return arrow::Status::OK();
   }
 
+  // Strip a chunk's descriptor words, converting the encoding of and padding
+  // each record to the field widths, then parse and convert (or retain) it
+  arrow::Status ProcessRecordChunk(const uint8_t* data, int64_t size,
+                                   int64_t chunk_index) {
+    std::vector<RecordSpan> records;
+    RETURN_NOT_OK(record_framer_->IndexRecords(data, size, &records));
+
+    // Converters are not thread-safe, so each chunk gets its own
+    UErrorCode uerr = U_ZERO_ERROR;
+    UConverter* ucnv = nullptr;
+    if (!read_options_.encoding.empty()) {
+      ucnv = ucnv_open(read_options_.encoding.c_str(), &uerr);
+      if (U_FAILURE(uerr)) {
+        return arrow::Status::Invalid(u_errorName(uerr));
+      }
+    }
+    std::string converted;
+    std::string padded;
+    padded.reserve(records.size() * record_width_);
+    arrow::Status status;
+    for (const auto& record : records) {
+      const char* record_data = reinterpret_cast<const char*>(data + record.offset);
+      int64_t record_size = record.size;
+      if (ucnv != nullptr) {
+        // UTF8 takes at most 3 bytes per UTF16 code unit
+        converted.resize(3 * record.size + 1);
+        record_size = ucnv_toAlgorithmic(UCNV_UTF8, ucnv, &converted[0],
+                                         static_cast<int32_t>(converted.size()),
+                                         record_data,
+                                         static_cast<int32_t>(record.size), &uerr);
+        record_data = converted.data();
+        if (U_FAILURE(uerr)) {
+          status = arrow::Status::Invalid(u_errorName(uerr));
+          break;
+        }
+      }
+      if (ARROW_PREDICT_FALSE(record_size > record_width_)) {
+        status = arrow::Status::Invalid("Record of ", record_size,
+                                        " bytes is longer than the field widths (",
+                                        record_width_, " bytes)");
+        break;
+      }
+      padded.append(record_data, record_size);
+      padded.append(record_width_ - record_size, ' ');
+    }
+    if (ucnv != nullptr) {
+      ucnv_close(ucnv);
+    }
+    RETURN_NOT_OK(status);
+
+    static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
+    auto parser = std::make_shared<BlockParser>(parse_pool_, record_parse_options_, num_cols_,
+                                                max_num_rows);
+    int64_t parsed_size = 0;
+    RETURN_NOT_OK(parser->ParseFinal(padded.data(), static_cast<int64_t>(padded.size()),
+                                     &parsed_size));
+    return ProcessData(parser, chunk_index);
+  }
+
+  // Fix the types of streamed columns, inferring undeclared ones from the
+  // first block of rows (which stays in place to be streamed)
+  arrow::Status MakeStreamConverters() {
+    static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
+    std::shared_ptr<BlockParser> parser;
+    while (true) {
+      parser = std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_,
+                                             max_num_rows);
+      int64_t parsed_size = 0;
+      if (eof_) {
+        RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(cur_data_),
+                                         cur_size_,
+                                         &parsed_size));
+        break;
+      }
+      RETURN_NOT_OK(parser->Parse(reinterpret_cast<const char*>(cur_data_),
+                                  cur_size_, &parsed_size));
+      if (parser->num_rows() > 0) {
+        break;
+      }
+      RETURN_NOT_OK(ReadNextBlock());
+    }
+
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for (int32_t col_index = 0; col_index < num_cols_; ++col_index) {
+      const std::string& name = column_names_[col_index];
+      const ConvertOptions column_options = convert_options_.ForColumn(name, col_index);
+      std::shared_ptr<arrow::DataType> type;
+      auto it = convert_options_.column_types.find(name);
+      if (it != convert_options_.column_types.end()) {
+        type = it->second;
+      } else {
+        auto task_group = arrow::internal::TaskGroup::MakeSerial();
+        std::shared_ptr<ColumnBuilder> builder;
+        RETURN_NOT_OK(ColumnBuilder::Make(col_index, column_options, convert_pool_,
+                                          task_group, &builder));
+        builder->Insert(0, parser);
+        RETURN_NOT_OK(task_group->Finish());
+        std::shared_ptr<arrow::ChunkedArray> array;
+        RETURN_NOT_OK(builder->Finish(&array));
+        type = array->type();
+        if (type->id() == arrow::Type::NA) {
+          // No values to infer from
+          RETURN_NOT_OK(InferredStringType(column_options, false, &type));
+        }
+      }
+      std::shared_ptr<Converter> converter;
+      RETURN_NOT_OK(Converter::Make(type, column_options, convert_pool_, &converter));
+      stream_converters_.push_back(converter);
+      fields.push_back(arrow::field(name, type));
+    }
+    stream_schema_ = arrow::schema(fields);
+    return arrow::Status::OK();
+  }
+
+  // Hand out the next streamed batch, keeping the next blocks in flight
+  arrow::Status ReadNextBatch(std::shared_ptr<arrow::RecordBatch>* out) {
+    while (true) {
+      while (!stream_eof_ &&
+             static_cast<int32_t>(stream_batches_.size()) < stream_max_batches_) {
+        RETURN_NOT_OK(SubmitStreamChunk());
+      }
+      if (stream_batches_.empty()) {
+        // Clean up ICU
+        if (ucnv_ != nullptr) {
+          ucnv_close(ucnv_);
+          ucnv_ = nullptr;
+          u_cleanup();
+        }
+        out->reset();
+        return arrow::Status::OK();
+      }
+      BatchResult result = stream_batches_.front().get();
+      stream_batches_.pop_front();
+      RETURN_NOT_OK(result.first);
+      // Skip blocks whose rows were all filtered out
+      if (result.second->num_rows() > 0) {
+        *out = result.second;
+        return arrow::Status::OK();
+      }
+    }
+  }
+
+  // Cut the next chunk of rows and start converting it (the rest of the
+  // data, at the end of the input)
+  arrow::Status SubmitStreamChunk() {
+    int64_t chunk_size = 0;
+    while (!eof_) {
+      RETURN_NOT_OK(stream_chunker_->Process(reinterpret_cast<const char*>(cur_data_),
+                                             cur_size_,
+                                             &chunk_size));
+      if (chunk_size > 0) {
+        break;
+      }
+      // Need to fetch more data to get at least one row
+      RETURN_NOT_OK(ReadNextBlock());
+    }
+    const bool is_final = eof_;
+    if (is_final) {
+      stream_eof_ = true;
+      chunk_size = cur_size_;
+      if (chunk_size == 0) {
+        return arrow::Status::OK();
+      }
+    }
+    const uint8_t* chunk_data = cur_data_;
+    std::shared_ptr<arrow::Buffer> chunk_buffer = cur_block_;
+    auto task = [=]() -> BatchResult {
+      std::shared_ptr<arrow::RecordBatch> batch;
+      arrow::Status status =
+          ConvertStreamChunk(chunk_data, chunk_size, is_final, &batch);
+      // chunk_buffer keeps the chunk alive until then
+      ARROW_UNUSED(chunk_buffer);
+      return BatchResult(status, batch);
+    };
+    if (thread_pool_ != nullptr) {
+      stream_batches_.push_back(thread_pool_->Submit(task));
+    } else {
+      std::promise<BatchResult> result;
+      result.set_value(task());
+      stream_batches_.push_back(result.get_future());
+    }
+    cur_data_ += chunk_size;
+    cur_size_ -= chunk_size;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ConvertStreamChunk(const uint8_t* data, int64_t size, bool is_final,
+                                   std::shared_ptr<arrow::RecordBatch>* out) {
+    static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
+    auto parser =
+        std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_, max_num_rows);
+    int64_t parsed_size = 0;
+    if (is_final) {
+      RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(data), size,
+                                       &parsed_size));
+    } else {
+      RETURN_NOT_OK(
+          parser->Parse(reinterpret_cast<const char*>(data), size, &parsed_size));
+      if (parsed_size != size && parse_options_.skip_columns.size() == 0) {
+        return arrow::Status::Invalid("Chunker and parser disagree on block size: ",
+                                      size, " vs ", parsed_size);
+      }
+    }
+    for (const auto& row_filter : row_filters_) {
+      RETURN_NOT_OK(row_filter.Apply(parser.get()));
+    }
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    for (int32_t col_index = 0; col_index < num_cols_; ++col_index) {
+      std::shared_ptr<arrow::Array> array;
+      arrow::Status status =
+          stream_converters_[col_index]->Convert(*parser, col_index, &array);
+      if (!status.ok()) {
+        return arrow::Status(status.code(), "In column #" + std::to_string(col_index) +
+                                                ": " + status.message());
+      }
+      arrays.push_back(array);
+    }
+    *out = arrow::RecordBatch::Make(stream_schema_, parser->num_rows(), arrays);
+    return arrow::Status::OK();
+  }
+
+  // Construct a parse plan and column builders for each record layout
+  arrow::Status MakeLayoutBuilders() {
+    for (const auto& layout : parse_options_.layouts) {
+      if (layout.type_code.empty()) {
+        return arrow::Status::Invalid("Record layouts need a type code");
+      }
+      ParseOptions layout_options = parse_options_;
+      layout_options.layouts.clear();
+      layout_options.field_widths = layout.field_widths;
+      layout_options.skip_columns = layout.skip_columns;
+      // Lines are dispatched one by one (dropping empty ones as requested),
+      // so a line separator only ever ends a record here
+      layout_options.ignore_empty_lines = true;
+      // The column count is fixed up front, as there is no header row
+      const int32_t num_cols = static_cast<int32_t>(layout.column_names.size());
+      int32_t num_parsed = 0;
+      uint32_t record_width = 0;
+      for (uint32_t i = 0; i < layout.field_widths.size(); ++i) {
+        record_width += layout.field_widths[i];
+        if (std::find(layout.skip_columns.begin(), layout.skip_columns.end(), i) ==
+            layout.skip_columns.end()) {
+          ++num_parsed;
+        }
+      }
+      if (num_cols == 0 || num_cols != num_parsed) {
+        return arrow::Status::Invalid("Record layout '", layout.type_code, "' has ",
+                                      num_parsed, " columns but ", num_cols,
+                                      " column names");
+      }
+
+      std::vector<std::shared_ptr<ColumnBuilder>> builders;
+      for (int32_t col_index = 0; col_index < num_cols; ++col_index) {
+        RETURN_NOT_OK(CheckNumericFormat(layout.column_names[col_index], col_index));
+        std::shared_ptr<ColumnBuilder> builder;
+        RETURN_NOT_OK(MakeColumnBuilder(layout.column_names[col_index], col_index,
+                                        col_index, &builder));
+        builders.push_back(builder);
+      }
+      layout_parse_options_.push_back(layout_options);
+      layout_widths_.push_back(record_width);
+      layout_builders_.push_back(builders);
+    }
+    return arrow::Status::OK();
+  }
+
+  // Dispatch a chunk's lines to their layouts, then parse and convert
+  // each layout's lines
+  arrow::Status ProcessLayoutChunk(const char* data, int64_t size,
+                                   int64_t chunk_index) {
+    const auto& layouts = parse_options_.layouts;
+    const uint32_t offset = parse_options_.type_code_offset;
+    std::vector<std::string> layout_data(layouts.size());
+
+    const char* data_end = data + size;
+    while (data < data_end) {
+      // Find the line end, including its separator
+      const char* line_end = data;
+      while (line_end < data_end && *line_end != '\r' && *line_end != '\n') {
+        ++line_end;
+      }
+      const size_t line_size = static_cast<size_t>(line_end - data);
+      if (line_end < data_end && *line_end++ == '\r' && line_end < data_end &&
+          *line_end == '\n') {
+        ++line_end;
+      }
+      if (line_size == 0 && parse_options_.ignore_empty_lines) {
+        data = line_end;
+        continue;
+      }
+
+      size_t k = 0;
+      for (; k < layouts.size(); ++k) {
+        const std::string& code = layouts[k].type_code;
+        if (offset + code.size() <= line_size &&
+            std::memcmp(data + offset, code.data(), code.size()) == 0) {
+          break;
+        }
+      }
+      if (ARROW_PREDICT_FALSE(k == layouts.size())) {
+        return arrow::Status::Invalid("No record layout for line '",
+                                      std::string(data, line_size), "'");
+      }
+      if (ARROW_PREDICT_FALSE(line_size != layout_widths_[k])) {
+        return arrow::Status::Invalid("Record of type '", layouts[k].type_code,
+                                      "' is ", line_size, " bytes long, expected ",
+                                      layout_widths_[k]);
+      }
+      layout_data[k].append(data, line_end - data);
+      data = line_end;
+    }
+
+    static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
+    for (size_t k = 0; k < layouts.size(); ++k) {
+      // Layouts without lines in this chunk still get an (empty) chunk,
+      // so that every builder sees every chunk index
+      const int32_t num_cols = static_cast<int32_t>(layout_builders_[k].size());
+      auto parser = std::make_shared<BlockParser>(parse_pool_, layout_parse_options_[k],
+                                                  num_cols, max_num_rows);
+      int64_t parsed_size = 0;
+      RETURN_NOT_OK(parser->ParseFinal(layout_data[k].data(),
+                                       static_cast<int64_t>(layout_data[k].size()),
+                                       &parsed_size));
+      ColumnBuilder::InsertColumns(layout_builders_[k], chunk_index, parser);
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status MakeLayoutTables(
+      std::unordered_map<std::string, std::shared_ptr<arrow::Table>>* out) {
+    const auto& layouts = parse_options_.layouts;
+    out->clear();
+    for (size_t k = 0; k < layouts.size(); ++k) {
+      std::vector<std::shared_ptr<arrow::Field>> fields;
+      std::vector<std::shared_ptr<arrow::Column>> columns;
+      for (size_t i = 0; i < layout_builders_[k].size(); ++i) {
+        std::shared_ptr<arrow::ChunkedArray> array;
+        RETURN_NOT_OK(layout_builders_[k][i]->Finish(&array));
+        // Drop the chunks where this record type did not occur
+        arrow::ArrayVector chunks;
+        for (const auto& chunk : array->chunks()) {
+          if (chunk->length() > 0) {
+            chunks.push_back(chunk);
+          }
+        }
+        array = std::make_shared<arrow::ChunkedArray>(chunks, array->type());
+        columns.push_back(
+            std::make_shared<arrow::Column>(layouts[k].column_names[i], array));
+        fields.push_back(columns.back()->field());
+      }
+      RETURN_NOT_OK(CoalesceOutput(&columns));
+      (*out)[layouts[k].type_code] = arrow::Table::Make(schema(fields), columns);
+    }
+    return arrow::Status::OK();
+  }
+
+  // Construct column builders for the raw record mode key columns, which are
+  // parsed in field order with all other fields skipped
+  arrow::Status MakeRawKeyBuilders() {
+    std::vector<uint32_t> parsed_fields;
+    for (uint32_t i = 0; i < parse_options_.field_widths.size(); ++i) {
+      if (std::find(parse_options_.skip_columns.begin(), parse_options_.skip_columns.end(),
+                    i) == parse_options_.skip_columns.end()) {
+        parsed_fields.push_back(i);
+      }
+    }
+    DCHECK_EQ(parsed_fields.size(), column_names_.size());
+
+    std::vector<int32_t> key_indices;
+    for (const auto& key : read_options_.raw_key_columns) {
+      auto it = std::find(column_names_.begin(), column_names_.end(), key);
+      if (it == column_names_.end()) {
+        return arrow::Status::KeyError("Raw record key column '", key, "' not found");
+      }
+      key_indices.push_back(static_cast<int32_t>(it - column_names_.begin()));
+    }
+    std::sort(key_indices.begin(), key_indices.end());
+    key_indices.erase(std::unique(key_indices.begin(), key_indices.end()),
+                      key_indices.end());
+
+    key_parse_options_ = parse_options_;
+    key_parse_options_.skip_columns.clear();
+    for (uint32_t i = 0; i < parse_options_.field_widths.size(); ++i) {
+      key_parse_options_.skip_columns.push_back(i);
+    }
+    std::vector<std::string> key_names;
+    for (int32_t key_index : key_indices) {
+      const uint32_t field = parsed_fields[key_index];
+      key_parse_options_.skip_columns.erase(
+          std::find(key_parse_options_.skip_columns.begin(),
+                    key_parse_options_.skip_columns.end(), field));
+
+      std::shared_ptr<ColumnBuilder> builder;
+      const std::string& name = column_names_[key_index];
+      const int32_t col_index = static_cast<int32_t>(key_names.size());
+      RETURN_NOT_OK(MakeColumnBuilder(name, key_index, col_index, &builder));
+      column_builders_.push_back(builder);
+      key_names.push_back(name);
+    }
+    column_names_ = key_names;
+    num_cols_ = static_cast<int32_t>(key_names.size());
+    return arrow::Status::OK();
+  }
+
+  // Raw record mode: emit records as zero-copy slices of the input blocks
+  arrow::Status ReadRaw(std::shared_ptr<arrow::Table>* out) {
+    record_width_ = 0;
+    for (auto width : parse_options_.field_widths) {
+      record_width_ += width;
+    }
+    if (read_options_.column_names.empty()) {
+      // The header row leaves its line separator in place (the parser would
+      // skip it as an empty line), while records are sliced as they are
+      while (!eof_ && cur_size_ < 2) {
+        RETURN_NOT_OK(ReadNextBlock());
+      }
+      if (cur_size_ > 0 && cur_data_[0] == '\r') {
+        ++cur_data_;
+        --cur_size_;
+      }
+      if (cur_size_ > 0 && cur_data_[0] == '\n') {
+        ++cur_data_;
+        --cur_size_;
+      }
+    }
+    // Detect the line terminator from the first record
+    while (!eof_ && cur_size_ < record_width_ + 2) {
+      RETURN_NOT_OK(ReadNextBlock());
+    }
+    record_terminator_.clear();
+    for (int64_t i = record_width_; i < std::min(cur_size_, record_width_ + 2); ++i) {
+      const char c = static_cast<char>(cur_data_[i]);
+      if ((c == '\r' && record_terminator_.empty()) ||
+          (c == '\n' && record_terminator_ != "\n")) {
+        record_terminator_.push_back(c);
+      } else {
+        break;
+      }
+    }
+    record_stride_ = record_width_ + static_cast<int64_t>(record_terminator_.size());
+    if (record_stride_ == 0) {
+      return arrow::Status::Invalid("Raw record mode requires non-empty records");
+    }
+    record_type_ = arrow::fixed_size_binary(static_cast<int32_t>(record_stride_));
+    // Key fields are parsed in place, treating terminators as empty lines
+    key_parse_options_.ignore_empty_lines = !record_terminator_.empty();
+
+    while (task_group_->ok()) {
+      // Consume all complete records in the current block
+      const int64_t chunk_size = cur_size_ - cur_size_ % record_stride_;
+      if (chunk_size > 0) {
+        const int64_t chunk_index = cur_block_index_++;
+        auto records = arrow::SliceBuffer(cur_block_, cur_data_ - cur_block_->data(),
+                                          chunk_size);
+        task_group_->Append([=]() -> arrow::Status {
+          return ProcessRawChunk(records, chunk_index);
+        });
+        cur_data_ += chunk_size;
+        cur_size_ -= chunk_size;
+      } else if (!eof_) {
+        // Need to fetch more data to get at least one record
+        RETURN_NOT_OK(ReadNextBlock());
+      } else {
+        break;
+      }
+    }
+    RETURN_NOT_OK(task_group_->Finish());
+
+    if (eof_ && cur_size_ > 0) {
+      // The last record may lack its terminator; copy it with one appended
+      if (cur_size_ != record_width_) {
+        return RawRecordError();
+      }
+      std::shared_ptr<arrow::Buffer> last_record;
+      RETURN_NOT_OK(AllocateBuffer(output_pool_, record_stride_, &last_record));
+      std::memcpy(last_record->mutable_data(), cur_data_, cur_size_);
+      std::memcpy(last_record->mutable_data() + cur_size_, record_terminator_.data(),
+                  record_terminator_.size());
+      task_group_ = arrow::internal::TaskGroup::MakeSerial();
+      for (auto& builder : column_builders_) {
+        builder->SetTaskGroup(task_group_);
+      }
+      RETURN_NOT_OK(ProcessRawChunk(last_record, cur_block_index_++));
+      RETURN_NOT_OK(task_group_->Finish());
+    }
+
+    // Clean up ICU
+    ucnv_close(ucnv_);
+    u_cleanup();
+
+    return MakeRawTable(out);
+  }
+
+  // Check and record a buffer of whole records, and parse its key columns
+  arrow::Status ProcessRawChunk(const std::shared_ptr<arrow::Buffer>& records,
+                                int64_t chunk_index) {
+    const int64_t num_records = records->size() / record_stride_;
+    if (!record_terminator_.empty()) {
+      const uint8_t* terminator = records->data() + record_width_;
+      for (int64_t i = 0; i < num_records; ++i, terminator += record_stride_) {
+        if (ARROW_PREDICT_FALSE(std::memcmp(terminator, record_terminator_.data(),
+                                            record_terminator_.size()) != 0)) {
+          return RawRecordError();
+        }
+      }
+    }
+    auto chunk = std::make_shared<arrow::FixedSizeBinaryArray>(record_type_, num_records,
+                                                               records);
+    {
+      std::lock_guard<std::mutex> lock(raw_mutex_);
+      if (raw_chunks_.size() <= static_cast<size_t>(chunk_index)) {
+        raw_chunks_.resize(chunk_index + 1);
+      }
+      raw_chunks_[chunk_index] = std::move(chunk);
+    }
+
+    if (num_cols_ > 0) {
+      static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
+      auto parser = std::make_shared<BlockParser>(parse_pool_, key_parse_options_, num_cols_,
+                                                  max_num_rows);
+      int64_t parsed_size = 0;
+      RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(records->data()),
+                                       static_cast<int64_t>(records->size()),
+                                       &parsed_size));
+      if (parser->num_rows() != num_records) {
+        return RawRecordError();
+      }
+      RETURN_NOT_OK(ProcessData(parser, chunk_index));
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status RawRecordError() {
+    return arrow::Status::Invalid("Raw record mode requires fixed-length records of ",
+                                  record_width_, " bytes");
+  }
+
+  arrow::Status MakeRawTable(std::shared_ptr<arrow::Table>* out) {
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::Column>> columns;
+
+    auto records = std::make_shared<arrow::ChunkedArray>(raw_chunks_, record_type_);
+    columns.push_back(std::make_shared<arrow::Column>("record", records));
+    fields.push_back(columns.back()->field());
+    for (int32_t i = 0; i < num_cols_; ++i) {
+      std::shared_ptr<arrow::ChunkedArray> array;
+      RETURN_NOT_OK(column_builders_[i]->Finish(&array));
+      columns.push_back(std::make_shared<arrow::Column>(column_names_[i], array));
+      fields.push_back(columns.back()->field());
+    }
+    RETURN_NOT_OK(CoalesceOutput(&columns));
+    *out = arrow::Table::Make(schema(fields), columns);
+    return arrow::Status::OK();
+  }
+
+  // Concatenate the chunks of the table's columns (one per block) into
+  // chunks of at least output_chunk_rows rows, a column per task
+  arrow::Status CoalesceOutput(std::vector<std::shared_ptr<arrow::Column>>* columns) {
+    if (read_options_.output_chunk_rows <= 0) {
+      return arrow::Status::OK();
+    }
+    auto task_group = MakeTaskGroup(thread_pool_, parallelism_, read_options_.priority);
+    return CoalesceColumns(read_options_.output_chunk_rows, output_pool_, task_group,
+                           columns);
+  }
+
   arrow::Status MakeTable(std::shared_ptr<arrow::Table>* out) {
     DCHECK_GT(num_cols_, 0);
     DCHECK_EQ(column_names_.size(), static_cast<uint32_t>(num_cols_));
@@ -285,11 +1251,27 @@ class BaseTableReader : public fwfr::TableReader {
       columns.push_back(std::make_shared<arrow::Column>(column_names_[i], array));
       fields.push_back(columns.back()->field());
     }
+    RETURN_NOT_OK(CoalesceOutput(&columns));
     *out = arrow::Table::Make(schema(fields), columns);
     return arrow::Status::OK();
   }
 
-  arrow::MemoryPool* pool_;
+  // Pools of the read, shared by the files of a dataset
+  ReadPools pools_;
+  // Pools of the input blocks, parsers, converted arrays and other buffers
+  // of the table read
+  arrow::MemoryPool* readahead_pool_;
+  arrow::MemoryPool* parse_pool_;
+  arrow::MemoryPool* convert_pool_;
+  arrow::MemoryPool* output_pool_;
+  // Optional cap on the memory held by the read
+  std::shared_ptr<MemoryBudget> budget_;
+  // Sizer of the chunks of an adaptive threaded read, null otherwise
+  std::unique_ptr<BlockSizer> block_sizer_;
+  // Thread pool for conversion tasks, null when reading serially
+  arrow::internal::ThreadPool* thread_pool_ = nullptr;
+  // Number of blocks read ahead, parsed or converted at once
+  int32_t parallelism_ = 1;
   ReadOptions read_options_;
   ParseOptions parse_options_;
   ConvertOptions convert_options_;
@@ -302,6 +1284,8 @@ class BaseTableReader : public fwfr::TableReader {
   std::shared_ptr<arrow::io::internal::ReadaheadSpooler> readahead_;
   // Column names
   std::vector<std::string> column_names_;
+  // Predicates bound to their columns
+  std::vector<RowFilter> row_filters_;
   std::shared_ptr<arrow::internal::TaskGroup> task_group_;
   std::vector<std::shared_ptr<ColumnBuilder>> column_builders_;
 
@@ -316,48 +1300,85 @@ class BaseTableReader : public fwfr::TableReader {
   // Whether we reached input stream EOF.  There may still be data left to
   // process in current block.
   bool eof_ = false;
+  // Bytes read from the input (after decoding)
+  int64_t input_read_ = 0;
+
+  // Raw record mode (and records with descriptor words): record layout
+  // and emitted chunks
+  int64_t record_width_ = 0;
+  int64_t record_stride_ = 0;
+  std::string record_terminator_;
+  std::shared_ptr<arrow::DataType> record_type_;
+  ParseOptions key_parse_options_;
+  std::mutex raw_mutex_;
+  arrow::ArrayVector raw_chunks_;
+
+  // Record layouts: parse plans and column builders of each layout
+  std::vector<ParseOptions> layout_parse_options_;
+  std::vector<uint32_t> layout_widths_;
+  std::vector<std::vector<std::shared_ptr<ColumnBuilder>>> layout_builders_;
+
+  // Records with descriptor words: framer and parse plan of the padded records
+  std::shared_ptr<RecordFramer> record_framer_;
+  ParseOptions record_parse_options_;
+
+  // Dataset mode: the task group and column builders are shared by all files
+  bool dataset_ = false;
+
+  // Lazy mode: the parsers of each block, handed over to the LazyTable
+  bool lazy_ = false;
+  std::mutex lazy_mutex_;
+  std::vector<std::shared_ptr<BlockParser>> lazy_parsers_;
+
+  // Streaming mode: column converters and the blocks in flight, in order
+  using BatchResult = std::pair<arrow::Status, std::shared_ptr<arrow::RecordBatch>>;
+  bool streaming_ = false;
+  std::shared_ptr<arrow::Schema> stream_schema_;
+  std::vector<std::shared_ptr<Converter>> stream_converters_;
+  std::shared_ptr<Chunker> stream_chunker_;
+  int32_t stream_max_batches_ = 1;
+  std::deque<std::future<BatchResult>> stream_batches_;
+  bool stream_eof_ = false;
 };
 
 /////////////////////////////////////////////////////////////////////////
 // Serial TableReader implementation
 class SerialTableReader : public BaseTableReader {
  public:
-  SerialTableReader(arrow::MemoryPool* pool,
-                    std::shared_ptr<arrow::io::InputStream> input,
+  SerialTableReader(std::shared_ptr<arrow::io::InputStream> input,
+                    const ReadPools& pools,
                     const ReadOptions& read_options,
                     const ParseOptions& parse_options,
                     const ConvertOptions& convert_options)
-      : BaseTableReader(pool, read_options, parse_options, convert_options) {
+      : BaseTableReader(pools, read_options, parse_options, convert_options) {
     // Since we're converting serially, no need to readahead more than one block
     int32_t block_queue_size = 1;
     readahead_ = std::make_shared<arrow::io::internal::ReadaheadSpooler>(
-        pool_, input, read_options_.block_size, block_queue_size, kDefaultLeftPadding,
+        readahead_pool_, input, read_options_.block_size, block_queue_size,
+        kDefaultLeftPadding,
         kDefaultRightPadding);
   }
 
-  arrow::Status Read(std::shared_ptr<arrow::Table>* out) {
-    task_group_ = arrow::internal::TaskGroup::MakeSerial();
-
-    // First block
-    RETURN_NOT_OK(ReadFirstBlock());
-    if (eof_) {
-      return arrow::Status::Invalid("Empty FWF file");
-    }
-    RETURN_NOT_OK(ProcessHeader());
-
+ protected:
+  arrow::Status ReadBlocks() override {
     static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
     auto parser =
-        std::make_shared<BlockParser>(pool_, parse_options_, num_cols_, max_num_rows);
+        std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_, max_num_rows);
     while (!eof_) {
       // Consume current block
-      uint32_t parsed_size = 0;
+      int64_t parsed_size = 0;
       RETURN_NOT_OK(parser->Parse(reinterpret_cast<const char*>(cur_data_),
-                                  static_cast<uint32_t>(cur_size_), &parsed_size));
+                                  cur_size_, &parsed_size));
       if (parser->num_rows() > 0) {
         // Got some data
         RETURN_NOT_OK(ProcessData(parser, cur_block_index_++));
         cur_data_ += parsed_size;
         cur_size_ -= parsed_size;
+        if (lazy_) {
+          // The parser is retained, so parse the next block into a new one
+          parser = std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_,
+                                                 max_num_rows);
+        }
         if (!task_group_->ok()) {
           // Conversion error => early exit
           break;
@@ -369,22 +1390,21 @@ class SerialTableReader : public BaseTableReader {
     }
     if (eof_ && cur_size_ > 0) {
       // Parse remaining data
-      uint32_t parsed_size = 0;
+      int64_t parsed_size = 0;
       RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(cur_data_),
-                                       static_cast<uint32_t>(cur_size_), &parsed_size));
+                                       cur_size_, &parsed_size));
       if (parser->num_rows() > 0) {
         RETURN_NOT_OK(ProcessData(parser, cur_block_index_++));
       }
     }
 
-    // Finish conversion, create schema and table
-    RETURN_NOT_OK(task_group_->Finish());
-
-    // Clean up ICU
-    ucnv_close(ucnv_);
-    u_cleanup();
-    
-    return MakeTable(out);
+    // Finish conversion, create schema and table (once the whole dataset
+    // is read, in dataset mode)
+    if (!dataset_) {
+      RETURN_NOT_OK(task_group_->Finish());
+    }
+    FinishInput();
+    return arrow::Status::OK();
   }
 };
 
@@ -392,63 +1412,114 @@ class SerialTableReader : public BaseTableReader {
 // Parallel TableReader implementation
 class ThreadedTableReader : public BaseTableReader {
  public:
-  ThreadedTableReader(arrow::MemoryPool* pool,
-                      std::shared_ptr<arrow::io::InputStream> input,
+  // input_size is the size of the input, or -1 if unknown
+  ThreadedTableReader(std::shared_ptr<arrow::io::InputStream> input,
+                      int64_t input_size,
                       arrow::internal::ThreadPool* thread_pool,
+                      const ReadPools& pools,
                       const ReadOptions& read_options,
                       const ParseOptions& parse_options,
                       const ConvertOptions& convert_options)
-      : BaseTableReader(pool, read_options, parse_options, convert_options),
-        thread_pool_(thread_pool) {
-    // Readahead one block per worker thread
-    int32_t block_queue_size = thread_pool->GetCapacity();
+      : BaseTableReader(pools, read_options, parse_options, convert_options) {
+    thread_pool_ = thread_pool;
+    parallelism_ = GetParallelism(thread_pool, read_options.max_parallelism);
+    // Readahead one block per worker thread allowed
+    int32_t block_queue_size = parallelism_;
+    if (budget_) {
+      // Leave room in the budget for the blocks being parsed, whose parsers
+      // take about as much memory again
+      int64_t max_blocks = budget_->max_bytes() / (2 * int64_t(read_options_.block_size));
+      block_queue_size = static_cast<int32_t>(
+          std::max<int64_t>(1, std::min<int64_t>(block_queue_size, max_blocks)));
+    }
     readahead_ = std::make_shared<arrow::io::internal::ReadaheadSpooler>(
-        pool_, input, read_options_.block_size, block_queue_size, kDefaultLeftPadding,
+        readahead_pool_, input, read_options_.block_size, block_queue_size,
+        kDefaultLeftPadding,
         kDefaultRightPadding);
+    if (read_options_.adaptive_block_size) {
+      block_sizer_.reset(new BlockSizer(read_options_.min_block_size,
+                                        read_options_.block_size, parallelism_,
+                                        input_size));
+    }
   }
 
   ~ThreadedTableReader() {
-    if (task_group_) {
+    if (task_group_ && !dataset_) {
       // In case of error, make sure all pending tasks are finished before
-      // we start destroying BaseTableReader members
+      // we start destroying BaseTableReader members (the dataset reader
+      // does this for its files)
       ARROW_UNUSED(task_group_->Finish());
     }
   }
 
-  arrow::Status Read(std::shared_ptr<arrow::Table>* out) {
-    task_group_ = arrow::internal::TaskGroup::MakeThreaded(thread_pool_);
+ protected:
+  // Find the end of the next chunk of an adaptive read, sized by the block
+  // sizer
+  arrow::Status CarveChunk(Chunker* chunker, int64_t* out_size) {
+    const int64_t start = BlockSizer::NowNanos();
+    const int64_t consumed = input_read_ - cur_size_;
+    const int64_t size = block_sizer_->NextChunkSize(consumed);
+    int64_t chunk_size = 0;
+    if (size < cur_size_) {
+      RETURN_NOT_OK(chunker->Process(reinterpret_cast<const char*>(cur_data_),
+                                     size, &chunk_size));
+      if (chunk_size > 0 && !parse_options_.newlines_in_values &&
+          cur_data_[chunk_size - 1] == '\r' && cur_data_[chunk_size] == '\n') {
+        // Don't leave the LF of a CRLF to start the next chunk with an
+        // empty line (records read by their width are cut between records)
+        ++chunk_size;
+      }
+    }
+    if (chunk_size == 0) {
+      // The rest of the block is smaller than the chunk size, or a row is
+      // larger
+      RETURN_NOT_OK(chunker->Process(reinterpret_cast<const char*>(cur_data_),
+                                     cur_size_, &chunk_size));
+    }
+    block_sizer_->AddChunkTime(BlockSizer::NowNanos() - start);
+    *out_size = chunk_size;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ReadBlocks() override {
     static constexpr int32_t max_num_rows = std::numeric_limits<int32_t>::max();
     Chunker chunker(parse_options_);
 
-    // Get first block and process header serially
-    RETURN_NOT_OK(ReadFirstBlock());
-    if (eof_) {
-      return arrow::Status::Invalid("Empty FWF file");
+    if (block_sizer_ && input_read_ < read_options_.block_size) {
+      // A short first block is the whole input
+      block_sizer_->SetTotalSize(input_read_);
     }
-    RETURN_NOT_OK(ProcessHeader());
 
     while (!eof_ && task_group_->ok()) {
       // Consume current chunk
-      uint32_t chunk_size = 0;
-      RETURN_NOT_OK(chunker.Process(reinterpret_cast<const char*>(cur_data_),
-                                    static_cast<uint32_t>(cur_size_), &chunk_size));
+      int64_t chunk_size = 0;
+      if (block_sizer_) {
+        RETURN_NOT_OK(CarveChunk(&chunker, &chunk_size));
+      } else {
+        RETURN_NOT_OK(chunker.Process(reinterpret_cast<const char*>(cur_data_),
+                                      cur_size_, &chunk_size));
+      }
       if (chunk_size > 0) {
         // Got a chunk of rows
         const uint8_t* chunk_data = cur_data_;
         std::shared_ptr<arrow::Buffer> chunk_buffer = cur_block_;
         int64_t chunk_index = cur_block_index_;
 
+        WaitForMemory();
         // "mutable" allows to modify captured by-copy chunk_buffer
         task_group_->Append([=]() mutable -> arrow::Status {
-          auto parser = std::make_shared<BlockParser>(pool_, parse_options_, 
+          auto parser = std::make_shared<BlockParser>(parse_pool_, parse_options_, 
                                                       num_cols_, max_num_rows);
-          uint32_t parsed_size = 0;
+          int64_t parsed_size = 0;
           RETURN_NOT_OK(parser->Parse(reinterpret_cast<const char*>(chunk_data),
                                       chunk_size, &parsed_size));
           if (parsed_size != chunk_size && parse_options_.skip_columns.size() == 0) {
             return arrow::Status::Invalid("Chunker and parser disagree on block size: ",
                                    chunk_size, " vs ", parsed_size);
           }
+          if (block_sizer_) {
+            block_sizer_->AddParsedChunk(chunk_size);
+          }
           RETURN_NOT_OK(ProcessData(parser, chunk_index));
           // Keep chunk buffer alive within closure and release it at the end
           chunk_buffer.reset();
@@ -457,12 +1528,36 @@ class ThreadedTableReader : public BaseTableReader {
         cur_data_ += chunk_size;
         cur_size_ -= chunk_size;
         cur_block_index_++;
+      } else if (block_sizer_) {
+        // Need to fetch more data to get at least one row
+        const int64_t start = BlockSizer::NowNanos();
+        RETURN_NOT_OK(ReadNextBlock());
+        block_sizer_->AddReadTime(BlockSizer::NowNanos() - start);
       } else {
         // Need to fetch more data to get at least one row
         RETURN_NOT_OK(ReadNextBlock());
       }
     }
 
+    if (dataset_) {
+      // The remaining data is at most a line without a line separator: parse
+      // it here and convert it in a task too, so that the next file starts
+      // without waiting for this one's conversion tasks
+      if (eof_ && cur_size_ > 0) {
+        auto parser = std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_,
+                                                    max_num_rows);
+        int64_t parsed_size = 0;
+        RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(cur_data_),
+                                         cur_size_,
+                                         &parsed_size));
+        if (parser->num_rows() > 0) {
+          RETURN_NOT_OK(ProcessData(parser, cur_block_index_++));
+        }
+      }
+      FinishInput();
+      return arrow::Status::OK();
+    }
+
     // Finish all pending parallel tasks
     RETURN_NOT_OK(task_group_->Finish());
 
@@ -473,55 +1568,265 @@ class ThreadedTableReader : public BaseTableReader {
         builder->SetTaskGroup(task_group_);
       }
       auto parser =
-          std::make_shared<BlockParser>(pool_, parse_options_, num_cols_, max_num_rows);
-      uint32_t parsed_size = 0;
+          std::make_shared<BlockParser>(parse_pool_, parse_options_, num_cols_, max_num_rows);
+      int64_t parsed_size = 0;
       RETURN_NOT_OK(parser->ParseFinal(reinterpret_cast<const char*>(cur_data_),
-                                       static_cast<uint32_t>(cur_size_), &parsed_size));
+                                       cur_size_, &parsed_size));
       if (parser->num_rows() > 0) {
         RETURN_NOT_OK(ProcessData(parser, cur_block_index_++));
       }
       RETURN_NOT_OK(task_group_->Finish());
     }
 
-    // Clean up ICU
-    ucnv_close(ucnv_);
-    u_cleanup();
-
-    // Create schema and table
-    return MakeTable(out);
+    FinishInput();
+    return arrow::Status::OK();
   }
-
- protected:
-  arrow::internal::ThreadPool* thread_pool_;
 };
 
 /////////////////////////////////////////////////////////////
 // TableReader factory function
 
+// The thread pool a read runs on, null if serial
+static arrow::internal::ThreadPool* GetThreadPool(const ReadOptions& read_options) {
+    if (!read_options.use_threads) {
+        return nullptr;
+    }
+    return read_options.thread_pool ? read_options.thread_pool
+                                    : arrow::internal::GetCpuThreadPool();
+}
+
+static ReadPools MakeReadPools(arrow::MemoryPool* pool, const ReadOptions& read_options) {
+    ReadPools pools;
+    arrow::MemoryPool* block_pool = pool;
+    if (read_options.max_recycled_bytes > 0) {
+        pools.buffer_pool = BufferPool::Make(pool, read_options.max_recycled_bytes);
+        block_pool = pools.buffer_pool.get();
+    }
+    if (GetThreadPool(read_options) && read_options.max_memory_bytes > 0) {
+        pools.budget = MemoryBudget::Make(block_pool, read_options.max_memory_bytes);
+        block_pool = pools.budget.get();
+    }
+    pools.readahead = StagePool::Make(block_pool);
+    pools.parse = StagePool::Make(block_pool);
+    pools.convert = StagePool::Make(pool);
+    pools.output = StagePool::Make(pool);
+    return pools;
+}
+
+// The pools are made unless given (shared by the files of a dataset)
+static arrow::Status MakeBaseTableReader(arrow::MemoryPool* pool,
+                                         std::shared_ptr<arrow::io::InputStream> input,
+                                         const ReadOptions& read_options,
+                                         const ParseOptions& parse_options,
+                                         const ConvertOptions& convert_options,
+                                         const ReadPools* shared_pools,
+                                         std::shared_ptr<BaseTableReader>* out) {
+    arrow::internal::ThreadPool* thread_pool = GetThreadPool(read_options);
+    ReadPools pools = shared_pools ? *shared_pools : MakeReadPools(pool, read_options);
+    // The size of the rest of a file, unless compressed
+    int64_t input_size = -1;
+    auto file = std::dynamic_pointer_cast<arrow::io::RandomAccessFile>(input);
+    int64_t file_size, position;
+    if (file && file->GetSize(&file_size).ok() && file->Tell(&position).ok()) {
+        input_size = file_size - position;
+    }
+    if (read_options.decompress) {
+        RETURN_NOT_OK(MakeDecompressingStream(pools.readahead.get(), thread_pool,
+                                              read_options.max_parallelism, input,
+                                              &input));
+        if (IsDecompressing(*input)) {
+            input_size = -1;
+        }
+    }
+    if (thread_pool) {
+        *out = std::make_shared<ThreadedTableReader>(input,
+                                                     input_size,
+                                                     thread_pool,
+                                                     pools,
+                                                     read_options,
+                                                     parse_options,
+                                                     convert_options);
+    } else {
+        *out = std::make_shared<SerialTableReader>(input,
+                                                   pools,
+                                                   read_options,
+                                                   parse_options,
+                                                   convert_options);
+    }
+    return arrow::Status::OK();
+}
+
 arrow::Status TableReader::Make(arrow::MemoryPool* pool,
                                 std::shared_ptr<arrow::io::InputStream> input,
                                 const ReadOptions& read_options,
                                 const ParseOptions& parse_options,
                                 const ConvertOptions& convert_options,
                                 std::shared_ptr<TableReader>* out) {
-    std::shared_ptr<TableReader> result;
-    if (read_options.use_threads) {
-        result =
-            std::make_shared<ThreadedTableReader>(pool, input, 
-                                                  arrow::internal::GetCpuThreadPool(),
-                                                  read_options,
-                                                  parse_options, 
-                                                  convert_options);
-        *out = result;
-        return arrow::Status::OK();
-    } else {
-        result = std::make_shared<SerialTableReader>(pool, input,
-                                                     read_options,
-                                                     parse_options, 
-                                                     convert_options);
-        *out = result;
-        return arrow::Status::OK();
+    std::shared_ptr<BaseTableReader> result;
+    RETURN_NOT_OK(MakeBaseTableReader(pool, input, read_options, parse_options,
+                                      convert_options, nullptr, &result));
+    *out = result;
+    return arrow::Status::OK();
+}
+
+/////////////////////////////////////////////////////////////////////////
+// DatasetReader implementation
+
+class DatasetReaderImpl : public DatasetReader {
+ public:
+  DatasetReaderImpl(arrow::MemoryPool* pool, const std::vector<std::string>& paths,
+                    const ReadOptions& read_options,
+                    const ParseOptions& parse_options,
+                    const ConvertOptions& convert_options)
+      : pool_(pool),
+        paths_(paths),
+        read_options_(read_options),
+        parse_options_(parse_options),
+        convert_options_(convert_options) {}
+
+  ~DatasetReaderImpl() {
+    if (task_group_) {
+      // In case of error, make sure all pending tasks are finished before
+      // the file readers they use are destroyed
+      ARROW_UNUSED(task_group_->Finish());
     }
+  }
+
+  arrow::Status Read(std::shared_ptr<arrow::Table>* out) override {
+    RETURN_NOT_OK(ReadInputs());
+    std::vector<std::shared_ptr<arrow::Table>> tables;
+    RETURN_NOT_OK(MakeTables(0, static_cast<int64_t>(paths_.size()), &tables));
+    *out = tables[0];
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ReadPerFile(std::vector<std::shared_ptr<arrow::Table>>* out) override {
+    RETURN_NOT_OK(ReadInputs());
+    out->clear();
+    for (int64_t i = 0; i < static_cast<int64_t>(paths_.size()); ++i) {
+      RETURN_NOT_OK(MakeTables(i, i + 1, out));
+    }
+    return arrow::Status::OK();
+  }
+
+  ReadMemoryStats memory_stats() const override { return GetMemoryStats(pools_); }
+
+ protected:
+  arrow::Status OpenFile(size_t index, std::shared_ptr<BaseTableReader>* out) {
+    std::shared_ptr<arrow::io::ReadableFile> file;
+    RETURN_NOT_OK(arrow::io::ReadableFile::Open(paths_[index], pool_, &file));
+    return MakeBaseTableReader(pool_, file, read_options_, parse_options_,
+                               convert_options_, &pools_, out);
+  }
+
+  // Read every file in turn into the shared column builders
+  arrow::Status ReadInputs() {
+    if (paths_.empty()) {
+      return arrow::Status::Invalid("No files in dataset");
+    }
+    arrow::internal::ThreadPool* thread_pool = GetThreadPool(read_options_);
+    task_group_ =
+        MakeTaskGroup(thread_pool, read_options_.max_parallelism, read_options_.priority);
+    // One set of pools for all the files, as they share the task group and
+    // column builders
+    pools_ = MakeReadPools(pool_, read_options_);
+    if (pools_.budget) {
+      task_group_ = pools_.budget->WrapTaskGroup(task_group_);
+    }
+
+    std::shared_ptr<BaseTableReader> next_reader;
+    RETURN_NOT_OK(WrapError(0, OpenFile(0, &next_reader)));
+    int64_t block_index = 0;
+    for (size_t i = 0; i < paths_.size() && task_group_->ok(); ++i) {
+      // File readers are kept alive until the conversion tasks are done
+      readers_.push_back(next_reader);
+      if (i + 1 < paths_.size()) {
+        // Open the next file now, so that it reads ahead in the background
+        RETURN_NOT_OK(WrapError(i + 1, OpenFile(i + 1, &next_reader)));
+      }
+      RETURN_NOT_OK(WrapError(i, readers_[i]->ReadDatasetFile(
+                                     task_group_, &column_names_, &column_builders_,
+                                     &block_index)));
+      block_ends_.push_back(block_index);
+    }
+    RETURN_NOT_OK(task_group_->Finish());
+    readers_.clear();
+
+    // Clean up ICU
+    u_cleanup();
+    return arrow::Status::OK();
+  }
+
+  arrow::Status WrapError(size_t index, const arrow::Status& status) {
+    if (status.ok()) {
+      return status;
+    }
+    return arrow::Status(status.code(), "In file '" + paths_[index] + "': " +
+                                            status.message());
+  }
+
+  // Make the table of the files in [begin, end)
+  arrow::Status MakeTables(int64_t begin, int64_t end,
+                           std::vector<std::shared_ptr<arrow::Table>>* out) {
+    if (columns_.empty()) {
+      for (const auto& builder : column_builders_) {
+        std::shared_ptr<arrow::ChunkedArray> array;
+        RETURN_NOT_OK(builder->Finish(&array));
+        columns_.push_back(array);
+      }
+    }
+
+    // Each file's chunks are a range of the block indices
+    const int64_t first_block = begin == 0 ? 0 : block_ends_[begin - 1];
+    const int64_t end_block = block_ends_[end - 1];
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::Column>> columns;
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const arrow::ArrayVector& chunks = columns_[i]->chunks();
+      arrow::ArrayVector file_chunks(chunks.begin() + first_block,
+                                     chunks.begin() + end_block);
+      auto array = std::make_shared<arrow::ChunkedArray>(file_chunks, columns_[i]->type());
+      columns.push_back(std::make_shared<arrow::Column>(column_names_[i], array));
+      fields.push_back(columns.back()->field());
+    }
+    if (read_options_.output_chunk_rows > 0) {
+      // Chunks are only gathered within the tables asked for
+      auto task_group = MakeTaskGroup(GetThreadPool(read_options_),
+                                      read_options_.max_parallelism,
+                                      read_options_.priority);
+      RETURN_NOT_OK(CoalesceColumns(read_options_.output_chunk_rows,
+                                    pools_.output.get(), task_group, &columns));
+    }
+    out->push_back(arrow::Table::Make(schema(fields), columns));
+    return arrow::Status::OK();
+  }
+
+  arrow::MemoryPool* pool_;
+  std::vector<std::string> paths_;
+  ReadOptions read_options_;
+  ParseOptions parse_options_;
+  ConvertOptions convert_options_;
+
+  // Pools of all files
+  ReadPools pools_;
+  std::shared_ptr<arrow::internal::TaskGroup> task_group_;
+  std::vector<std::shared_ptr<BaseTableReader>> readers_;
+  std::vector<std::string> column_names_;
+  std::vector<std::shared_ptr<ColumnBuilder>> column_builders_;
+  // End block index of each file
+  std::vector<int64_t> block_ends_;
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> columns_;
+};
+
+arrow::Status DatasetReader::Make(arrow::MemoryPool* pool,
+                                  const std::vector<std::string>& paths,
+                                  const ReadOptions& read_options,
+                                  const ParseOptions& parse_options,
+                                  const ConvertOptions& convert_options,
+                                  std::shared_ptr<DatasetReader>* out) {
+  *out = std::make_shared<DatasetReaderImpl>(pool, paths, read_options, parse_options,
+                                             convert_options);
+  return arrow::Status::OK();
 }
 
 }  // namespace fwfr
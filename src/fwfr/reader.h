@@ -25,25 +25,42 @@
 #ifndef FWFR_READER_H
 #define FWFR_READER_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <fwfr/block-sizer.h>
+#include <fwfr/buffer-pool.h>
 #include <fwfr/chunker.h>
 #include <fwfr/column-builder.h>
+#include <fwfr/decompress.h>
+#include <fwfr/lazy-table.h>
+#include <fwfr/memory-budget.h>
 #include <fwfr/options.h>
 #include <fwfr/parser.h>
+#include <fwfr/record-framer.h>
+#include <fwfr/row-filter.h>
+#include <fwfr/scheduler.h>
+#include <fwfr/stage-pool.h>
 
+#include <arrow/array.h>
 #include <arrow/buffer.h>
+#include <arrow/io/file.h>
 #include <arrow/io/readahead.h>
+#include <arrow/record_batch.h>
 #include <arrow/status.h>
 #include <arrow/table.h>
 #include <arrow/type.h>
@@ -58,6 +75,7 @@
 
 namespace arrow {
     class MemoryPool;
+    class RecordBatchReader;
     class Table;
 
     namespace io {
@@ -67,11 +85,60 @@ namespace arrow {
 
 namespace fwfr {
 
+/// \brief Memory held through the pool of one stage of a read
+struct ARROW_EXPORT StageMemoryStats {
+  // Bytes held now
+  int64_t bytes_allocated = 0;
+  // Peak of bytes_allocated
+  int64_t max_memory = 0;
+};
+
+/// \brief Memory of a read, by stage
+///
+/// Each stage allocates from the read's pool through a pool of its own:
+/// readahead the input blocks (and decompressed frames), parse the parsed
+/// values of each block (including those kept for lazy reads and type
+/// inference), convert the arrays of the table or batches, and output the
+/// other buffers of the table (e.g. the last raw record).  The budget of a
+/// threaded read with ReadOptions::max_memory_bytes holds the readahead and
+/// parse stages (nothing without a budget), and recycled the freed buffers
+/// kept for reuse under ReadOptions::max_recycled_bytes.
+struct ARROW_EXPORT ReadMemoryStats {
+  StageMemoryStats readahead;
+  StageMemoryStats parse;
+  StageMemoryStats convert;
+  StageMemoryStats output;
+  StageMemoryStats budget;
+  StageMemoryStats recycled;
+  // Bytes of the allocations served from recycled buffers
+  int64_t reused_bytes = 0;
+};
+
 class ARROW_EXPORT TableReader {
  public:
   virtual ~TableReader() = default;
 
   virtual arrow::Status Read(std::shared_ptr<arrow::Table>* out) = 0;
+
+  /// Parse the whole input, deferring conversion of each column until it
+  /// is first accessed through the returned LazyTable
+  virtual arrow::Status ReadLazy(std::shared_ptr<LazyTable>* out) = 0;
+
+  /// Read a file mixing the record types of ParseOptions::layouts, into
+  /// one table per type code
+  virtual arrow::Status ReadLayouts(
+      std::unordered_map<std::string, std::shared_ptr<arrow::Table>>* out) = 0;
+
+  /// Read the input as a stream of record batches, one per block, in order.
+  /// Blocks are parsed and converted ahead of the consumer on the thread
+  /// pool, a bounded number at a time, so that memory use does not grow
+  /// with the input.  Columns without a declared type get the type inferred
+  /// from the first block (string if it only holds nulls), and later blocks
+  /// must convert to it.
+  virtual arrow::Status ReadStream(std::shared_ptr<arrow::RecordBatchReader>* out) = 0;
+
+  /// Return the memory held by each stage of the read so far, and its peak
+  virtual ReadMemoryStats memory_stats() const = 0;
     
   static int add(int a, int b);
 
@@ -83,6 +150,37 @@ class ARROW_EXPORT TableReader {
                             std::shared_ptr<TableReader>* out);
 };
 
+/// \brief Read many files of the same layout as one dataset
+///
+/// All files share one task group and one set of column builders, so types
+/// are inferred over the whole dataset, and the next file is read ahead and
+/// chunked while the previous one's last blocks convert, keeping every
+/// worker busy across file boundaries.  Each file has its own header (or
+/// none, if ReadOptions::column_names is set), and all must have the same
+/// column names.  Raw records and records with descriptor words are not
+/// supported.
+class ARROW_EXPORT DatasetReader {
+ public:
+  virtual ~DatasetReader() = default;
+
+  /// Read all files into one table, in order
+  virtual arrow::Status Read(std::shared_ptr<arrow::Table>* out) = 0;
+
+  /// Read all files into one table each, with the same schema
+  virtual arrow::Status ReadPerFile(std::vector<std::shared_ptr<arrow::Table>>* out) = 0;
+
+  /// Return the memory held by each stage of the read of all files so far,
+  /// and its peak
+  virtual ReadMemoryStats memory_stats() const = 0;
+
+  static arrow::Status Make(arrow::MemoryPool* pool,
+                            const std::vector<std::string>& paths,
+                            const ReadOptions&,
+                            const ParseOptions&,
+                            const ConvertOptions&,
+                            std::shared_ptr<DatasetReader>* out);
+};
+
 }  // namespace fwfr
 
 #endif  // FWFR_READER_H
@@ -0,0 +1,115 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/record-framer.h>
+
+namespace fwfr {
+
+// Descriptor words are 4 bytes, starting with a big-endian length
+static constexpr uint32_t kDescriptorSize = 4;
+
+RecordFramer::RecordFramer(ParseOptions options)
+    : options_(options) {}
+
+arrow::Status RecordFramer::ReadRecordDescriptor(const uint8_t* data,
+                                                 uint32_t* length) const {
+  *length = (static_cast<uint32_t>(data[0]) << 8) | data[1];
+  if (ARROW_PREDICT_FALSE(data[2] != 0 || data[3] != 0)) {
+    // Segment flags of spanned records (RECFM=VS / VBS)
+    return arrow::Status::NotImplemented("Spanned records with descriptor words");
+  }
+  if (ARROW_PREDICT_FALSE(*length < kDescriptorSize)) {
+    return arrow::Status::Invalid("Invalid record descriptor word, with length ",
+                                  *length);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RecordFramer::ReadBlockDescriptor(const uint8_t* data,
+                                                uint32_t* length) const {
+  if (data[0] & 0x80) {
+    // Extended block descriptor, with a 31-bit length
+    *length = (static_cast<uint32_t>(data[0] & 0x7F) << 24) |
+              (static_cast<uint32_t>(data[1]) << 16) |
+              (static_cast<uint32_t>(data[2]) << 8) | data[3];
+  } else {
+    *length = (static_cast<uint32_t>(data[0]) << 8) | data[1];
+    if (ARROW_PREDICT_FALSE(data[2] != 0 || data[3] != 0)) {
+      return arrow::Status::Invalid("Invalid block descriptor word");
+    }
+  }
+  if (ARROW_PREDICT_FALSE(*length < kDescriptorSize)) {
+    return arrow::Status::Invalid("Invalid block descriptor word, with length ",
+                                  *length);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RecordFramer::Process(const uint8_t* data, int64_t size,
+                                    int64_t* out_size) const {
+  // Hop from descriptor to descriptor: with block descriptors, records are
+  // left for IndexRecords() to find
+  const bool is_blocked = (options_.record_format == ParseOptions::BDW);
+  int64_t pos = 0;
+  while (size - pos >= kDescriptorSize) {
+    uint32_t length;
+    if (is_blocked) {
+      RETURN_NOT_OK(ReadBlockDescriptor(data + pos, &length));
+    } else {
+      RETURN_NOT_OK(ReadRecordDescriptor(data + pos, &length));
+    }
+    if (length > size - pos) {
+      // Truncated
+      break;
+    }
+    pos += length;
+  }
+  *out_size = pos;
+  return arrow::Status::OK();
+}
+
+arrow::Status RecordFramer::IndexRecords(const uint8_t* data, int64_t size,
+                                         std::vector<RecordSpan>* out) const {
+  out->clear();
+  // Append the records between pos and end
+  auto index_records = [&](int64_t pos, int64_t end) -> arrow::Status {
+    while (pos < end) {
+      uint32_t length;
+      if (ARROW_PREDICT_FALSE(end - pos < kDescriptorSize)) {
+        return arrow::Status::Invalid("Truncated record descriptor word");
+      }
+      RETURN_NOT_OK(ReadRecordDescriptor(data + pos, &length));
+      if (ARROW_PREDICT_FALSE(length > end - pos)) {
+        return arrow::Status::Invalid("Record of ", length, " bytes overruns its ",
+                                      options_.record_format == ParseOptions::BDW
+                                          ? "block"
+                                          : "data");
+      }
+      out->push_back({pos + kDescriptorSize, length - kDescriptorSize});
+      pos += length;
+    }
+    return arrow::Status::OK();
+  };
+
+  if (options_.record_format != ParseOptions::BDW) {
+    return index_records(0, size);
+  }
+  int64_t pos = 0;
+  while (pos < size) {
+    uint32_t length;
+    RETURN_NOT_OK(ReadBlockDescriptor(data + pos, &length));
+    RETURN_NOT_OK(index_records(pos + kDescriptorSize, pos + length));
+    pos += length;
+  }
+  return arrow::Status::OK();
+}
+
+}  // namespace fwfr
@@ -0,0 +1,68 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_RECORD_FRAMER_H
+#define FWFR_RECORD_FRAMER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <fwfr/options.h>
+
+#include <arrow/status.h>
+#include <arrow/util/macros.h>
+#include <arrow/util/visibility.h>
+
+namespace fwfr {
+
+/// \brief The data of one record within a chunk, without its descriptor word
+struct RecordSpan {
+  int64_t offset;
+  uint32_t size;
+};
+
+/// \class RecordFramer
+/// \brief A block-based chunker for records with descriptor words
+///
+/// The counterpart of Chunker for ParseOptions::RDW and BDW record formats.
+/// Process() cuts a block of data after its last whole record (or whole
+/// block of records, with block descriptors), reading descriptor words
+/// only.  If the block is truncated, it is up to the caller to arrange the
+/// next block to start with the trailing data.
+///
+/// IndexRecords() then finds each record of a chunk, so that chunks can be
+/// indexed and parsed in parallel.
+class ARROW_EXPORT RecordFramer {
+ public:
+  explicit RecordFramer(ParseOptions options);
+
+  /// \brief Carve up a chunk of whole records in a block of data
+  ///
+  /// The number of bytes in the chunk is returned in out_size.
+  arrow::Status Process(const uint8_t* data, int64_t size, int64_t* out_size) const;
+
+  /// \brief Find the records in a chunk returned by Process()
+  arrow::Status IndexRecords(const uint8_t* data, int64_t size,
+                             std::vector<RecordSpan>* out) const;
+
+ protected:
+  ARROW_DISALLOW_COPY_AND_ASSIGN(RecordFramer);
+
+  // Read the length of a record or block (including its descriptor word)
+  arrow::Status ReadRecordDescriptor(const uint8_t* data, uint32_t* length) const;
+  arrow::Status ReadBlockDescriptor(const uint8_t* data, uint32_t* length) const;
+
+  ParseOptions options_;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_RECORD_FRAMER_H
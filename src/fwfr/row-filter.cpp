@@ -0,0 +1,76 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/row-filter.h>
+
+#include <cstring>
+#include <vector>
+
+#include <fwfr/numeric-parsing.h>
+#include <fwfr/parser.h>
+#include <fwfr/whitespace.h>
+
+#include <arrow/type.h>
+
+namespace fwfr {
+
+RowFilter::RowFilter(const Predicate& predicate, int32_t col_index)
+    : predicate_(predicate), col_index_(col_index) {
+  if (predicate_.kind == Predicate::EQUAL || predicate_.kind == Predicate::IN) {
+    matcher_ = ValueMatcher(predicate_.values);
+  }
+}
+
+arrow::Status RowFilter::Apply(BlockParser* parser) const {
+  std::vector<uint8_t> keep;
+  keep.reserve(parser->num_rows());
+
+  switch (predicate_.kind) {
+    case Predicate::EQUAL:
+    case Predicate::IN: {
+      auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
+        TrimWhitespace(&data, &size);
+        keep.push_back(matcher_.Find(data, size));
+        return arrow::Status::OK();
+      };
+      RETURN_NOT_OK(parser->VisitColumn(col_index_, visit));
+      break;
+    }
+    case Predicate::PREFIX: {
+      const std::string& prefix = predicate_.values.empty() ? "" : predicate_.values[0];
+      auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
+        TrimWhitespace(&data, &size);
+        keep.push_back(size >= prefix.size() &&
+                       std::memcmp(data, prefix.data(), prefix.size()) == 0);
+        return arrow::Status::OK();
+      };
+      RETURN_NOT_OK(parser->VisitColumn(col_index_, visit));
+      break;
+    }
+    case Predicate::RANGE: {
+      // Fields which are not numbers (e.g. nulls) are out of range
+      FixedWidthParser<arrow::DoubleType> convert(parser->column_width(col_index_), 0);
+      auto visit = [&](const uint8_t* data, uint32_t size) -> arrow::Status {
+        TrimWhitespace(&data, &size);
+        double value;
+        keep.push_back(convert(reinterpret_cast<const char*>(data), size, &value) &&
+                       value >= predicate_.min && value <= predicate_.max);
+        return arrow::Status::OK();
+      };
+      RETURN_NOT_OK(parser->VisitColumn(col_index_, visit));
+      break;
+    }
+  }
+  parser->SelectRows(keep);
+  return arrow::Status::OK();
+}
+
+}  // namespace fwfr
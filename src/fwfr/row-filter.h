@@ -0,0 +1,51 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_ROW_FILTER_H
+#define FWFR_ROW_FILTER_H
+
+#include <cstdint>
+#include <string>
+
+#include <fwfr/options.h>
+#include <fwfr/value-matcher.h>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace fwfr {
+
+class BlockParser;
+
+/// \class RowFilter
+/// \brief A Predicate bound to a parsed column
+///
+/// Filters test the raw field bytes, so rejected rows are dropped from the
+/// parser's selection before any conversion happens.
+class ARROW_EXPORT RowFilter {
+ public:
+  RowFilter(const Predicate& predicate, int32_t col_index);
+
+  /// \brief Narrow the parser's selected rows to those passing the predicate
+  arrow::Status Apply(BlockParser* parser) const;
+
+  int32_t col_index() const { return col_index_; }
+
+ protected:
+  Predicate predicate_;
+  int32_t col_index_;
+  // Spellings for EQUAL and IN
+  ValueMatcher matcher_;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_ROW_FILTER_H
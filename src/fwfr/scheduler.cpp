@@ -0,0 +1,239 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/scheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+
+#include <arrow/util/logging.h>
+#include <arrow/util/macros.h>
+#include <arrow/util/task-group.h>
+#include <arrow/util/thread-pool.h>
+
+namespace fwfr {
+
+/////////////////////////////////////////////////////////////////////////
+// Task group of a read
+
+// The group's tasks are queued in its scheduler, which runs them.  As in
+// Arrow's threaded task group, tasks are dropped once one has failed.
+class ScheduledTaskGroup : public arrow::internal::TaskGroup {
+ public:
+  ScheduledTaskGroup(Scheduler* scheduler, ReadOptions::Priority priority,
+                     int32_t max_parallelism)
+      : scheduler_(scheduler), priority_(priority), max_parallelism_(max_parallelism) {}
+
+  ~ScheduledTaskGroup() override {
+    // Make sure no worker uses the group after it is destroyed
+    ARROW_UNUSED(Finish());
+    std::lock_guard<std::mutex> lock(scheduler_->mutex_);
+    scheduler_->groups_.erase(this);
+  }
+
+  arrow::Status current_status() override {
+    std::lock_guard<std::mutex> lock(scheduler_->mutex_);
+    return status_;
+  }
+
+  bool ok() override { return ok_.load(); }
+
+  arrow::Status Finish() override { return scheduler_->Finish(this); }
+
+  int parallelism() override { return max_parallelism_; }
+
+ protected:
+  friend class Scheduler;
+
+  void AppendReal(std::function<arrow::Status()> task) override {
+    scheduler_->Append(this, std::move(task));
+  }
+
+  Scheduler* scheduler_;
+  const ReadOptions::Priority priority_;
+  const int32_t max_parallelism_;
+  std::atomic<bool> ok_{true};
+
+  // Guarded by the scheduler's mutex
+  int64_t id_ = 0;
+  std::deque<std::function<arrow::Status()>> pending_;
+  int32_t num_running_ = 0;
+  int64_t num_run_ = 0;
+  // Whether the group is in its priority's queue
+  bool active_ = false;
+  arrow::Status status_;
+  bool finished_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// Scheduler
+
+Scheduler* Scheduler::Get(arrow::internal::ThreadPool* thread_pool) {
+  // Never destroyed, as workers may outlive static destruction
+  static std::mutex* mutex = new std::mutex();
+  static auto* schedulers =
+      new std::unordered_map<arrow::internal::ThreadPool*, std::unique_ptr<Scheduler>>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto& scheduler = (*schedulers)[thread_pool];
+  if (!scheduler) {
+    scheduler.reset(new Scheduler(thread_pool));
+  }
+  return scheduler.get();
+}
+
+std::shared_ptr<arrow::internal::TaskGroup> Scheduler::MakeTaskGroup(
+    ReadOptions::Priority priority, int32_t max_parallelism) {
+  auto group = std::make_shared<ScheduledTaskGroup>(
+      this, priority, GetParallelism(thread_pool_, max_parallelism));
+  std::lock_guard<std::mutex> lock(mutex_);
+  group->id_ = next_id_++;
+  groups_.insert(group.get());
+  return group;
+}
+
+std::vector<ReadQueueStats> Scheduler::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ReadQueueStats> stats;
+  for (const auto group : groups_) {
+    if (!group->pending_.empty() || group->num_running_ > 0) {
+      stats.push_back({group->id_, group->priority_,
+                       static_cast<int64_t>(group->pending_.size()), group->num_running_,
+                       group->max_parallelism_, group->num_run_});
+    }
+  }
+  return stats;
+}
+
+void Scheduler::Append(ScheduledTaskGroup* group, std::function<arrow::Status()> task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DCHECK(!group->finished_);
+  if (!group->ok_.load()) {
+    return;
+  }
+  group->pending_.push_back(std::move(task));
+  if (!group->active_) {
+    group->active_ = true;
+    queues_[group->priority_].push_back(group);
+  }
+  if (num_workers_ < thread_pool_->GetCapacity()) {
+    ++num_workers_;
+    arrow::Status status = thread_pool_->Spawn([this]() { RunTasks(); });
+    if (!status.ok()) {
+      --num_workers_;
+      if (group->ok_.load()) {
+        group->status_ = status;
+        group->ok_.store(false);
+      }
+      Deactivate(group);
+    }
+  }
+}
+
+arrow::Status Scheduler::Finish(ScheduledTaskGroup* group) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!group->finished_) {
+    cv_.wait(lock, [&] { return group->pending_.empty() && group->num_running_ == 0; });
+    group->finished_ = true;
+  }
+  return group->status_;
+}
+
+void Scheduler::RunTasks() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ScheduledTaskGroup* group;
+  std::function<arrow::Status()> task;
+  while (PickTask(&group, &task)) {
+    lock.unlock();
+    arrow::Status status = task();
+    // Release what the task holds outside of the lock
+    task = nullptr;
+    lock.lock();
+    --group->num_running_;
+    if (!status.ok() && group->ok_.load()) {
+      group->status_ = status;
+      group->ok_.store(false);
+      Deactivate(group);
+    }
+    if (group->pending_.empty() && group->num_running_ == 0) {
+      cv_.notify_all();
+    }
+  }
+  --num_workers_;
+}
+
+bool Scheduler::PickTask(ScheduledTaskGroup** group,
+                         std::function<arrow::Status()>* task) {
+  // Highest priority first, then the read whose turn it is, unless it
+  // already runs all the tasks it may
+  for (auto& queue : queues_) {
+    for (size_t n = queue.size(); n > 0; --n) {
+      ScheduledTaskGroup* candidate = queue.front();
+      queue.pop_front();
+      if (candidate->num_running_ >= candidate->max_parallelism_) {
+        queue.push_back(candidate);
+        continue;
+      }
+      *task = std::move(candidate->pending_.front());
+      candidate->pending_.pop_front();
+      ++candidate->num_running_;
+      ++candidate->num_run_;
+      if (candidate->pending_.empty()) {
+        candidate->active_ = false;
+      } else {
+        // Back of the line
+        queue.push_back(candidate);
+      }
+      *group = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Drop the group's pending tasks, after an error
+void Scheduler::Deactivate(ScheduledTaskGroup* group) {
+  group->pending_.clear();
+  if (group->active_) {
+    auto& queue = queues_[group->priority_];
+    queue.erase(std::find(queue.begin(), queue.end(), group));
+    group->active_ = false;
+  }
+  cv_.notify_all();
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Helpers
+
+int32_t GetParallelism(arrow::internal::ThreadPool* thread_pool,
+                       int32_t max_parallelism) {
+  if (thread_pool == nullptr) {
+    return 1;
+  }
+  const int32_t capacity = thread_pool->GetCapacity();
+  return max_parallelism > 0 ? std::min(max_parallelism, capacity) : capacity;
+}
+
+std::shared_ptr<arrow::internal::TaskGroup> MakeTaskGroup(
+    arrow::internal::ThreadPool* thread_pool, int32_t max_parallelism,
+    ReadOptions::Priority priority) {
+  if (thread_pool == nullptr) {
+    return arrow::internal::TaskGroup::MakeSerial();
+  }
+  return Scheduler::Get(thread_pool)->MakeTaskGroup(priority, max_parallelism);
+}
+
+std::vector<ReadQueueStats> GetSchedulerStats() {
+  return Scheduler::Get(arrow::internal::GetCpuThreadPool())->GetStats();
+}
+
+}  // namespace fwfr
@@ -0,0 +1,118 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_SCHEDULER_H
+#define FWFR_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <fwfr/options.h>
+
+#include <arrow/status.h>
+#include <arrow/util/visibility.h>
+
+namespace arrow {
+    namespace internal {
+        class TaskGroup;
+        class ThreadPool;
+    }
+}
+
+namespace fwfr {
+
+class ScheduledTaskGroup;
+
+/// \brief Load of one read's task group
+struct ARROW_EXPORT ReadQueueStats {
+  // Identifies the read across calls, in the order reads were made
+  int64_t id;
+  ReadOptions::Priority priority;
+  // Tasks waiting to run
+  int64_t queued;
+  // Tasks running
+  int32_t running;
+  // Maximum number of tasks run at once
+  int32_t max_parallelism;
+  // Tasks started so far
+  int64_t tasks_run;
+};
+
+/// \class Scheduler
+/// \brief Runs the tasks of concurrent reads on a thread pool, fairly
+///
+/// Reads queue their tasks here rather than in the thread pool, and up to
+/// the pool's capacity of workers run them: tasks of higher priority reads
+/// always go first, and reads of the same priority take turns, one task
+/// each, so a small read never waits behind all the blocks of a large one.
+/// Each read also runs at most max_parallelism tasks at once.
+class ARROW_EXPORT Scheduler {
+ public:
+  explicit Scheduler(arrow::internal::ThreadPool* thread_pool)
+      : thread_pool_(thread_pool) {}
+
+  /// \brief Return the scheduler of a thread pool, made on first use
+  static Scheduler* Get(arrow::internal::ThreadPool* thread_pool);
+
+  /// \brief Make the task group of a read, running at most max_parallelism
+  /// tasks at once (if positive)
+  std::shared_ptr<arrow::internal::TaskGroup> MakeTaskGroup(
+      ReadOptions::Priority priority, int32_t max_parallelism);
+
+  /// \brief Return the load of every read with tasks queued or running
+  std::vector<ReadQueueStats> GetStats();
+
+ protected:
+  friend class ScheduledTaskGroup;
+
+  void Append(ScheduledTaskGroup* group, std::function<arrow::Status()> task);
+  arrow::Status Finish(ScheduledTaskGroup* group);
+  void RunTasks();
+  // Take the next task to run, if any
+  bool PickTask(ScheduledTaskGroup** group, std::function<arrow::Status()>* task);
+  void Deactivate(ScheduledTaskGroup* group);
+
+  arrow::internal::ThreadPool* thread_pool_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // Reads with runnable tasks, by priority, in turn order
+  std::deque<ScheduledTaskGroup*> queues_[ReadOptions::LOW + 1];
+  std::unordered_set<ScheduledTaskGroup*> groups_;
+  int32_t num_workers_ = 0;
+  int64_t next_id_ = 0;
+};
+
+/// \brief Return how many tasks a read may run at once on thread_pool:
+/// its capacity, capped by max_parallelism if positive (1 if thread_pool
+/// is null)
+ARROW_EXPORT int32_t GetParallelism(arrow::internal::ThreadPool* thread_pool,
+                                    int32_t max_parallelism);
+
+/// \brief Make the task group of a read, running its tasks through the
+/// scheduler of thread_pool, or serially if thread_pool is null
+ARROW_EXPORT std::shared_ptr<arrow::internal::TaskGroup> MakeTaskGroup(
+    arrow::internal::ThreadPool* thread_pool, int32_t max_parallelism,
+    ReadOptions::Priority priority = ReadOptions::NORMAL);
+
+/// \brief Return the load of every read with tasks queued or running on
+/// Arrow's CPU thread pool, the default for threaded reads
+ARROW_EXPORT std::vector<ReadQueueStats> GetSchedulerStats();
+
+}  // namespace fwfr
+
+#endif  // FWFR_SCHEDULER_H
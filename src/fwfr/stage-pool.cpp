@@ -0,0 +1,20 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/stage-pool.h>
+
+namespace fwfr {
+
+std::shared_ptr<StagePool> StagePool::Make(arrow::MemoryPool* pool) {
+  return Adopt(new StagePool(pool));
+}
+
+}  // namespace fwfr
@@ -0,0 +1,37 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_STAGE_POOL_H
+#define FWFR_STAGE_POOL_H
+
+#include <memory>
+
+#include <arrow/memory_pool.h>
+#include <arrow/util/visibility.h>
+
+#include <fwfr/counting-pool.h>
+
+namespace fwfr {
+
+/// \class StagePool
+/// \brief Memory pool counting the bytes held by one stage of a read
+class ARROW_EXPORT StagePool : public CountingPool {
+ public:
+  /// \brief Make a pool over pool
+  static std::shared_ptr<StagePool> Make(arrow::MemoryPool* pool);
+
+ protected:
+  explicit StagePool(arrow::MemoryPool* pool) : CountingPool(pool) {}
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_STAGE_POOL_H
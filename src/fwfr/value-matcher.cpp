@@ -0,0 +1,46 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#include <fwfr/value-matcher.h>
+
+#include <algorithm>
+
+namespace fwfr {
+
+ValueMatcher::ValueMatcher(const std::vector<std::string>& values) {
+  for (const auto& s : values) {
+    if (s.empty()) {
+      matches_empty_ = true;
+      continue;
+    }
+    const uint32_t size = static_cast<uint32_t>(s.size());
+    min_size_ = (min_size_ == 0) ? size : std::min(min_size_, size);
+    max_size_ = std::max(max_size_, size);
+  }
+
+  by_size_.resize(max_size_ + 1);
+  first_bytes_.resize(max_size_ + 1, std::array<uint64_t, 4>{{0, 0, 0, 0}});
+  for (const auto& s : values) {
+    if (s.empty()) {
+      continue;
+    }
+    auto& bucket = by_size_[s.size()];
+    if (std::find(bucket.begin(), bucket.end(), s) != bucket.end()) {
+      // Duplicate spelling
+      continue;
+    }
+    bucket.push_back(s);
+    const auto c = static_cast<uint8_t>(s[0]);
+    first_bytes_[s.size()][c >> 6] |= uint64_t(1) << (c & 63);
+  }
+}
+
+}  // namespace fwfr
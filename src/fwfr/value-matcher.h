@@ -0,0 +1,84 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_VALUE_MATCHER_H
+#define FWFR_VALUE_MATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arrow/util/macros.h>
+#include <arrow/util/visibility.h>
+
+namespace fwfr {
+
+/// \class ValueMatcher
+/// \brief A small set of fixed spellings (null, true, false values, ...)
+///
+/// Spellings are bucketed by length, and each bucket keeps a bitmap of the
+/// leading bytes it contains.  Most lookups are therefore rejected after a
+/// length check and a single bit test, without touching the spellings.
+class ARROW_EXPORT ValueMatcher {
+ public:
+  ValueMatcher() = default;
+  explicit ValueMatcher(const std::vector<std::string>& values);
+
+  /// \brief Return whether the value is one of the spellings
+  bool Find(const uint8_t* data, uint32_t size) const {
+    if (size == 0) {
+      return matches_empty_;
+    }
+    if (size > max_size_) {
+      return false;
+    }
+    const auto& first_bytes = first_bytes_[size];
+    if (ARROW_PREDICT_TRUE(
+            (first_bytes[data[0] >> 6] & (uint64_t(1) << (data[0] & 63))) == 0)) {
+      return false;
+    }
+    for (const auto& s : by_size_[size]) {
+      if (static_cast<uint8_t>(s[0]) == data[0] &&
+          std::memcmp(s.data() + 1, data + 1, size - 1) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Return whether any spelling can occur in a field of the given width
+  ///
+  /// Values are compared after whitespace trimming, so a spelling matches
+  /// a field if it is no longer than the field.
+  bool CanMatch(uint32_t width) const {
+    return matches_empty_ || (min_size_ > 0 && min_size_ <= width);
+  }
+
+  /// \brief Return whether there are no spellings at all
+  bool empty() const { return !matches_empty_ && min_size_ == 0; }
+
+ protected:
+  // Whether the empty string is a spelling
+  bool matches_empty_ = false;
+  // Sizes of the shortest and longest non-empty spellings (0 if none)
+  uint32_t min_size_ = 0;
+  uint32_t max_size_ = 0;
+  // Non-empty spellings, indexed by size
+  std::vector<std::vector<std::string>> by_size_;
+  // Bitmaps of leading bytes, indexed by size
+  std::vector<std::array<uint64_t, 4>> first_bytes_;
+};
+
+}  // namespace fwfr
+
+#endif  // FWFR_VALUE_MATCHER_H
@@ -0,0 +1,42 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+#ifndef FWFR_WHITESPACE_H
+#define FWFR_WHITESPACE_H
+
+#include <cstdint>
+
+#include <arrow/util/macros.h>
+
+namespace fwfr {
+
+// Whether c is padding around a value (space or tab)
+inline bool IsWhitespace(uint8_t c) {
+  if (ARROW_PREDICT_TRUE(c > ' ')) {
+    return false;
+  }
+  return c == ' ' || c == '\t';
+}
+
+// Strip the padding on both sides of a value
+inline void TrimWhitespace(const uint8_t** data, uint32_t* size) {
+  while (*size > 0 && IsWhitespace((*data)[*size - 1])) {
+    --*size;
+  }
+  while (*size > 0 && IsWhitespace(**data)) {
+    --*size;
+    ++*data;
+  }
+}
+
+}  // namespace fwfr
+
+#endif  // FWFR_WHITESPACE_H
@@ -0,0 +1,804 @@
+/* -*- coding: utf-8 -*-
+ * vim:fenc=utf-8
+ *
+ * Copyright © Her Majesty the Queen in Right of Canada, as represented
+ * by the Minister of Statistics Canada, 2019.
+ *
+ * Written by Kira Noël.
+ *
+ * Distributed under terms of the license.
+ */
+
+// fwfr2parquet: convert a fixed-width file to Parquet.
+//
+// Record batches are streamed from TableReader::ReadStream() into Parquet
+// row groups: blocks are parsed and converted on the thread pool while the
+// previous ones are encoded and written, and only a row group's worth of
+// batches is held in memory at a time.
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fwfr/api.h>
+
+#include <arrow/io/file.h>
+#include <arrow/memory_pool.h>
+#include <arrow/record_batch.h>
+#include <arrow/status.h>
+#include <arrow/table.h>
+#include <arrow/type.h>
+
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+namespace {
+
+static const char kUsage[] =
+    "Usage: fwfr2parquet [OPTION=VALUE]... INPUT OUTPUT\n"
+    "\n"
+    "Convert a fixed-width file to Parquet, streaming record batches into row\n"
+    "groups.  Options are given as --NAME=VALUE, or as the members of a JSON\n"
+    "object in a --config file; VALUE is JSON, or else a plain string.\n"
+    "\n"
+    "  --config=FILE           JSON object of options, applied first\n"
+    "  --copybook=FILE         COBOL copybook giving the field widths, column\n"
+    "                          names, types and numeric formats\n"
+    "  --row_group_size=N      rows per row group (default 1048576)\n"
+    "  --compression=NAME      uncompressed, snappy (default), gzip, brotli,\n"
+    "                          lz4 or zstd\n"
+    "  --memory_stats=BOOL     print the peak memory of each stage of the read\n"
+    "\n"
+    "ReadOptions: encoding, use_threads, block_size, adaptive_block_size,\n"
+    "  min_block_size, output_chunk_rows, decompress, max_parallelism, priority,\n"
+    "  max_memory_bytes, max_recycled_bytes, skip_rows, column_names, predicates\n"
+    "  (e.g. [[\"col\", \"in\", [\"a\", \"b\"]]])\n"
+    "ParseOptions: field_widths, newlines_in_values, ignore_empty_lines,\n"
+    "  skip_columns\n"
+    "ConvertOptions: column_types (e.g. {\"id\": \"int64\"}), is_cobol,\n"
+    "  null_values, true_values, false_values, implied_decimals,\n"
+    "  strings_can_be_null, numeric_encoding, numeric_sign, inference_blocks,\n"
+    "  inference_spill_directory, large_strings, column_options\n"
+    "  (by column name, with the per-column options among the above)\n";
+
+/////////////////////////////////////////////////////////////////////////
+// JSON values, for the configuration
+
+struct Json {
+  enum Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+  Kind kind = NUL;
+  bool boolean = false;
+  double number = 0;
+  std::string string;
+  std::vector<Json> items;
+  std::vector<std::pair<std::string, Json>> members;
+};
+
+class JsonParser {
+ public:
+  explicit JsonParser(const std::string& text) : text_(text) {}
+
+  arrow::Status Parse(Json* out) {
+    RETURN_NOT_OK(ParseValue(out));
+    SkipWhitespace();
+    if (pos_ != text_.size()) {
+      return Error();
+    }
+    return arrow::Status::OK();
+  }
+
+ private:
+  arrow::Status ParseValue(Json* out) {
+    SkipWhitespace();
+    if (pos_ == text_.size()) {
+      return Error();
+    }
+    const char c = text_[pos_];
+    if (c == '{') {
+      return ParseObject(out);
+    } else if (c == '[') {
+      return ParseArray(out);
+    } else if (c == '"') {
+      out->kind = Json::STRING;
+      return ParseString(&out->string);
+    } else if (Consume("true")) {
+      out->kind = Json::BOOL;
+      out->boolean = true;
+    } else if (Consume("false")) {
+      out->kind = Json::BOOL;
+    } else if (Consume("null")) {
+      out->kind = Json::NUL;
+    } else {
+      return ParseNumber(out);
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ParseObject(Json* out) {
+    out->kind = Json::OBJECT;
+    ++pos_;
+    SkipWhitespace();
+    if (Consume("}")) {
+      return arrow::Status::OK();
+    }
+    while (true) {
+      SkipWhitespace();
+      std::pair<std::string, Json> member;
+      if (pos_ == text_.size() || text_[pos_] != '"') {
+        return Error();
+      }
+      RETURN_NOT_OK(ParseString(&member.first));
+      SkipWhitespace();
+      if (!Consume(":")) {
+        return Error();
+      }
+      RETURN_NOT_OK(ParseValue(&member.second));
+      out->members.push_back(std::move(member));
+      SkipWhitespace();
+      if (Consume("}")) {
+        return arrow::Status::OK();
+      }
+      if (!Consume(",")) {
+        return Error();
+      }
+    }
+  }
+
+  arrow::Status ParseArray(Json* out) {
+    out->kind = Json::ARRAY;
+    ++pos_;
+    SkipWhitespace();
+    if (Consume("]")) {
+      return arrow::Status::OK();
+    }
+    while (true) {
+      Json item;
+      RETURN_NOT_OK(ParseValue(&item));
+      out->items.push_back(std::move(item));
+      SkipWhitespace();
+      if (Consume("]")) {
+        return arrow::Status::OK();
+      }
+      if (!Consume(",")) {
+        return Error();
+      }
+    }
+  }
+
+  arrow::Status ParseString(std::string* out) {
+    ++pos_;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\') {
+        if (pos_ == text_.size()) {
+          return Error();
+        }
+        c = text_[pos_++];
+        switch (c) {
+          case 'n':
+            c = '\n';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case '"':
+          case '\\':
+          case '/':
+            break;
+          default:
+            // Unicode escapes and the like: names and spellings are ASCII
+            return arrow::Status::NotImplemented("JSON string escape '\\", c, "'");
+        }
+      }
+      out->push_back(c);
+    }
+    if (!Consume("\"")) {
+      return Error();
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ParseNumber(Json* out) {
+    const char* start = text_.c_str() + pos_;
+    char* end = nullptr;
+    out->kind = Json::NUMBER;
+    out->number = std::strtod(start, &end);
+    if (end == start) {
+      return Error();
+    }
+    pos_ += end - start;
+    return arrow::Status::OK();
+  }
+
+  bool Consume(const char* token) {
+    const std::string t(token);
+    if (text_.compare(pos_, t.size(), t) == 0) {
+      pos_ += t.size();
+      return true;
+    }
+    return false;
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() && std::isspace(static_cast<uint8_t>(text_[pos_]))) {
+      ++pos_;
+    }
+  }
+
+  arrow::Status Error() const {
+    return arrow::Status::Invalid("Invalid JSON at offset ", pos_);
+  }
+
+  const std::string& text_;
+  size_t pos_ = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// Options
+
+struct Options {
+  fwfr::ReadOptions read_options = fwfr::ReadOptions::Defaults();
+  fwfr::ParseOptions parse_options = fwfr::ParseOptions::Defaults();
+  fwfr::ConvertOptions convert_options = fwfr::ConvertOptions::Defaults();
+  int64_t row_group_size = 1 << 20;
+  parquet::Compression::type compression = parquet::Compression::SNAPPY;
+  bool memory_stats = false;
+};
+
+arrow::Status TypeError(const std::string& name, const char* expected) {
+  return arrow::Status::TypeError("Option '", name, "' must be ", expected);
+}
+
+arrow::Status GetBool(const std::string& name, const Json& value, bool* out) {
+  if (value.kind != Json::BOOL) {
+    return TypeError(name, "true or false");
+  }
+  *out = value.boolean;
+  return arrow::Status::OK();
+}
+
+template <typename T>
+arrow::Status GetInt(const std::string& name, const Json& value, T* out) {
+  // Range-check before casting, as casting an out-of-range double is undefined
+  // (max() + 1.0 is a power of two, and exact)
+  const double limit = static_cast<double>(std::numeric_limits<T>::max()) + 1.0;
+  if (value.kind != Json::NUMBER || !(value.number >= 0 && value.number < limit) ||
+      value.number != static_cast<double>(static_cast<T>(value.number))) {
+    return TypeError(name, "a non-negative integer");
+  }
+  *out = static_cast<T>(value.number);
+  return arrow::Status::OK();
+}
+
+arrow::Status GetString(const std::string& name, const Json& value, std::string* out) {
+  if (value.kind != Json::STRING) {
+    return TypeError(name, "a string");
+  }
+  *out = value.string;
+  return arrow::Status::OK();
+}
+
+arrow::Status GetStrings(const std::string& name, const Json& value,
+                         std::vector<std::string>* out) {
+  if (value.kind != Json::ARRAY) {
+    return TypeError(name, "a list of strings");
+  }
+  out->clear();
+  for (const auto& item : value.items) {
+    out->emplace_back();
+    RETURN_NOT_OK(GetString(name, item, &out->back()));
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status GetInts(const std::string& name, const Json& value,
+                      std::vector<uint32_t>* out) {
+  if (value.kind != Json::ARRAY) {
+    return TypeError(name, "a list of integers");
+  }
+  out->clear();
+  for (const auto& item : value.items) {
+    out->emplace_back();
+    RETURN_NOT_OK(GetInt(name, item, &out->back()));
+  }
+  return arrow::Status::OK();
+}
+
+// Type names as printed by Arrow, e.g. "int64", "timestamp[s]",
+// "fixed_size_binary[4]" or "fixed_size_list<int32>[12]"
+arrow::Status ParseType(const std::string& name,
+                        std::shared_ptr<arrow::DataType>* out) {
+  static const std::vector<std::pair<std::string, std::shared_ptr<arrow::DataType>>>
+      kTypes = {{"null", arrow::null()},       {"bool", arrow::boolean()},
+                {"int8", arrow::int8()},       {"int16", arrow::int16()},
+                {"int32", arrow::int32()},     {"int64", arrow::int64()},
+                {"uint8", arrow::uint8()},     {"uint16", arrow::uint16()},
+                {"uint32", arrow::uint32()},   {"uint64", arrow::uint64()},
+                {"float", arrow::float32()},   {"double", arrow::float64()},
+                {"string", arrow::utf8()},     {"binary", arrow::binary()},
+                {"timestamp[s]", arrow::timestamp(arrow::TimeUnit::SECOND)},
+                {"timestamp[ms]", arrow::timestamp(arrow::TimeUnit::MILLI)},
+                {"timestamp[us]", arrow::timestamp(arrow::TimeUnit::MICRO)},
+                {"timestamp[ns]", arrow::timestamp(arrow::TimeUnit::NANO)}};
+  for (const auto& type : kTypes) {
+    if (type.first == name) {
+      *out = type.second;
+      return arrow::Status::OK();
+    }
+  }
+  // Parameterized types end with their width, in brackets
+  const size_t open = name.rfind('[');
+  if (open != std::string::npos && name.back() == ']') {
+    const int32_t width = std::atoi(name.substr(open + 1).c_str());
+    const std::string base = name.substr(0, open);
+    if (width > 0 && base == "fixed_size_binary") {
+      *out = arrow::fixed_size_binary(width);
+      return arrow::Status::OK();
+    }
+    const std::string list_prefix = "fixed_size_list<";
+    if (width > 0 && base.compare(0, list_prefix.size(), list_prefix) == 0 &&
+        base.back() == '>') {
+      std::shared_ptr<arrow::DataType> value_type;
+      RETURN_NOT_OK(ParseType(
+          base.substr(list_prefix.size(), base.size() - list_prefix.size() - 1),
+          &value_type));
+      *out = arrow::fixed_size_list(value_type, width);
+      return arrow::Status::OK();
+    }
+  }
+  return arrow::Status::Invalid("Unknown column type '", name, "'");
+}
+
+arrow::Status GetNumericEncoding(const std::string& name, const Json& value,
+                                 fwfr::NumericFormat::Encoding* out) {
+  static const std::vector<std::pair<std::string, fwfr::NumericFormat::Encoding>>
+      kEncodings = {{"text", fwfr::NumericFormat::TEXT},
+                    {"zoned", fwfr::NumericFormat::ZONED},
+                    {"binary", fwfr::NumericFormat::BINARY},
+                    {"packed", fwfr::NumericFormat::PACKED}};
+  for (const auto& encoding : kEncodings) {
+    if (value.kind == Json::STRING && value.string == encoding.first) {
+      *out = encoding.second;
+      return arrow::Status::OK();
+    }
+  }
+  return TypeError(name, "one of 'text', 'zoned', 'binary' or 'packed'");
+}
+
+arrow::Status GetNumericSign(const std::string& name, const Json& value,
+                             fwfr::NumericFormat::Sign* out) {
+  static const std::vector<std::pair<std::string, fwfr::NumericFormat::Sign>> kSigns =
+      {{"unsigned", fwfr::NumericFormat::UNSIGNED},
+       {"trailing", fwfr::NumericFormat::TRAILING},
+       {"leading", fwfr::NumericFormat::LEADING},
+       {"trailing_separate", fwfr::NumericFormat::TRAILING_SEPARATE},
+       {"leading_separate", fwfr::NumericFormat::LEADING_SEPARATE}};
+  for (const auto& sign : kSigns) {
+    if (value.kind == Json::STRING && value.string == sign.first) {
+      *out = sign.second;
+      return arrow::Status::OK();
+    }
+  }
+  return TypeError(name, "one of 'unsigned', 'trailing', 'leading', "
+                         "'trailing_separate' or 'leading_separate'");
+}
+
+arrow::Status GetPriority(const std::string& name, const Json& value,
+                          fwfr::ReadOptions::Priority* out) {
+  static const std::vector<std::pair<std::string, fwfr::ReadOptions::Priority>>
+      kPriorities = {{"high", fwfr::ReadOptions::HIGH},
+                     {"normal", fwfr::ReadOptions::NORMAL},
+                     {"low", fwfr::ReadOptions::LOW}};
+  for (const auto& priority : kPriorities) {
+    if (value.kind == Json::STRING && value.string == priority.first) {
+      *out = priority.second;
+      return arrow::Status::OK();
+    }
+  }
+  return TypeError(name, "one of 'high', 'normal' or 'low'");
+}
+
+// Predicates as (column, op, value) lists, as in the Python bindings
+arrow::Status GetPredicate(const std::string& name, const Json& value,
+                           fwfr::Predicate* out) {
+  if (value.kind != Json::ARRAY || value.items.size() != 3) {
+    return TypeError(name, "a list of [column, op, value] lists");
+  }
+  std::string op;
+  RETURN_NOT_OK(GetString(name, value.items[0], &out->column));
+  RETURN_NOT_OK(GetString(name, value.items[1], &op));
+  const Json& operand = value.items[2];
+  if (op == "==") {
+    out->kind = fwfr::Predicate::EQUAL;
+    out->values.emplace_back();
+    return GetString(name, operand, &out->values.back());
+  } else if (op == "in") {
+    out->kind = fwfr::Predicate::IN;
+    return GetStrings(name, operand, &out->values);
+  } else if (op == "startswith") {
+    out->kind = fwfr::Predicate::PREFIX;
+    out->values.emplace_back();
+    return GetString(name, operand, &out->values.back());
+  }
+  out->kind = fwfr::Predicate::RANGE;
+  if (op == ">=" && operand.kind == Json::NUMBER) {
+    out->min = operand.number;
+  } else if (op == "<=" && operand.kind == Json::NUMBER) {
+    out->max = operand.number;
+  } else if (op == "between" && operand.kind == Json::ARRAY &&
+             operand.items.size() == 2 && operand.items[0].kind == Json::NUMBER &&
+             operand.items[1].kind == Json::NUMBER) {
+    out->min = operand.items[0].number;
+    out->max = operand.items[1].number;
+  } else {
+    return arrow::Status::Invalid("Invalid predicate operator '", op, "' or operand");
+  }
+  return arrow::Status::OK();
+}
+
+// Options that can also be given per column
+arrow::Status ApplyColumnOption(const std::string& name, const Json& value,
+                                fwfr::ColumnConvertOptions* out, bool* found) {
+  *found = true;
+  if (name == "is_cobol") {
+    return GetBool(name, value, &out->is_cobol);
+  } else if (name == "null_values") {
+    return GetStrings(name, value, &out->null_values);
+  } else if (name == "true_values") {
+    return GetStrings(name, value, &out->true_values);
+  } else if (name == "false_values") {
+    return GetStrings(name, value, &out->false_values);
+  } else if (name == "implied_decimals") {
+    return GetInt(name, value, &out->implied_decimals);
+  } else if (name == "strings_can_be_null") {
+    return GetBool(name, value, &out->strings_can_be_null);
+  } else if (name == "numeric_encoding") {
+    return GetNumericEncoding(name, value, &out->numeric_format.encoding);
+  } else if (name == "numeric_sign") {
+    return GetNumericSign(name, value, &out->numeric_format.sign);
+  }
+  *found = false;
+  return arrow::Status::OK();
+}
+
+arrow::Status ApplyOption(const std::string& name, const Json& value, Options* out) {
+  fwfr::ReadOptions& read_options = out->read_options;
+  fwfr::ParseOptions& parse_options = out->parse_options;
+  fwfr::ConvertOptions& convert_options = out->convert_options;
+
+  // ReadOptions
+  if (name == "encoding") {
+    return GetString(name, value, &read_options.encoding);
+  } else if (name == "use_threads") {
+    return GetBool(name, value, &read_options.use_threads);
+  } else if (name == "block_size") {
+    return GetInt(name, value, &read_options.block_size);
+  } else if (name == "adaptive_block_size") {
+    return GetBool(name, value, &read_options.adaptive_block_size);
+  } else if (name == "min_block_size") {
+    return GetInt(name, value, &read_options.min_block_size);
+  } else if (name == "output_chunk_rows") {
+    return GetInt(name, value, &read_options.output_chunk_rows);
+  } else if (name == "decompress") {
+    return GetBool(name, value, &read_options.decompress);
+  } else if (name == "max_parallelism") {
+    return GetInt(name, value, &read_options.max_parallelism);
+  } else if (name == "priority") {
+    return GetPriority(name, value, &read_options.priority);
+  } else if (name == "max_memory_bytes") {
+    return GetInt(name, value, &read_options.max_memory_bytes);
+  } else if (name == "max_recycled_bytes") {
+    return GetInt(name, value, &read_options.max_recycled_bytes);
+  } else if (name == "skip_rows") {
+    return GetInt(name, value, &read_options.skip_rows);
+  } else if (name == "column_names") {
+    return GetStrings(name, value, &read_options.column_names);
+  } else if (name == "predicates") {
+    if (value.kind != Json::ARRAY) {
+      return TypeError(name, "a list of [column, op, value] lists");
+    }
+    read_options.predicates.clear();
+    for (const auto& item : value.items) {
+      read_options.predicates.emplace_back();
+      RETURN_NOT_OK(GetPredicate(name, item, &read_options.predicates.back()));
+    }
+    return arrow::Status::OK();
+  }
+
+  // ParseOptions
+  if (name == "field_widths") {
+    return GetInts(name, value, &parse_options.field_widths);
+  } else if (name == "newlines_in_values") {
+    return GetBool(name, value, &parse_options.newlines_in_values);
+  } else if (name == "ignore_empty_lines") {
+    return GetBool(name, value, &parse_options.ignore_empty_lines);
+  } else if (name == "skip_columns") {
+    return GetInts(name, value, &parse_options.skip_columns);
+  }
+
+  // ConvertOptions
+  if (name == "column_types") {
+    if (value.kind != Json::OBJECT) {
+      return TypeError(name, "an object of type names by column name");
+    }
+    for (const auto& member : value.members) {
+      std::string type_name;
+      RETURN_NOT_OK(GetString(name, member.second, &type_name));
+      RETURN_NOT_OK(ParseType(type_name, &convert_options.column_types[member.first]));
+    }
+    return arrow::Status::OK();
+  } else if (name == "column_options") {
+    if (value.kind != Json::OBJECT) {
+      return TypeError(name, "an object of options by column name");
+    }
+    for (const auto& column : value.members) {
+      if (column.second.kind != Json::OBJECT) {
+        return TypeError(name, "an object of options by column name");
+      }
+      auto it = convert_options.column_options.find(column.first);
+      if (it == convert_options.column_options.end()) {
+        it = convert_options.column_options
+                 .emplace(column.first, fwfr::ColumnConvertOptions::Defaults())
+                 .first;
+      }
+      for (const auto& member : column.second.members) {
+        bool found;
+        RETURN_NOT_OK(ApplyColumnOption(member.first, member.second, &it->second,
+                                        &found));
+        if (!found) {
+          return arrow::Status::KeyError("Unknown column option '", member.first, "'");
+        }
+      }
+    }
+    return arrow::Status::OK();
+  } else if (name == "inference_blocks") {
+    return GetInt(name, value, &convert_options.inference_blocks);
+  } else if (name == "inference_spill_directory") {
+    return GetString(name, value, &convert_options.inference_spill_directory);
+  } else if (name == "large_strings") {
+    return GetBool(name, value, &convert_options.large_strings);
+  }
+  // The per-column options, applied to all columns
+  fwfr::ColumnConvertOptions column_options;
+  column_options.is_cobol = convert_options.is_cobol;
+  column_options.null_values = convert_options.null_values;
+  column_options.true_values = convert_options.true_values;
+  column_options.false_values = convert_options.false_values;
+  column_options.implied_decimals = convert_options.implied_decimals;
+  column_options.strings_can_be_null = convert_options.strings_can_be_null;
+  column_options.numeric_format = convert_options.numeric_format;
+  bool found;
+  RETURN_NOT_OK(ApplyColumnOption(name, value, &column_options, &found));
+  if (found) {
+    convert_options.is_cobol = column_options.is_cobol;
+    convert_options.null_values = column_options.null_values;
+    convert_options.true_values = column_options.true_values;
+    convert_options.false_values = column_options.false_values;
+    convert_options.implied_decimals = column_options.implied_decimals;
+    convert_options.strings_can_be_null = column_options.strings_can_be_null;
+    convert_options.numeric_format = column_options.numeric_format;
+    return arrow::Status::OK();
+  }
+
+  // Output
+  if (name == "row_group_size") {
+    RETURN_NOT_OK(GetInt(name, value, &out->row_group_size));
+    if (out->row_group_size == 0) {
+      return TypeError(name, "a positive integer");
+    }
+    return arrow::Status::OK();
+  } else if (name == "compression") {
+    static const std::vector<std::pair<std::string, parquet::Compression::type>>
+        kCompressions = {{"uncompressed", parquet::Compression::UNCOMPRESSED},
+                         {"snappy", parquet::Compression::SNAPPY},
+                         {"gzip", parquet::Compression::GZIP},
+                         {"brotli", parquet::Compression::BROTLI},
+                         {"lz4", parquet::Compression::LZ4},
+                         {"zstd", parquet::Compression::ZSTD}};
+    for (const auto& compression : kCompressions) {
+      if (value.kind == Json::STRING && value.string == compression.first) {
+        out->compression = compression.second;
+        return arrow::Status::OK();
+      }
+    }
+    return TypeError(name, "one of 'uncompressed', 'snappy', 'gzip', 'brotli', "
+                           "'lz4' or 'zstd'");
+  } else if (name == "memory_stats") {
+    return GetBool(name, value, &out->memory_stats);
+  }
+  return arrow::Status::KeyError("Unknown option '", name, "'");
+}
+
+arrow::Status ReadFile(const std::string& path, std::string* out) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return arrow::Status::IOError("Could not open '", path, "'");
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  *out = ss.str();
+  return arrow::Status::OK();
+}
+
+// Gather the options of the config file then of the command line, with a
+// copybook applied before all others
+arrow::Status MakeOptions(const std::vector<std::pair<std::string, std::string>>& args,
+                          Options* out) {
+  std::vector<std::pair<std::string, Json>> options;
+  for (const auto& arg : args) {
+    Json value;
+    JsonParser parser(arg.second);
+    if (!parser.Parse(&value).ok()) {
+      // A plain string
+      value = Json();
+      value.kind = Json::STRING;
+      value.string = arg.second;
+    }
+    if (arg.first == "config") {
+      std::string config;
+      RETURN_NOT_OK(GetString(arg.first, value, &config));
+      RETURN_NOT_OK(ReadFile(config, &config));
+      Json members;
+      RETURN_NOT_OK(JsonParser(config).Parse(&members));
+      if (members.kind != Json::OBJECT) {
+        return arrow::Status::Invalid("The config file must hold a JSON object");
+      }
+      options.insert(options.begin(), members.members.begin(), members.members.end());
+    } else {
+      options.emplace_back(arg.first, value);
+    }
+  }
+
+  for (const auto& option : options) {
+    if (option.first == "copybook") {
+      std::string source;
+      RETURN_NOT_OK(GetString(option.first, option.second, &source));
+      RETURN_NOT_OK(ReadFile(source, &source));
+      fwfr::Copybook copybook;
+      RETURN_NOT_OK(fwfr::CompileCopybook(source, &copybook));
+      out->parse_options = copybook.parse_options;
+      out->read_options.column_names = copybook.column_names;
+      out->convert_options = copybook.convert_options;
+    }
+  }
+  for (const auto& option : options) {
+    if (option.first != "copybook") {
+      RETURN_NOT_OK(ApplyOption(option.first, option.second, out));
+    }
+  }
+  return arrow::Status::OK();
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Conversion
+
+// Write the first row_group_size rows of batches (all of them if fewer) as
+// one row group, and leave the rest in batches
+arrow::Status WriteRowGroup(parquet::arrow::FileWriter* writer,
+                            const std::shared_ptr<arrow::Schema>& schema,
+                            std::vector<std::shared_ptr<arrow::RecordBatch>>* batches,
+                            int64_t row_group_size) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> group;
+  int64_t num_rows = 0;
+  size_t i = 0;
+  for (; i < batches->size() && num_rows < row_group_size; ++i) {
+    const std::shared_ptr<arrow::RecordBatch> batch = (*batches)[i];
+    const int64_t rest = row_group_size - num_rows;
+    if (batch->num_rows() > rest) {
+      // Carry the batch's other rows into the next row group
+      group.push_back(batch->Slice(0, rest));
+      (*batches)[i] = batch->Slice(rest);
+      break;
+    }
+    group.push_back(batch);
+    num_rows += batch->num_rows();
+  }
+  batches->erase(batches->begin(), batches->begin() + i);
+
+  std::shared_ptr<arrow::Table> table;
+  RETURN_NOT_OK(arrow::Table::FromRecordBatches(schema, group, &table));
+  return writer->WriteTable(*table, row_group_size);
+}
+
+arrow::Status Convert(const Options& options, const std::string& input_path,
+                      const std::string& output_path) {
+  arrow::MemoryPool* pool = arrow::default_memory_pool();
+
+  std::shared_ptr<arrow::io::ReadableFile> input;
+  RETURN_NOT_OK(arrow::io::ReadableFile::Open(input_path, pool, &input));
+  std::shared_ptr<fwfr::TableReader> reader;
+  RETURN_NOT_OK(fwfr::TableReader::Make(pool, input, options.read_options,
+                                        options.parse_options, options.convert_options,
+                                        &reader));
+  std::shared_ptr<arrow::RecordBatchReader> stream;
+  RETURN_NOT_OK(reader->ReadStream(&stream));
+  const std::shared_ptr<arrow::Schema> schema = stream->schema();
+
+  std::shared_ptr<arrow::io::OutputStream> output;
+  RETURN_NOT_OK(arrow::io::FileOutputStream::Open(output_path, &output));
+  parquet::WriterProperties::Builder properties;
+  properties.compression(options.compression);
+  std::unique_ptr<parquet::arrow::FileWriter> writer;
+  RETURN_NOT_OK(parquet::arrow::FileWriter::Open(
+      *schema, pool, output, properties.build(),
+      parquet::default_arrow_writer_properties(), &writer));
+
+  // The next blocks are converted while a row group is encoded and written
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  int64_t num_rows = 0;
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    RETURN_NOT_OK(stream->ReadNext(&batch));
+    if (!batch) {
+      break;
+    }
+    batches.push_back(batch);
+    num_rows += batch->num_rows();
+    while (num_rows >= options.row_group_size) {
+      RETURN_NOT_OK(
+          WriteRowGroup(writer.get(), schema, &batches, options.row_group_size));
+      num_rows -= options.row_group_size;
+    }
+  }
+  if (!batches.empty()) {
+    RETURN_NOT_OK(WriteRowGroup(writer.get(), schema, &batches, options.row_group_size));
+  }
+  RETURN_NOT_OK(writer->Close());
+  if (options.memory_stats) {
+    const fwfr::ReadMemoryStats stats = reader->memory_stats();
+    std::cerr << "peak memory: readahead " << stats.readahead.max_memory << ", parse "
+              << stats.parse.max_memory << ", convert " << stats.convert.max_memory
+              << ", output " << stats.output.max_memory << ", budget "
+              << stats.budget.max_memory << " bytes" << std::endl;
+  }
+  return output->Close();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::pair<std::string, std::string>> args;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+    const size_t equals = arg.find('=');
+    if (arg.compare(0, 2, "--") == 0 && equals != std::string::npos) {
+      args.emplace_back(arg.substr(2, equals - 2), arg.substr(equals + 1));
+    } else if (arg.compare(0, 2, "--") != 0) {
+      paths.push_back(arg);
+    } else {
+      std::cerr << "fwfr2parquet: option " << arg << " needs a value\n\n" << kUsage;
+      return 2;
+    }
+  }
+  if (paths.size() != 2) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  Options options;
+  arrow::Status status = MakeOptions(args, &options);
+  if (status.ok()) {
+    status = Convert(options, paths[0], paths[1]);
+  }
+  if (!status.ok()) {
+    std::cerr << "fwfr2parquet: " << status.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}